@@ -0,0 +1,151 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Spectral envelope on a reduced set of mel-spaced bands.
+     *
+     * The magnitude spectrum is projected onto numBands overlapping triangular bands
+     * (a sparse matrix stored as one weight run per band) and smoothed across bands in
+     * the log domain. Formant structure survives at this resolution, so detection and
+     * warping can run on numBands values instead of fftSize / 2 + 1 bins; only the final
+     * curves are interpolated back to bins.
+     *
+     * Band b is centred at melToHz((b + 1) * melStep), so the fractional band index of any
+     * frequency is closed-form (hzToBand / bandToHz).
+     */
+    class BandEnvelope
+    {
+    public:
+        static constexpr int numBands = 48;
+
+        BandEnvelope() = default;
+
+        void prepare(int fftSize, double sampleRate)
+        {
+            const int numBins = fftSize / 2 + 1;
+            hzPerBin = (float)sampleRate / (float)fftSize;
+            melStep = hzToMel((float)sampleRate * 0.5f) / (float)(numBands + 1);
+
+            bandFirstBin.assign((size_t)numBands, 0);
+            bandWeightOffset.assign((size_t)numBands + 1, 0);
+            weights.clear();
+
+            for (int b = 0; b < numBands; ++b)
+            {
+                const float centreHz = bandToHz((float)b);
+
+                // Triangle between the neighbouring centres, but never narrower than two
+                // harmonics of a high voice so the bands do not resolve the pitch.
+                const float lowerHz = std::min(bandToHz((float)b - 1.0f), centreHz - minHalfWidthHz);
+                const float upperHz = std::max(bandToHz((float)b + 1.0f), centreHz + minHalfWidthHz);
+
+                const int first = juce::jlimit(0, numBins - 1, (int)std::ceil(std::max(0.0f, lowerHz) / hzPerBin));
+                const int last = juce::jlimit(first, numBins - 1, (int)std::floor(upperHz / hzPerBin));
+
+                bandFirstBin[(size_t)b] = first;
+                const size_t runStart = weights.size();
+                float sum = 0.0f;
+                for (int k = first; k <= last; ++k)
+                {
+                    const float hz = (float)k * hzPerBin;
+                    const float w = hz <= centreHz ? (hz - lowerHz) / (centreHz - lowerHz)
+                                                   : (upperHz - hz) / (upperHz - centreHz);
+                    weights.push_back(std::max(0.0f, w));
+                    sum += weights.back();
+                }
+
+                // Normalised to a weighted mean of the bin powers
+                const float invSum = sum > 0.0f ? 1.0f / sum : 0.0f;
+                for (size_t i = runStart; i < weights.size(); ++i)
+                    weights[i] *= invSum;
+
+                bandWeightOffset[(size_t)b + 1] = (int)weights.size();
+            }
+
+            binBand.resize((size_t)numBins);
+            for (int k = 0; k < numBins; ++k)
+                binBand[(size_t)k] = hzToBand((float)k * hzPerBin);
+
+            logBands.resize((size_t)numBands);
+        }
+
+        /** Magnitude spectrum (fftSize / 2 + 1 bins) -> smoothed band envelope (numBands values). */
+        void project(const std::vector<float> &magnitudeSpectrum, std::vector<float> &bandEnvelope)
+        {
+            for (int b = 0; b < numBands; ++b)
+            {
+                const float *w = weights.data() + bandWeightOffset[(size_t)b];
+                const float *mag = magnitudeSpectrum.data() + bandFirstBin[(size_t)b];
+                const int count = bandWeightOffset[(size_t)b + 1] - bandWeightOffset[(size_t)b];
+
+                float power = 0.0f;
+                for (int i = 0; i < count; ++i)
+                    power += w[i] * mag[i] * mag[i];
+
+                logBands[(size_t)b] = 0.5f * std::log(std::max(power, 1.0e-18f));
+            }
+
+            // [1 2 1] / 4 across bands in the log domain (edges reflected)
+            float previous = logBands[0];
+            for (int b = 0; b < numBands; ++b)
+            {
+                const float current = logBands[(size_t)b];
+                const float next = b + 1 < numBands ? logBands[(size_t)b + 1] : current;
+                bandEnvelope[(size_t)b] = std::exp(juce::jlimit(-20.0f, 20.0f, 0.25f * (previous + 2.0f * current + next)));
+                previous = current;
+            }
+        }
+
+        /** Band values -> bins, linear between band centres (held below the first and above the last). */
+        void expandToBins(const std::vector<float> &bandValues, std::vector<float> &binValues) const
+        {
+            const size_t size = std::min(binValues.size(), binBand.size());
+            for (size_t k = 0; k < size; ++k)
+            {
+                const float position = binBand[k];
+                const int b0 = (int)position;
+                const int b1 = std::min(b0 + 1, numBands - 1);
+                const float frac = position - (float)b0;
+                binValues[k] = bandValues[(size_t)b0] + frac * (bandValues[(size_t)b1] - bandValues[(size_t)b0]);
+            }
+        }
+
+        /** Fractional band index of a frequency, clamped to [0, numBands - 1]. */
+        float hzToBand(float hz) const
+        {
+            return juce::jlimit(0.0f, (float)(numBands - 1), hzToMel(hz) / melStep - 1.0f);
+        }
+
+        float bandToHz(float band) const { return melToHz((band + 1.0f) * melStep); }
+
+        float binToBand(float bin) const { return hzToBand(bin * hzPerBin); }
+
+        float bandToBin(float band) const { return bandToHz(band) / hzPerBin; }
+
+    private:
+        static float hzToMel(float hz) { return 2595.0f * std::log10(1.0f + std::max(0.0f, hz) / 700.0f); }
+        static float melToHz(float mel) { return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f); }
+
+        static constexpr float minHalfWidthHz = 200.0f;
+
+        float hzPerBin = 44100.0f / 1024.0f;
+        float melStep = 1.0f;
+
+        // Sparse projection: band b uses weights[bandWeightOffset[b] .. bandWeightOffset[b + 1])
+        // on the bins starting at bandFirstBin[b].
+        std::vector<int> bandFirstBin;
+        std::vector<int> bandWeightOffset;
+        std::vector<float> weights;
+
+        std::vector<float> binBand; // Fractional band index of every bin
+        std::vector<float> logBands;
+    };
+
+} // namespace dsp
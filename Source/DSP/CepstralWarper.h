@@ -0,0 +1,228 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Frequency warping of a liftered cepstral envelope, done on its coefficients.
+     *
+     * The envelope is a short cosine series, log E(k) = sum_q c[q] cos(pi q k / H) with
+     * H = numBins - 1. Warping the frequency axis with a map phi (output bin -> source bin,
+     * as built by FormantWarper) is linear in c:
+     *
+     *     c'[p] = sum_q M[p][q] c[q],  M[p][q] = (norm_p / H) sum_k w_k cos(pi p k / H) cos(pi q phi(k) / H)
+     *
+     * (trapezoidal weights w_k, norm_p = 1 for p = 0 and 2 otherwise). The projection keeps the
+     * warped envelope at the same quefrency resolution as the input, so it stays smooth.
+     *
+     * Building M costs numBins * order^2 and is cached: a new map that stays within
+     * mapTolerance bins of the cached one reuses it. Per hop the warp is then a single
+     * order x order multiply, and the warped curve is evaluated from its coefficients on a
+     * grid of every getGridStep() bins (at least minPointsPerPeriod points per period of the
+     * highest quefrency) and filled in with Catmull-Rom interpolation, instead of summing
+     * `order` cosines at every bin.
+     */
+    class CepstralWarper
+    {
+    public:
+        /**
+         * A map change below this (in bins, everywhere) keeps the cached matrix. Detected
+         * formants are whole bins, so a formant stepping by one bin does not force a rebuild.
+         */
+        static constexpr float mapTolerance = 1.5f;
+
+        /**
+         * Grid density for evaluate(). At 8 points per period Catmull-Rom is within about 1 % of
+         * the highest quefrency's amplitude; the curves are dominated by far lower ones.
+         */
+        static constexpr int minPointsPerPeriod = 8;
+
+        CepstralWarper() = default;
+
+        void prepare(int newNumBins, int newOrder)
+        {
+            numBins = newNumBins;
+            order = newOrder;
+
+            const float piOverH = juce::MathConstants<float>::pi / (float)(numBins - 1);
+            cosTable.resize((size_t)(order * numBins));
+            for (int q = 0; q < order; ++q)
+                for (int k = 0; k < numBins; ++k)
+                    cosTable[(size_t)(q * numBins + k)] = std::cos(piOverH * (float)(q * k));
+
+            matrix.assign((size_t)(order * order), 0.0f);
+            cachedMap.clear();
+            warpedBasis.resize((size_t)order);
+
+            // Largest power-of-two step that divides H and keeps minPointsPerPeriod points on
+            // the shortest period, 2H / (order - 1) bins.
+            const int h = numBins - 1;
+            gridStep = 1;
+            while (h % (gridStep * 2) == 0 && gridStep * 2 * (order - 1) * minPointsPerPeriod <= 2 * h)
+                gridStep *= 2;
+
+            numGridPoints = h / gridStep + 1;
+            gridTable.resize((size_t)(order * numGridPoints));
+            for (int q = 0; q < order; ++q)
+                for (int g = 0; g < numGridPoints; ++g)
+                    gridTable[(size_t)(q * numGridPoints + g)] = cosTable[(size_t)(q * numBins + g * gridStep)];
+
+            // Catmull-Rom weights of the four neighbouring grid values, per offset inside a cell
+            interpolationWeights.resize((size_t)(4 * gridStep));
+            for (int j = 0; j < gridStep; ++j)
+            {
+                const float t = (float)j / (float)gridStep;
+                const float t2 = t * t;
+                const float t3 = t2 * t;
+                float *w = interpolationWeights.data() + 4 * j;
+                w[0] = 0.5f * (-t3 + 2.0f * t2 - t);
+                w[1] = 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+                w[2] = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+                w[3] = 0.5f * (t3 - t2);
+            }
+            gridValues.resize((size_t)numGridPoints + 2);
+        }
+
+        /**
+         * Makes the matrix match a warp map (numBins source positions, one per output bin).
+         * @return true if the matrix was rebuilt, false if the cached one was close enough.
+         */
+        bool setWarpMap(const std::vector<float> &warpMap)
+        {
+            jassert((int)warpMap.size() == numBins);
+
+            if (cachedMap.size() == warpMap.size())
+            {
+                float maxDelta = 0.0f;
+                for (size_t k = 0; k < warpMap.size(); ++k)
+                    maxDelta = std::max(maxDelta, std::abs(warpMap[k] - cachedMap[k]));
+
+                if (maxDelta < mapTolerance)
+                    return false;
+            }
+
+            cachedMap = warpMap;
+            std::fill(matrix.begin(), matrix.end(), 0.0f);
+
+            const int h = numBins - 1;
+            const float piOverH = juce::MathConstants<float>::pi / (float)h;
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                // cos(q * theta) for all q by the Chebyshev recursion, one cos per bin
+                const float c1 = std::cos(piOverH * warpMap[(size_t)k]);
+                warpedBasis[0] = 1.0f;
+                if (order > 1)
+                    warpedBasis[1] = c1;
+                for (int q = 2; q < order; ++q)
+                    warpedBasis[(size_t)q] = 2.0f * c1 * warpedBasis[(size_t)q - 1] - warpedBasis[(size_t)q - 2];
+
+                const float weight = (k == 0 || k == h) ? 0.5f : 1.0f;
+                for (int p = 0; p < order; ++p)
+                {
+                    const float wp = weight * cosTable[(size_t)(p * numBins + k)];
+                    float *row = matrix.data() + p * order;
+                    for (int q = 0; q < order; ++q)
+                        row[q] += wp * warpedBasis[(size_t)q];
+                }
+            }
+
+            for (int p = 0; p < order; ++p)
+            {
+                const float norm = (p == 0 ? 1.0f : 2.0f) / (float)h;
+                for (int q = 0; q < order; ++q)
+                    matrix[(size_t)(p * order + q)] *= norm;
+            }
+
+            return true;
+        }
+
+        /** Coefficients of the warped envelope (both vectors hold `order` values). */
+        void warp(const std::vector<float> &cepstrum, std::vector<float> &warpedCepstrum) const
+        {
+            for (int p = 0; p < order; ++p)
+            {
+                const float *row = matrix.data() + p * order;
+                float sum = 0.0f;
+                for (int q = 0; q < order; ++q)
+                    sum += row[q] * cepstrum[(size_t)q];
+                warpedCepstrum[(size_t)p] = sum;
+            }
+        }
+
+        /**
+         * Log curve of a cosine series at every bin (e.g. the warped minus the original
+         * coefficients), summed on the grid and interpolated in between.
+         */
+        void evaluate(const std::vector<float> &coefficients, std::vector<float> &logCurve)
+        {
+            if (gridStep == 1)
+            {
+                evaluateExact(coefficients, logCurve);
+                return;
+            }
+
+            // gridValues[g + 1] is grid point g; one mirrored point on each side, as the series is
+            // even around bin 0 and bin H.
+            std::fill(gridValues.begin(), gridValues.end(), 0.0f);
+            for (int q = 0; q < order; ++q)
+            {
+                const float c = coefficients[(size_t)q];
+                const float *basis = gridTable.data() + q * numGridPoints;
+                for (int g = 0; g < numGridPoints; ++g)
+                    gridValues[(size_t)g + 1] += c * basis[g];
+            }
+            gridValues.front() = gridValues[2];
+            gridValues.back() = gridValues[(size_t)numGridPoints - 1];
+
+            for (int g = 0; g < numGridPoints - 1; ++g)
+            {
+                const float *p = gridValues.data() + g;
+                float *out = logCurve.data() + g * gridStep;
+                for (int j = 0; j < gridStep; ++j)
+                {
+                    const float *w = interpolationWeights.data() + 4 * j;
+                    out[j] = w[0] * p[0] + w[1] * p[1] + w[2] * p[2] + w[3] * p[3];
+                }
+            }
+            logCurve[(size_t)numBins - 1] = gridValues[(size_t)numGridPoints];
+        }
+
+        /** Reference for evaluate(): the series summed at every bin. */
+        void evaluateExact(const std::vector<float> &coefficients, std::vector<float> &logCurve) const
+        {
+            std::fill(logCurve.begin(), logCurve.begin() + numBins, 0.0f);
+            for (int q = 0; q < order; ++q)
+            {
+                const float c = coefficients[(size_t)q];
+                const float *basis = cosTable.data() + q * numBins;
+                for (int k = 0; k < numBins; ++k)
+                    logCurve[(size_t)k] += c * basis[k];
+            }
+        }
+
+        int getOrder() const { return order; }
+        int getGridStep() const { return gridStep; }
+
+    private:
+        int numBins = 0;
+        int order = 0;
+
+        std::vector<float> cosTable;    // cos(pi q k / H), row q
+        std::vector<float> matrix;      // order x order, row-major
+        std::vector<float> cachedMap;   // Map the matrix was built for
+        std::vector<float> warpedBasis; // Scratch: cos(q theta) for one bin
+
+        int gridStep = 1;
+        int numGridPoints = 0;
+        std::vector<float> gridTable;            // cos(pi q g step / H), row q
+        std::vector<float> interpolationWeights; // 4 per offset inside a grid cell
+        std::vector<float> gridValues;           // Scratch: curve on the grid plus mirrored ends
+    };
+
+} // namespace dsp
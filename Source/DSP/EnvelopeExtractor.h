@@ -31,6 +31,8 @@ namespace dsp
     class EnvelopeExtractor
     {
     public:
+        static constexpr int defaultCutoffBin = 30;
+
         EnvelopeExtractor() {}
 
         /**
@@ -46,6 +48,7 @@ namespace dsp
             // Buffers for in-place transforms
             // JUCE FFT operations often require 2x size for complex numbers if not using specific real-only buffers effectively
             frequencyDomainBuffer.resize((size_t)fftSize * 2);
+            rawCepstrum.resize((size_t)fftSize / 2);
         }
 
         /**
@@ -55,7 +58,7 @@ namespace dsp
          * @param envelope Output envelope (size = fftSize / 2 + 1).
          * @param cutoffBin The quefrency bin cutoff for liftering. Lower values = smoother envelope.
          */
-        void process(const std::vector<float> &magnitudeSpectrum, std::vector<float> &envelope, int cutoffBin = 30)
+        void process(const std::vector<float> &magnitudeSpectrum, std::vector<float> &envelope, int cutoffBin = defaultCutoffBin)
         {
             int n = fftSize;
             int halfN = n / 2 + 1;
@@ -75,6 +78,9 @@ namespace dsp
             // 2. IFFT to get Cepstrum
             forwardFFT->performRealOnlyInverseTransform(frequencyDomainBuffer.data());
 
+            // Keep the un-liftered half for pitch estimation (the harmonic peak lives above the cutoff).
+            std::copy(frequencyDomainBuffer.begin(), frequencyDomainBuffer.begin() + n / 2, rawCepstrum.begin());
+
             // 3. Liftering (Low-pass filter in Quefrency domain)
             //    Keep only the first 'cutoffBin' coefficients and the symmetric tail.
             for (int i = cutoffBin; i < n - cutoffBin; ++i)
@@ -82,6 +88,16 @@ namespace dsp
                 frequencyDomainBuffer[(size_t)i] = 0.0f;
             }
 
+            // The liftered cepstrum as a cosine series: log envelope[k] = sum_q c[q] cos(pi q k / (n/2)).
+            // Quefrencies 1..cutoffBin-1 are kept on both sides (weight 2); the lifter above also keeps
+            // n - cutoffBin but not cutoffBin itself, so that one contributes with weight 1.
+            envelopeCepstrum.resize((size_t)cutoffBin + 1);
+            for (int q = 0; q <= cutoffBin; ++q)
+            {
+                const float weight = (q == 0 || q == cutoffBin) ? 1.0f : 2.0f;
+                envelopeCepstrum[(size_t)q] = frequencyDomainBuffer[(size_t)(q == cutoffBin ? n - q : q)] * weight / (float)n;
+            }
+
             // 4. FFT back to Frequency Domain
             forwardFFT->performRealOnlyForwardTransform(frequencyDomainBuffer.data());
 
@@ -99,10 +115,106 @@ namespace dsp
             }
         }
 
+        /** Cosine-series coefficients of the last log envelope (cutoffBin + 1 values, see process()). */
+        const std::vector<float> &getEnvelopeCepstrum() const { return envelopeCepstrum; }
+
+        /**
+         * The last log envelope as a continuous function of frequency, evaluated from its
+         * cepstral coefficients (no bin grid involved).
+         *
+         * @param bin       Fractional bin (0 .. fftSize / 2).
+         * @param slope     Receives d/dbin of the log envelope.
+         * @param curvature Receives d2/dbin2 of the log envelope.
+         * @return The natural log of the envelope at `bin`.
+         */
+        float evaluateLogEnvelope(float bin, float &slope, float &curvature) const
+        {
+            return evaluateLogEnvelope(envelopeCepstrum, fftSize, bin, slope, curvature);
+        }
+
+        /** Same as above for any set of coefficients in the getEnvelopeCepstrum() form (e.g. an average). */
+        static float evaluateLogEnvelope(const std::vector<float> &cepstrum, int fftSize, float bin, float &slope, float &curvature)
+        {
+            const float step = juce::MathConstants<float>::pi / (float)(fftSize / 2);
+            const float theta = bin * step;
+
+            // cos(q theta) + i sin(q theta) by complex rotation, one sin/cos per call
+            const float rotRe = std::cos(theta);
+            const float rotIm = std::sin(theta);
+            float re = 1.0f;
+            float im = 0.0f;
+
+            float value = 0.0f;
+            float d1 = 0.0f;
+            float d2 = 0.0f;
+            for (size_t q = 0; q < cepstrum.size(); ++q)
+            {
+                const float c = cepstrum[q];
+                const float fq = (float)q;
+                value += c * re;
+                d1 -= c * fq * im;
+                d2 -= c * fq * fq * re;
+
+                const float nextRe = re * rotRe - im * rotIm;
+                im = re * rotIm + im * rotRe;
+                re = nextRe;
+            }
+
+            slope = d1 * step;
+            curvature = d2 * step * step;
+            return value;
+        }
+
+        /**
+         * Pitch period from the cepstrum of the last process() call.
+         *
+         * A harmonic spectrum is periodic in frequency, which shows up as a peak in the
+         * cepstrum at the pitch period (in samples). The search is limited to
+         * [minPeriod, maxPeriod] and clamped to the available quefrency range.
+         *
+         * @param prominence Receives peak / RMS of the searched region (about 1-2 for noise,
+         *                   well above 3 for clearly voiced frames).
+         * @return The period in samples (parabolically interpolated), or 0 if the range is empty.
+         */
+        float estimatePitchPeriod(int minPeriod, int maxPeriod, float &prominence) const
+        {
+            prominence = 0.0f;
+            minPeriod = std::max(2, minPeriod);
+            maxPeriod = std::min((int)rawCepstrum.size() - 2, maxPeriod);
+            if (maxPeriod <= minPeriod)
+                return 0.0f;
+
+            int peak = minPeriod;
+            float sumSquares = 0.0f;
+            for (int q = minPeriod; q <= maxPeriod; ++q)
+            {
+                const float v = rawCepstrum[(size_t)q];
+                sumSquares += v * v;
+                if (v > rawCepstrum[(size_t)peak])
+                    peak = q;
+            }
+
+            const float rms = std::sqrt(sumSquares / (float)(maxPeriod - minPeriod + 1));
+            const float peakValue = rawCepstrum[(size_t)peak];
+            if (rms <= 0.0f || peakValue <= 0.0f)
+                return 0.0f;
+
+            prominence = peakValue / rms;
+
+            const float a = rawCepstrum[(size_t)peak - 1];
+            const float c = rawCepstrum[(size_t)peak + 1];
+            const float denom = a - 2.0f * peakValue + c;
+            const float offset = (denom < 0.0f) ? juce::jlimit(-0.5f, 0.5f, 0.5f * (a - c) / denom) : 0.0f;
+
+            return (float)peak + offset;
+        }
+
     private:
         int fftSize = 0;
         std::unique_ptr<juce::dsp::FFT> forwardFFT;
         std::vector<float> frequencyDomainBuffer; // Used for both Cepstrum (Time) and Spectrum (Freq)
+        std::vector<float> rawCepstrum;           // First half of the un-liftered cepstrum (unnormalized)
+        std::vector<float> envelopeCepstrum;      // Liftered cepstrum, normalized, as cosine-series coefficients
     };
 
 } // namespace dsp
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "SpectralProcessor.h"
+
+namespace dsp
+{
+
+    /**
+     * Summary of one reference voice: mean and spread (standard deviation) of F1-F15
+     * over its voiced frames, as produced by the analysis chain.
+     */
+    struct FormantProfile
+    {
+        juce::String name;
+        std::array<float, SpectralProcessor::numFormants> meanHz{};
+        std::array<float, SpectralProcessor::numFormants> spreadHz{};
+    };
+
+    /**
+     * Compact on-disk index of formant profiles with nearest-neighbour lookup.
+     *
+     * Queries are brute-force kNN over a structure-of-arrays copy of the profiles
+     * (log2 mean frequency per formant), evaluated with juce::FloatVectorOperations.
+     * For thousands of profiles x 15 formants this is a few tens of thousands of
+     * multiply-adds, i.e. well below a millisecond, so no tree is needed.
+     *
+     * Distance per formant is measured in octaves and normalised by the profile's own
+     * spread, so a reference with a wide, unstable F3 is not penalised as much for
+     * a mismatch there. Lower formants carry most of the weight because the detector
+     * fills missing upper formants with evenly spaced guesses.
+     *
+     * File layout (little endian):
+     *   "SFPI" | int32 version | int32 numFormants | int32 numProfiles
+     *   per profile: string name | float meanHz[numFormants] | float spreadHz[numFormants]
+     */
+    class FormantProfileIndex
+    {
+    public:
+        static constexpr size_t numFormants = SpectralProcessor::numFormants;
+
+        struct Match
+        {
+            int index = -1;
+            float distance = 0.0f;
+        };
+
+        FormantProfileIndex() = default;
+
+        /**
+         * Summarises a trajectory into a profile, using only frames within
+         * voicedRangeDb of the loudest frame (silence would bias the mean toward the
+         * detector's evenly spaced fill-in values).
+         */
+        static FormantProfile makeProfile(const SpectralProcessor::FormantTrajectory &trajectory,
+                                          const juce::String &name,
+                                          float voicedRangeDb = 30.0f)
+        {
+            FormantProfile profile;
+            profile.name = name;
+
+            if (trajectory.isEmpty())
+                return profile;
+
+            float maxDb = -100.0f;
+            for (float db : trajectory.energyDb)
+                maxDb = std::max(maxDb, db);
+
+            std::array<double, numFormants> sum{};
+            std::array<double, numFormants> sumSquares{};
+            int count = 0;
+
+            for (size_t f = 0; f < trajectory.framesHz.size(); ++f)
+            {
+                const float db = f < trajectory.energyDb.size() ? trajectory.energyDb[f] : maxDb;
+                if (db < maxDb - voicedRangeDb)
+                    continue;
+
+                for (size_t d = 0; d < numFormants; ++d)
+                {
+                    const double v = trajectory.framesHz[f][d];
+                    sum[d] += v;
+                    sumSquares[d] += v * v;
+                }
+                ++count;
+            }
+
+            if (count == 0)
+                return profile;
+
+            for (size_t d = 0; d < numFormants; ++d)
+            {
+                const double mean = sum[d] / count;
+                const double variance = std::max(0.0, sumSquares[d] / count - mean * mean);
+                profile.meanHz[d] = (float)mean;
+                profile.spreadHz[d] = (float)std::sqrt(variance);
+            }
+
+            return profile;
+        }
+
+        void clear()
+        {
+            profiles.clear();
+            rebuildSearchData();
+        }
+
+        void add(FormantProfile profile)
+        {
+            profiles.push_back(std::move(profile));
+            rebuildSearchData();
+        }
+
+        void setProfiles(std::vector<FormantProfile> newProfiles)
+        {
+            profiles = std::move(newProfiles);
+            rebuildSearchData();
+        }
+
+        int size() const { return (int)profiles.size(); }
+        bool isEmpty() const { return profiles.empty(); }
+        const FormantProfile &getProfile(int index) const { return profiles[(size_t)index]; }
+
+        /**
+         * Returns up to k profiles closest to the query, nearest first.
+         * Uses internal scratch buffers, so a given index must not be queried from two threads at once.
+         */
+        std::vector<Match> findNearest(const std::array<float, numFormants> &queryHz, int k)
+        {
+            std::vector<Match> matches;
+            const int n = size();
+            if (n == 0 || k <= 0)
+                return matches;
+
+            juce::FloatVectorOperations::clear(distances.data(), n);
+
+            for (size_t d = 0; d < numFormants; ++d)
+            {
+                if (formantWeights[d] <= 0.0f)
+                    continue;
+
+                const float q = std::log2(std::max(1.0f, queryHz[d]));
+                const float *means = logMeans.data() + d * (size_t)n;
+                const float *invSpread = inverseSpreads.data() + d * (size_t)n;
+
+                // scaled = (mean - q) / spread * sqrt(weight)
+                juce::FloatVectorOperations::add(scratch.data(), means, -q, n);
+                juce::FloatVectorOperations::multiply(scratch.data(), invSpread, n);
+                juce::FloatVectorOperations::multiply(scratch.data(), std::sqrt(formantWeights[d]), n);
+                juce::FloatVectorOperations::addWithMultiply(distances.data(), scratch.data(), scratch.data(), n);
+            }
+
+            k = std::min(k, n);
+            std::vector<int> order((size_t)n);
+            for (int i = 0; i < n; ++i)
+                order[(size_t)i] = i;
+
+            std::partial_sort(order.begin(), order.begin() + k, order.end(), [this](int a, int b)
+                              { return distances[(size_t)a] < distances[(size_t)b]; });
+
+            matches.reserve((size_t)k);
+            for (int i = 0; i < k; ++i)
+                matches.push_back({order[(size_t)i], std::sqrt(distances[(size_t)order[(size_t)i]])});
+
+            return matches;
+        }
+
+        bool writeToFile(const juce::File &file) const
+        {
+            file.deleteFile();
+            juce::FileOutputStream out(file);
+            if (!out.openedOk())
+                return false;
+
+            out.write(fileMagic, 4);
+            out.writeInt(fileVersion);
+            out.writeInt((int)numFormants);
+            out.writeInt(size());
+
+            for (const auto &p : profiles)
+            {
+                out.writeString(p.name);
+                for (float v : p.meanHz)
+                    out.writeFloat(v);
+                for (float v : p.spreadHz)
+                    out.writeFloat(v);
+            }
+
+            out.flush();
+            return !out.getStatus().failed();
+        }
+
+        bool readFromFile(const juce::File &file)
+        {
+            juce::FileInputStream in(file);
+            if (!in.openedOk())
+                return false;
+
+            char magic[4] = {};
+            if (in.read(magic, 4) != 4 || std::memcmp(magic, fileMagic, 4) != 0)
+                return false;
+
+            if (in.readInt() != fileVersion || in.readInt() != (int)numFormants)
+                return false;
+
+            // The count is untrusted: every profile takes at least minProfileBytes of what is left.
+            const int count = in.readInt();
+            if (count < 0 || (juce::int64)count > in.getNumBytesRemaining() / minProfileBytes)
+                return false;
+
+            std::vector<FormantProfile> loaded((size_t)count);
+            for (auto &p : loaded)
+            {
+                p.name = in.readString();
+                for (auto &v : p.meanHz)
+                    v = in.readFloat();
+                for (auto &v : p.spreadHz)
+                    v = in.readFloat();
+
+                if (in.isExhausted() && &p != &loaded.back())
+                    return false;
+            }
+
+            setProfiles(std::move(loaded));
+            return true;
+        }
+
+        static constexpr const char *defaultFileName = "formant_profiles.sfpi";
+
+    private:
+        static constexpr const char *fileMagic = "SFPI";
+        static constexpr int fileVersion = 1;
+        static constexpr juce::int64 minProfileBytes = 1 + 2 * (juce::int64)numFormants * 4; // Empty name + mean / spread
+
+        // Minimum spread (octaves) so that very stable profiles don't dominate the ranking.
+        static constexpr float minSpreadOctaves = 0.05f;
+
+        static constexpr std::array<float, numFormants> formantWeights{
+            1.0f, 1.0f, 0.7f, 0.5f, 0.3f,
+            0.1f, 0.1f, 0.05f, 0.05f, 0.0f,
+            0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+        void rebuildSearchData()
+        {
+            const size_t n = profiles.size();
+            logMeans.resize(n * numFormants);
+            inverseSpreads.resize(n * numFormants);
+            distances.resize(n);
+            scratch.resize(n);
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t d = 0; d < numFormants; ++d)
+                {
+                    const float mean = std::max(1.0f, profiles[i].meanHz[d]);
+                    // Hz spread -> octaves (first-order: d(log2 f) = df / (f ln 2))
+                    const float spreadOct = profiles[i].spreadHz[d] / (mean * 0.6931472f);
+
+                    logMeans[d * n + i] = std::log2(mean);
+                    inverseSpreads[d * n + i] = 1.0f / std::max(minSpreadOctaves, spreadOct);
+                }
+            }
+        }
+
+        std::vector<FormantProfile> profiles;
+
+        // Search data, SoA: [formant][profile]
+        std::vector<float> logMeans;
+        std::vector<float> inverseSpreads;
+        std::vector<float> distances;
+        std::vector<float> scratch;
+    };
+
+} // namespace dsp
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "SpectralProcessor.h"
+
+namespace dsp
+{
+
+    /**
+     * Learn mode: records the formants detected on the live input, hop by hop, to a track file.
+     *
+     * The audio thread only copies a 48-byte Hop into a lock-free ring (juce::AbstractFifo,
+     * single producer / single consumer); a background thread drains the ring every
+     * drainIntervalMs and appends the hops to the file. When the ring is full the hop is
+     * dropped and counted, the audio thread never waits or touches the disk.
+     *
+     * File layout (little endian), 42 bytes per hop:
+     *   "SFMT" | int32 version | int32 numFormants | double sampleRate | int32 hopSamples
+     *   per hop: int64 timeInSamples | int16 energy (centi-dB) | uint8 voicing | uint8 flags
+     *            | uint16 formants[numFormants] (0.5 Hz steps)
+     *
+     * readTrackFile() turns a track back into a FormantTrajectory, usable as a time-varying target.
+     */
+    class FormantRecorder : private juce::Thread
+    {
+    public:
+        static constexpr size_t numFormants = SpectralProcessor::numFormants;
+
+        struct Hop
+        {
+            enum Flags : juce::uint8
+            {
+                detected = 1,   // Formants were detected (otherwise halfHz holds no new information)
+                hostPlaying = 2 // timeInSamples is a position on the host timeline
+            };
+
+            juce::int64 timeInSamples = 0;              // Start of the analysis frame
+            std::array<juce::uint16, numFormants> halfHz{}; // Formants in 0.5 Hz steps
+            juce::int16 energyCentiDb = 0;              // Frame RMS in 0.01 dB
+            juce::uint8 voicing = 0;                    // Cepstral voicing, 0-255
+            juce::uint8 flags = 0;
+        };
+
+        static constexpr int ringCapacity = 4096; // ~24 s of hops at 44.1 kHz
+        static constexpr int hopFileBytes = 8 + 2 + 1 + 1 + 2 * (int)numFormants; // 42, see the layout above
+        static constexpr size_t maxTrackFrames = (size_t)1 << 21; // ~3 h at 48 kHz with 256-sample hops
+        static constexpr int drainIntervalMs = 100;
+        static constexpr const char *fileExtension = ".sfmt";
+
+        FormantRecorder() : juce::Thread("FormantRecorder"), fifo(ringCapacity)
+        {
+            ring.resize((size_t)ringCapacity);
+        }
+
+        ~FormantRecorder() override
+        {
+            stop();
+        }
+
+        /** Message thread: opens (replaces) the file and starts recording. */
+        bool start(const juce::File &file, double sampleRate, int hopSamples)
+        {
+            stop();
+
+            file.deleteFile();
+            auto stream = std::make_unique<juce::FileOutputStream>(file);
+            if (!stream->openedOk())
+                return false;
+
+            stream->write(fileMagic, 4);
+            stream->writeInt(fileVersion);
+            stream->writeInt((int)numFormants);
+            stream->writeDouble(sampleRate);
+            stream->writeInt(hopSamples);
+
+            output = std::move(stream);
+            fifo.reset();
+            droppedHops = 0;
+            writtenHops = 0;
+
+            startThread();
+            recording = true;
+            return true;
+        }
+
+        /** Message thread: stops recording, writes what is left in the ring and closes the file. */
+        void stop()
+        {
+            recording = false;
+            stopThread(2000);
+
+            if (output != nullptr)
+            {
+                output->flush();
+                output.reset();
+            }
+        }
+
+        bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+        /** Audio thread: queues one hop. Never blocks or allocates. */
+        void push(const Hop &hop)
+        {
+            if (!recording.load(std::memory_order_acquire))
+                return;
+
+            int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+            fifo.prepareToWrite(1, start1, size1, start2, size2);
+            if (size1 + size2 == 0)
+            {
+                droppedHops.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            ring[(size_t)(size1 > 0 ? start1 : start2)] = hop;
+            fifo.finishedWrite(1);
+        }
+
+        juce::int64 getNumWrittenHops() const { return writtenHops.load(); }
+        int getNumDroppedHops() const { return droppedHops.load(); }
+
+        /**
+         * Reads a track file into a trajectory of its hop size. Hops recorded while the host was
+         * playing are placed on the host timeline (so the track follows the song position);
+         * otherwise the hops are laid out in recording order. Hops without detected formants and
+         * gaps hold the previous formants.
+         */
+        static SpectralProcessor::FormantTrajectory readTrackFile(const juce::File &file)
+        {
+            SpectralProcessor::FormantTrajectory trajectory;
+
+            juce::FileInputStream in(file);
+            if (!in.openedOk())
+                return trajectory;
+
+            char magic[4] = {};
+            if (in.read(magic, 4) != 4 || std::memcmp(magic, fileMagic, 4) != 0)
+                return trajectory;
+
+            if (in.readInt() != fileVersion || in.readInt() != (int)numFormants)
+                return trajectory;
+
+            const double sampleRate = in.readDouble();
+            const int hopSamples = in.readInt();
+            if (!(sampleRate > 0.0) || hopSamples <= 0)
+                return trajectory;
+
+            // Whole hops only: a truncated trailing hop (recording cut off mid-write) is dropped.
+            std::vector<Hop> hops;
+            hops.reserve((size_t)(in.getNumBytesRemaining() / hopFileBytes));
+            while (in.getNumBytesRemaining() >= hopFileBytes)
+            {
+                Hop hop;
+                hop.timeInSamples = in.readInt64();
+                hop.energyCentiDb = (juce::int16)in.readShort();
+                hop.voicing = (juce::uint8)in.readByte();
+                hop.flags = (juce::uint8)in.readByte();
+                for (auto &v : hop.halfHz)
+                    v = (juce::uint16)in.readShort();
+                hops.push_back(hop);
+            }
+
+            // Timeline positions come from the file: frames past maxTrackFrames would be an
+            // allocation the file asks for, not data it holds, so those hops are dropped.
+            const auto onTimelineHop = [hopSamples](const Hop &h)
+            {
+                return (h.flags & Hop::hostPlaying) != 0 && h.timeInSamples >= 0
+                       && h.timeInSamples / hopSamples < (juce::int64)maxTrackFrames;
+            };
+            const bool onTimeline = std::any_of(hops.begin(), hops.end(), onTimelineHop);
+            if (onTimeline)
+                hops.erase(std::remove_if(hops.begin(), hops.end(), [&](const Hop &h)
+                                          { return !onTimelineHop(h); }),
+                           hops.end());
+            else if (hops.size() > maxTrackFrames)
+                hops.resize(maxTrackFrames);
+
+            if (hops.empty())
+                return trajectory;
+
+            auto frameOf = [&](size_t i)
+            {
+                return onTimeline ? (size_t)(hops[i].timeInSamples / hopSamples) : i;
+            };
+
+            size_t numFrames = 0;
+            for (size_t i = 0; i < hops.size(); ++i)
+                numFrames = std::max(numFrames, frameOf(i) + 1);
+
+            trajectory.sampleRate = sampleRate;
+            trajectory.hopSamples = hopSamples;
+            trajectory.framesHz.resize(numFrames);
+            trajectory.energyDb.assign(numFrames, -100.0f);
+            std::vector<bool> filled(numFrames, false);
+
+            std::array<float, numFormants> lastHz{};
+            bool haveFormants = false;
+            for (size_t i = 0; i < hops.size(); ++i)
+            {
+                const auto &hop = hops[i];
+                if ((hop.flags & Hop::detected) != 0)
+                {
+                    for (size_t f = 0; f < numFormants; ++f)
+                        lastHz[f] = 0.5f * (float)hop.halfHz[f];
+
+                    // Frames before the first detection take its formants.
+                    if (!haveFormants)
+                        std::fill(trajectory.framesHz.begin(), trajectory.framesHz.end(), lastHz);
+                    haveFormants = true;
+                }
+
+                const size_t frame = frameOf(i);
+                trajectory.framesHz[frame] = lastHz;
+                trajectory.energyDb[frame] = 0.01f * (float)hop.energyCentiDb;
+                filled[frame] = true;
+            }
+
+            if (!haveFormants)
+                return {};
+
+            // Gaps (transport jumps, dropped or skipped hops) hold the previous frame.
+            for (size_t f = 1; f < numFrames; ++f)
+            {
+                if (!filled[f] && filled[f - 1])
+                {
+                    trajectory.framesHz[f] = trajectory.framesHz[f - 1];
+                    trajectory.energyDb[f] = trajectory.energyDb[f - 1];
+                    filled[f] = true;
+                }
+            }
+
+            return trajectory;
+        }
+
+    private:
+        static constexpr const char *fileMagic = "SFMT";
+        static constexpr int fileVersion = 1;
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                drain();
+                wait(drainIntervalMs);
+            }
+
+            drain();
+        }
+
+        void drain()
+        {
+            int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+            fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+            for (int i = 0; i < size1; ++i)
+                writeHop(ring[(size_t)(start1 + i)]);
+            for (int i = 0; i < size2; ++i)
+                writeHop(ring[(size_t)(start2 + i)]);
+
+            fifo.finishedRead(size1 + size2);
+            writtenHops += size1 + size2;
+        }
+
+        void writeHop(const Hop &hop)
+        {
+            output->writeInt64(hop.timeInSamples);
+            output->writeShort(hop.energyCentiDb);
+            output->writeByte((char)hop.voicing);
+            output->writeByte((char)hop.flags);
+            for (auto v : hop.halfHz)
+                output->writeShort((short)v);
+        }
+
+        juce::AbstractFifo fifo;
+        std::vector<Hop> ring;
+        std::unique_ptr<juce::FileOutputStream> output;
+
+        std::atomic<bool> recording{false};
+        std::atomic<int> droppedHops{0};
+        std::atomic<juce::int64> writtenHops{0};
+    };
+
+} // namespace dsp
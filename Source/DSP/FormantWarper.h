@@ -37,13 +37,17 @@ public:
      * Prepares the warp map based on a list of control points.
      *
      * @param numBins Number of frequency bins in the envelope.
-     * @param points User-defined control points (e.g., F1->NewF1, F2->NewF2).
+     * @param controlPoints User-defined control points (e.g., F1->NewF1, F2->NewF2).
+     *        Copied into an internal buffer: see reservePoints() to keep this allocation-free.
      */
-    void calculateWarpMap(int numBins, std::vector<WarpingPoint> points)
+    void calculateWarpMap(int numBins, const std::vector<WarpingPoint>& controlPoints)
     {
         if (warpMap.size() != (size_t)numBins)
             warpMap.resize((size_t)numBins);
 
+        auto& points = sortedPoints;
+        points.assign(controlPoints.begin(), controlPoints.end());
+
         // Ensure we cover the full range [0, Nyquist]
         // Anchor 0Hz -> 0Hz
         if (points.empty() || points.front().dstBin > 0.001f)
@@ -91,37 +95,82 @@ public:
     }
 
     /**
-     * Applies the warping to the spectral envelope.
+     * Closed-form map for a uniform frequency scaling of all formants:
+     * map[dst] = dst / ratio (clamped to the valid bin range).
+     * No control points or sorting are needed; the loop is a plain ramp multiply that
+     * the compiler vectorizes.
+     *
+     * @param numBins Number of frequency bins in the envelope.
+     * @param ratio Formant scaling ratio (> 1 moves formants up).
+     */
+    void calculateScaleWarpMap(int numBins, float ratio)
+    {
+        if (warpMap.size() != (size_t)numBins)
+            warpMap.resize((size_t)numBins);
+
+        const float invRatio = 1.0f / std::max(ratio, 1.0e-3f);
+        const float maxSrc = (float)(numBins - 1);
+
+        for (int i = 0; i < numBins; ++i)
+            warpMap[(size_t)i] = std::min((float)i * invRatio, maxSrc);
+    }
+
+    /**
+     * Moves this map toward another one: map = map + amount * (other - map).
+     * Both maps must have the same size.
+     */
+    void blendWarpMap(const FormantWarper& other, float amount)
+    {
+        jassert(other.warpMap.size() == warpMap.size());
+
+        const size_t size = std::min(warpMap.size(), other.warpMap.size());
+        for (size_t i = 0; i < size; ++i)
+            warpMap[i] += amount * (other.warpMap[i] - warpMap[i]);
+    }
+
+    /**
+     * Applies the warping to the spectral envelope: one output bin per map entry, read from the
+     * source at warpMap[i] (linear interpolation, clamped to the source's bins). The source may
+     * have a different size than the map, e.g. a stored envelope.
      *
      * @param srcEnvelope The original extracted envelope.
      * @param dstEnvelope The destination buffer for the warped envelope.
      */
     void process(const std::vector<float>& srcEnvelope, std::vector<float>& dstEnvelope)
     {
-        jassert(srcEnvelope.size() == dstEnvelope.size());
-        jassert(warpMap.size() == srcEnvelope.size());
+        jassert(warpMap.size() == dstEnvelope.size());
+
+        if (srcEnvelope.empty())
+            return;
 
-        size_t size = srcEnvelope.size();
-        size_t maxIdx = size - 1;
+        const size_t size = std::min(dstEnvelope.size(), warpMap.size());
+        const float maxIdx = (float)(srcEnvelope.size() - 1);
 
         for (size_t i = 0; i < size; ++i)
         {
             // Get the source index from the map
-            float srcIdx = warpMap[i];
+            float srcIdx = juce::jlimit(0.0f, maxIdx, warpMap[i]);
 
             // Linear Interpolation for smooth envelope resampling
             int idx0 = (int)srcIdx;
             int idx1 = std::min(idx0 + 1, (int)maxIdx);
-            float frac = srcIdx - idx0;
+            float frac = srcIdx - (float)idx0;
 
             dstEnvelope[i] = srcEnvelope[(size_t)idx0] + frac * (srcEnvelope[(size_t)idx1] - srcEnvelope[(size_t)idx0]);
         }
     }
 
+    /** Reserves room for up to maxPoints control points (plus the two anchors) ahead of the audio thread. */
+    void reservePoints(int maxPoints)
+    {
+        sortedPoints.reserve((size_t)maxPoints + 2);
+    }
+
     const std::vector<float>& getWarpMap() const { return warpMap; }
 
 private:
     std::vector<float> warpMap;
+    std::vector<WarpingPoint> sortedPoints; // Control points plus anchors, sorted by destination
 };
 
 } // namespace dsp
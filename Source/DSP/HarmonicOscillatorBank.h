@@ -0,0 +1,180 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Bank of harmonic oscillators for sinusoidal resynthesis.
+     *
+     * Partial k runs at (k + 1) * f0 and is tracked by its harmonic number, so its phase
+     * stays continuous from frame to frame while F0 glides.
+     *
+     * Each oscillator is a complex rotator (re, im) multiplied by (cos w, sin w) every
+     * sample. State is kept in structure-of-arrays form and the per-sample loop runs over
+     * partials without transcendental calls, so the compiler vectorizes it. The cost is
+     * proportional to the number of partials and independent of any FFT size.
+     */
+    class HarmonicOscillatorBank
+    {
+    public:
+        HarmonicOscillatorBank() = default;
+
+        void prepare(double newSampleRate, int newMaxPartials)
+        {
+            sampleRate = newSampleRate;
+            maxPartials = std::max(1, newMaxPartials);
+
+            const auto n = (size_t)maxPartials;
+            rotRe.assign(n, 1.0f);
+            rotIm.assign(n, 0.0f);
+            stepRe.assign(n, 1.0f);
+            stepIm.assign(n, 0.0f);
+            currentAmp.assign(n, 0.0f);
+            targetAmp.assign(n, 0.0f);
+            ampIncrement.assign(n, 0.0f);
+            frequencyHz.assign(n, 0.0f);
+
+            activePartials = 0;
+        }
+
+        void reset()
+        {
+            std::fill(rotRe.begin(), rotRe.end(), 1.0f);
+            std::fill(rotIm.begin(), rotIm.end(), 0.0f);
+            std::fill(currentAmp.begin(), currentAmp.end(), 0.0f);
+            std::fill(targetAmp.begin(), targetAmp.end(), 0.0f);
+            activePartials = 0;
+        }
+
+        /**
+         * Sets the frame the next render() call glides toward.
+         *
+         * @param f0Hz       Fundamental frequency; partial k runs at (k + 1) * f0Hz.
+         * @param amplitudes Target amplitude per partial.
+         * @param count      Number of partials to sound (0 fades the whole bank out).
+         */
+        void setTargets(float f0Hz, const float *amplitudes, int count)
+        {
+            count = juce::jlimit(0, maxPartials, count);
+
+            for (int k = 0; k < count; ++k)
+            {
+                // A partial entering from silence starts with a fresh phase.
+                if (k >= activePartials || currentAmp[(size_t)k] == 0.0f)
+                {
+                    rotRe[(size_t)k] = 1.0f;
+                    rotIm[(size_t)k] = 0.0f;
+                }
+
+                frequencyHz[(size_t)k] = f0Hz * (float)(k + 1);
+                targetAmp[(size_t)k] = amplitudes[k];
+            }
+
+            // Partials above the new count (F0 rose, or voicing dropped) fade out at their old frequency.
+            for (int k = count; k < activePartials; ++k)
+                targetAmp[(size_t)k] = 0.0f;
+
+            activePartials = std::max(count, activePartials);
+        }
+
+        /**
+         * Adds numSamples of output. Amplitudes glide linearly from the previous frame's
+         * values to the targets over glideSamples and are held afterwards.
+         */
+        void render(float *output, int numSamples, int glideSamples)
+        {
+            const int n = activePartials;
+            if (n == 0 || numSamples <= 0)
+                return;
+
+            glideSamples = juce::jlimit(1, numSamples, glideSamples);
+            const float twoPiOverFs = juce::MathConstants<float>::twoPi / (float)sampleRate;
+
+            for (int k = 0; k < n; ++k)
+            {
+                const float w = frequencyHz[(size_t)k] * twoPiOverFs;
+                stepRe[(size_t)k] = std::cos(w);
+                stepIm[(size_t)k] = std::sin(w);
+                ampIncrement[(size_t)k] = (targetAmp[(size_t)k] - currentAmp[(size_t)k]) / (float)glideSamples;
+
+                // Renormalise once per frame so the recursion cannot drift in magnitude.
+                const float mag = std::sqrt(rotRe[(size_t)k] * rotRe[(size_t)k] + rotIm[(size_t)k] * rotIm[(size_t)k]);
+                if (mag > 0.0f)
+                {
+                    rotRe[(size_t)k] /= mag;
+                    rotIm[(size_t)k] /= mag;
+                }
+            }
+
+            renderSamples(output, glideSamples, n, true);
+            std::copy(targetAmp.begin(), targetAmp.begin() + n, currentAmp.begin());
+            renderSamples(output + glideSamples, numSamples - glideSamples, n, false);
+
+            // Drop partials that have fully faded out from the top of the bank.
+            while (activePartials > 0 && currentAmp[(size_t)activePartials - 1] == 0.0f)
+                --activePartials;
+        }
+
+        int getNumActivePartials() const { return activePartials; }
+
+        /** Denormals in the oscillator state (phasors and amplitude ramps of the active partials). */
+        int countDenormals() const
+        {
+            int count = 0;
+            for (const auto *state : {&rotRe, &rotIm, &currentAmp, &ampIncrement})
+                for (int k = 0; k < activePartials; ++k)
+                    if (std::fpclassify((*state)[(size_t)k]) == FP_SUBNORMAL)
+                        ++count;
+            return count;
+        }
+
+    private:
+        void renderSamples(float *output, int numSamples, int n, bool gliding)
+        {
+            float *re = rotRe.data();
+            float *im = rotIm.data();
+            const float *cr = stepRe.data();
+            const float *ci = stepIm.data();
+            float *amp = currentAmp.data();
+            const float *inc = ampIncrement.data();
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                float sum = 0.0f;
+
+                for (int k = 0; k < n; ++k)
+                {
+                    const float r = re[k] * cr[k] - im[k] * ci[k];
+                    const float i = re[k] * ci[k] + im[k] * cr[k];
+                    re[k] = r;
+                    im[k] = i;
+
+                    if (gliding)
+                        amp[k] += inc[k];
+
+                    sum += amp[k] * i;
+                }
+
+                output[s] += sum;
+            }
+        }
+
+        double sampleRate = 44100.0;
+        int maxPartials = 1;
+        int activePartials = 0;
+
+        // Oscillator state, one entry per partial
+        std::vector<float> rotRe, rotIm;   // Current phase as a unit phasor
+        std::vector<float> stepRe, stepIm; // Per-sample rotation
+        std::vector<float> currentAmp;
+        std::vector<float> targetAmp;
+        std::vector<float> ampIncrement;
+        std::vector<float> frequencyHz;
+    };
+
+} // namespace dsp
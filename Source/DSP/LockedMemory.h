@@ -0,0 +1,110 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace dsp
+{
+
+    /**
+     * Prefaults and page-locks buffers of the audio thread's working set.
+     *
+     * add() writes every page of a buffer once, so the first callbacks take no page faults on it,
+     * and mlock()s it so it is not paged out while playback is stopped. Locking is best effort: it
+     * is bounded by RLIMIT_MEMLOCK, and on Windows (where VirtualLock is bounded by the working
+     * set) it is not attempted, so a buffer may only be prefaulted. unlock() and the destructor
+     * release everything. The OS does not count locks: a page shared with another locked buffer
+     * is unlocked with whichever goes first.
+     *
+     * Only add buffers that keep their storage until unlock() (no resizing in between).
+     */
+    class LockedMemory
+    {
+    public:
+        LockedMemory() = default;
+        ~LockedMemory() { unlock(); }
+
+        template <typename T>
+        void add(std::vector<T> &buffer)
+        {
+            add(buffer.data(), buffer.size() * sizeof(T));
+        }
+
+        void add(void *data, size_t numBytes)
+        {
+            if (data == nullptr || numBytes == 0)
+                return;
+
+            // Writing the value already there faults the page in for writing.
+            auto *bytes = static_cast<volatile char *>(data);
+            for (size_t offset = 0; offset < numBytes; offset += pageSize)
+                bytes[offset] = bytes[offset];
+            bytes[numBytes - 1] = bytes[numBytes - 1];
+            prefaultedBytes += numBytes;
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+            const auto first = reinterpret_cast<std::uintptr_t>(data) & ~(std::uintptr_t)(pageSize - 1);
+            const auto length = (size_t)(reinterpret_cast<std::uintptr_t>(data) + numBytes - first);
+            if (mlock(reinterpret_cast<const void *>(first), length) == 0)
+            {
+                regions.push_back({first, length});
+                lockedBytes += length;
+            }
+            else
+            {
+                ++numFailed;
+            }
+#endif
+        }
+
+        void unlock()
+        {
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+            for (const auto &region : regions)
+                munlock(reinterpret_cast<const void *>(region.first), region.length);
+#endif
+            regions.clear();
+            lockedBytes = 0;
+            prefaultedBytes = 0;
+            numFailed = 0;
+        }
+
+        size_t getLockedBytes() const { return lockedBytes; }
+        size_t getPrefaultedBytes() const { return prefaultedBytes; }
+        /** Buffers that could not be locked (no privilege, over the limit, or not supported). */
+        int getNumFailed() const { return numFailed; }
+
+    private:
+        struct Region
+        {
+            std::uintptr_t first;
+            size_t length;
+        };
+
+        static size_t queryPageSize()
+        {
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+            const long size = sysconf(_SC_PAGESIZE);
+            return size > 0 ? (size_t)size : 4096;
+#else
+            return 4096;
+#endif
+        }
+
+        const size_t pageSize = queryPageSize();
+        std::vector<Region> regions;
+        size_t lockedBytes = 0;
+        size_t prefaultedBytes = 0;
+        int numFailed = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(LockedMemory)
+    };
+
+} // namespace dsp
@@ -0,0 +1,529 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Time-domain formant shifter based on Linear Prediction (no FFT).
+     *
+     * Every hop, an all-pole model of the last analysis window is estimated with
+     * Levinson-Durbin. The roots of A(z) are found with Durand-Kerner iteration (warm
+     * started from the previous frame, so a few iterations usually suffice). Pole angles
+     * are moved through a piecewise-linear frequency map from the resonant poles to the
+     * F1-F15 targets, and the modified polynomial is stepped down to reflection coefficients.
+     *
+     * Per sample:
+     *   residual e = A(z) x        (lattice FIR, analysis reflection coefficients)
+     *   output   y = e / A'(z)     (lattice IIR, modified reflection coefficients)
+     *
+     * Both coefficient sets are interpolated linearly per sample in the reflection domain,
+     * which keeps the synthesis filter stable (|k| < 1) throughout. With an unmodified map
+     * the two lattices are exact inverses. The analysis window only looks at past samples,
+     * so the shifter adds no latency.
+     */
+    class LpcFormantShifter
+    {
+    public:
+        static constexpr int order = 32; // 16 pole pairs: enough for F1-F15 at 44.1/48 kHz
+
+        LpcFormantShifter() = default;
+
+        void prepare(double newSampleRate)
+        {
+            sampleRate = newSampleRate;
+            analysisSize = juce::jmax(order * 4, (int)(analysisSeconds * sampleRate));
+            hopSize = juce::jmax(1, analysisSize / 2); // 12.5 ms updates, smoothed per sample
+
+            // Level-matching grid: 100 Hz up to 10 kHz (or 0.45 fs), e^{-j k w} per grid point.
+            const double maxGridHz = std::min(10000.0, 0.45 * sampleRate);
+            for (int g = 0; g < levelGridSize; ++g)
+            {
+                const double w = juce::MathConstants<double>::twoPi * (100.0 + (maxGridHz - 100.0) * g / (levelGridSize - 1)) / sampleRate;
+                for (int k = 0; k <= order; ++k)
+                {
+                    gridCos[g][k] = std::cos(w * k);
+                    gridSin[g][k] = -std::sin(w * k);
+                }
+            }
+
+            history.assign((size_t)analysisSize, 0.0f);
+            analysisFrame.assign((size_t)(analysisSize + order), 0.0f);
+
+            analysisWindow.resize((size_t)analysisSize);
+            for (int n = 0; n < analysisSize; ++n)
+                analysisWindow[(size_t)n] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)n / (float)(analysisSize - 1));
+
+            reset();
+        }
+
+        void reset()
+        {
+            std::fill(history.begin(), history.end(), 0.0f);
+            historyPos = 0;
+            samplesUntilFrame = 0;
+
+            std::fill(std::begin(kAnalysis), std::end(kAnalysis), 0.0f);
+            std::fill(std::begin(kSynthesis), std::end(kSynthesis), 0.0f);
+            std::fill(std::begin(kAnalysisStep), std::end(kAnalysisStep), 0.0f);
+            std::fill(std::begin(kSynthesisStep), std::end(kSynthesisStep), 0.0f);
+            std::fill(std::begin(analysisState), std::end(analysisState), 0.0f);
+            std::fill(std::begin(synthesisState), std::end(synthesisState), 0.0f);
+
+            gain = 1.0f;
+            gainStep = 0.0f;
+            preEmphasisState = 0.0f;
+            deEmphasisState = 0.0f;
+
+            rootsValid = false;
+            numDetected = 0;
+        }
+
+        /** Samples left before the next analysis frame is due (0 = call analyzeFrame() now). */
+        int getSamplesUntilFrame() const { return samplesUntilFrame; }
+        int getHopSize() const { return hopSize; }
+
+        /**
+         * Analyses the latest window and starts gliding toward the new filters over one hop.
+         *
+         * @param targetsHz        Target formant frequencies (ascending).
+         * @param numTargets       Number of entries in targetsHz.
+         * @param scaleRatio       Uniform frequency ratio of the global scale map.
+         * @param scaleWeight      Weight of the uniform map (0 = formant targets only, 1 = scaling only).
+         */
+        void analyzeFrame(const float *targetsHz, int numTargets, float scaleRatio, float scaleWeight)
+        {
+            samplesUntilFrame = hopSize;
+
+            float kNewAnalysis[order];
+            float kNewSynthesis[order];
+            float newGain = 1.0f;
+
+            if (!estimateReflectionCoefficients(kNewAnalysis))
+            {
+                // Silence: both filters glide to identity.
+                std::fill(std::begin(kNewAnalysis), std::end(kNewAnalysis), 0.0f);
+                std::copy(std::begin(kNewAnalysis), std::end(kNewAnalysis), kNewSynthesis);
+                numDetected = 0;
+            }
+            else if (!shiftPoles(targetsHz, numTargets, scaleRatio, scaleWeight, kNewSynthesis))
+            {
+                // Root finding failed: pass the frame through unmodified.
+                std::copy(std::begin(kNewAnalysis), std::end(kNewAnalysis), kNewSynthesis);
+            }
+            else
+            {
+                // Keep the envelope power over the formant region (the full-band filter energy
+                // would be dominated by whatever sits near Nyquist).
+                const double ratio = envelopePower(predictor) / std::max(envelopePower(shiftedPolynomial), 1.0e-30);
+                newGain = juce::jlimit(1.0f / maxGain, maxGain, (float)std::sqrt(ratio));
+            }
+
+            const float invHop = 1.0f / (float)hopSize;
+            for (int m = 0; m < order; ++m)
+            {
+                kAnalysisStep[m] = (kNewAnalysis[m] - kAnalysis[m]) * invHop;
+                kSynthesisStep[m] = (kNewSynthesis[m] - kSynthesis[m]) * invHop;
+            }
+            gainStep = (newGain - gain) * invHop;
+        }
+
+        /** Filters numSamples in place. numSamples must not exceed getSamplesUntilFrame(). */
+        void process(float *samples, int numSamples)
+        {
+            jassert(numSamples <= samplesUntilFrame);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float x = samples[i];
+
+                // Analysis history (pre-emphasised, like the filtered signal)
+                const float emphasised = x - preEmphasis * preEmphasisState;
+                preEmphasisState = x;
+                history[(size_t)historyPos] = emphasised;
+                historyPos = (historyPos + 1) % analysisSize;
+
+                // Per-sample coefficient interpolation
+                for (int m = 0; m < order; ++m)
+                {
+                    kAnalysis[m] += kAnalysisStep[m];
+                    kSynthesis[m] += kSynthesisStep[m];
+                }
+                gain += gainStep;
+
+                // Lattice FIR: residual of the current analysis model
+                float f = emphasised;
+                float bPrev = emphasised;
+                for (int m = 0; m < order; ++m)
+                {
+                    const float delayed = analysisState[m];
+                    analysisState[m] = bPrev;
+                    const float fNext = f + kAnalysis[m] * delayed;
+                    bPrev = delayed + kAnalysis[m] * f;
+                    f = fNext;
+                }
+
+                // Lattice IIR: residual through the shifted all-pole filter
+                float g = f;
+                for (int m = order - 1; m >= 0; --m)
+                {
+                    g -= kSynthesis[m] * synthesisState[m];
+                    if (m + 1 < order)
+                        synthesisState[m + 1] = synthesisState[m] + kSynthesis[m] * g;
+                }
+                synthesisState[0] = g;
+
+                const float y = gain * g + preEmphasis * deEmphasisState;
+                deEmphasisState = y;
+                samples[i] = y;
+            }
+
+            samplesUntilFrame -= numSamples;
+        }
+
+        /** Resonances found in the last frame (Hz, ascending). Returns how many were written. */
+        int getDetectedFormantsHz(float *destHz, int maxCount) const
+        {
+            const int count = std::min(maxCount, numDetected);
+            std::copy(detectedHz, detectedHz + count, destHz);
+            return count;
+        }
+
+        /** Denormals in the running state: history, lattice states, (de-)emphasis and interpolated coefficients. */
+        int countDenormals() const
+        {
+            int count = 0;
+            const auto check = [&count](float value)
+            {
+                if (std::fpclassify(value) == FP_SUBNORMAL)
+                    ++count;
+            };
+
+            for (float value : history)
+                check(value);
+            for (int m = 0; m < order; ++m)
+            {
+                check(analysisState[m]);
+                check(synthesisState[m]);
+                check(kAnalysis[m]);
+                check(kSynthesis[m]);
+            }
+            check(preEmphasisState);
+            check(deEmphasisState);
+            check(gain);
+            return count;
+        }
+
+    private:
+        using Complex = std::complex<double>;
+
+        static constexpr double analysisSeconds = 0.025;
+        static constexpr float preEmphasis = 0.97f;
+        static constexpr float maxGain = 8.0f;
+        static constexpr double maxPoleRadius = 0.998;
+        static constexpr double maxMappedFraction = 0.95; // of Nyquist
+        static constexpr int levelGridSize = 48;
+        static constexpr int maxDetected = 15;
+
+        // Resonance criteria for formant poles (as in the STFT detector: 150 Hz - 9 kHz)
+        static constexpr double minFormantHz = 150.0;
+        static constexpr double maxFormantHz = 9000.0;
+        static constexpr double maxFormantBandwidthHz = 600.0;
+
+        /** Autocorrelation of the windowed history + Levinson-Durbin. Fills predictor / k. */
+        bool estimateReflectionCoefficients(float *k)
+        {
+            // analysisFrame holds `order` leading zeros, so frame[n - lag] needs no bounds check.
+            float *frame = analysisFrame.data() + order;
+            for (int n = 0; n < analysisSize; ++n)
+                frame[n] = history[(size_t)((historyPos + n) % analysisSize)] * analysisWindow[(size_t)n];
+
+            // Lags in the inner loop: independent accumulators, so this vectorizes without fast-math.
+            float sums[order + 1] = {};
+            for (int n = 0; n < analysisSize; ++n)
+            {
+                const float xn = frame[n];
+                for (int lag = 0; lag <= order; ++lag)
+                    sums[lag] += xn * frame[n - lag];
+            }
+
+            double r[order + 1];
+            for (int lag = 0; lag <= order; ++lag)
+                r[lag] = (double)sums[lag];
+
+            if (r[0] < 1.0e-10)
+                return false;
+
+            // White-noise correction (-40 dB) keeps the recursion well conditioned.
+            r[0] *= 1.0001;
+
+            double a[order + 1] = {1.0};
+            double error = r[0];
+
+            for (int m = 1; m <= order; ++m)
+            {
+                double acc = r[m];
+                for (int i = 1; i < m; ++i)
+                    acc += a[i] * r[m - i];
+
+                const double km = -acc / error;
+
+                double updated[order + 1];
+                std::copy(a, a + order + 1, updated);
+                for (int i = 1; i < m; ++i)
+                    updated[i] = a[i] + km * a[m - i];
+                updated[m] = km;
+                std::copy(updated, updated + order + 1, a);
+
+                error *= (1.0 - km * km);
+                k[m - 1] = (float)km;
+
+                if (error <= 0.0)
+                    return false;
+            }
+
+            std::copy(a, a + order + 1, predictor);
+            return true;
+        }
+
+        /** Roots of z^p + a1 z^(p-1) + ... + ap by Durand-Kerner. */
+        bool findRoots()
+        {
+            if (!rootsValid)
+            {
+                // Standard spread start: powers of a non-real, non-unit complex number.
+                const Complex seed(0.4, 0.9);
+                Complex z(1.0, 0.0);
+                for (int j = 0; j < order; ++j)
+                {
+                    z *= seed;
+                    roots[j] = z;
+                }
+            }
+
+            for (int iteration = 0; iteration < maxRootIterations; ++iteration)
+            {
+                double largestStep = 0.0;
+
+                for (int j = 0; j < order; ++j)
+                {
+                    Complex value(1.0, 0.0);
+                    for (int i = 1; i <= order; ++i)
+                        value = value * roots[j] + predictor[i];
+
+                    Complex denominator(1.0, 0.0);
+                    for (int i = 0; i < order; ++i)
+                        if (i != j)
+                            denominator *= (roots[j] - roots[i]);
+
+                    if (std::abs(denominator) < 1.0e-300)
+                        denominator = Complex(1.0e-12, 1.0e-12);
+
+                    const Complex step = value / denominator;
+                    roots[j] -= step;
+                    largestStep = std::max(largestStep, std::abs(step));
+                }
+
+                if (largestStep < rootTolerance)
+                {
+                    rootsValid = true;
+                    return true;
+                }
+            }
+
+            rootsValid = false;
+            return false;
+        }
+
+        /**
+         * Frequency map: piecewise linear from the detected resonances to the targets,
+         * blended with a uniform scaling by scaleRatio. Not clamped to Nyquist.
+         */
+        double mapFrequency(double hz, const float *targetsHz, int numPairs, float scaleRatio, float scaleWeight) const
+        {
+            const double nyquist = 0.5 * sampleRate;
+
+            double formantMapped = hz;
+            if (numPairs > 0)
+            {
+                double x0 = 0.0, y0 = 0.0;
+                double x1 = nyquist, y1 = nyquist;
+
+                for (int i = 0; i < numPairs; ++i)
+                {
+                    if (hz < detectedHz[i])
+                    {
+                        x1 = detectedHz[i];
+                        y1 = targetsHz[i];
+                        break;
+                    }
+                    x0 = detectedHz[i];
+                    y0 = targetsHz[i];
+                }
+
+                const double t = (x1 > x0) ? (hz - x0) / (x1 - x0) : 0.0;
+                formantMapped = y0 + t * (y1 - y0);
+            }
+
+            return (1.0 - scaleWeight) * formantMapped + scaleWeight * hz * scaleRatio;
+        }
+
+        /** Mean of 1 / |A(e^{jw})|^2 over the level grid. */
+        double envelopePower(const double *polynomial) const
+        {
+            double sum = 0.0;
+            for (int g = 0; g < levelGridSize; ++g)
+            {
+                double re = 0.0, im = 0.0;
+                for (int k = 0; k <= order; ++k)
+                {
+                    re += polynomial[k] * gridCos[g][k];
+                    im += polynomial[k] * gridSin[g][k];
+                }
+                sum += 1.0 / std::max(re * re + im * im, 1.0e-30);
+            }
+            return sum / levelGridSize;
+        }
+
+        /** Moves pole angles through the frequency map and returns the new reflection coefficients. */
+        bool shiftPoles(const float *targetsHz, int numTargets, float scaleRatio, float scaleWeight, float *kOut)
+        {
+            if (!findRoots())
+                return false;
+
+            const double radPerHz = juce::MathConstants<double>::twoPi / sampleRate;
+
+            // --- Split into conjugate pairs (upper half plane) and real roots ---
+            int numPairs = 0;
+            int numReal = 0;
+            for (int j = 0; j < order; ++j)
+            {
+                if (std::abs(roots[j].imag()) < 1.0e-7)
+                    realRoots[numReal++] = roots[j].real();
+                else if (roots[j].imag() > 0.0)
+                    pairRoots[numPairs++] = roots[j];
+            }
+
+            if (2 * numPairs + numReal != order)
+                return false;
+
+            // --- Resonances: narrow poles in the formant range, narrowest first, then by frequency ---
+            int candidates[order];
+            int numCandidates = 0;
+            for (int j = 0; j < numPairs; ++j)
+            {
+                const double hz = std::arg(pairRoots[j]) / radPerHz;
+                const double bandwidthHz = -std::log(std::abs(pairRoots[j])) * sampleRate / juce::MathConstants<double>::pi;
+                if (hz >= minFormantHz && hz <= maxFormantHz && bandwidthHz <= maxFormantBandwidthHz)
+                    candidates[numCandidates++] = j;
+            }
+
+            std::sort(candidates, candidates + numCandidates, [this](int a, int b)
+                      { return std::abs(pairRoots[a]) > std::abs(pairRoots[b]); });
+
+            numDetected = std::min({numCandidates, maxDetected, numTargets});
+            for (int i = 0; i < numDetected; ++i)
+                detectedHz[i] = (float)(std::arg(pairRoots[candidates[i]]) / radPerHz);
+            std::sort(detectedHz, detectedHz + numDetected);
+
+            // --- Rebuild A'(z) from the moved poles ---
+            double poly[order + 1] = {1.0};
+            int degree = 0;
+
+            const double maxMappedHz = maxMappedFraction * 0.5 * sampleRate;
+
+            for (int j = 0; j < numPairs; ++j)
+            {
+                const double originalHz = std::arg(pairRoots[j]) / radPerHz;
+                double radius = std::min(std::abs(pairRoots[j]), maxPoleRadius);
+                double hz = mapFrequency(originalHz, targetsHz, numDetected, scaleRatio, scaleWeight);
+
+                // Poles pushed up past the top of the band are dropped (moved to the origin) rather
+                // than piled up below Nyquist, like the STFT warp which has no envelope to read up there.
+                if (hz > maxMappedHz && hz > originalHz)
+                    radius = 0.0;
+                hz = std::max(hz, 1.0);
+
+                const double c1 = -2.0 * radius * std::cos(hz * radPerHz);
+                const double c2 = radius * radius;
+
+                for (int i = degree + 2; i >= 1; --i)
+                    poly[i] += c1 * poly[i - 1] + (i >= 2 ? c2 * poly[i - 2] : 0.0);
+                degree += 2;
+            }
+
+            for (int j = 0; j < numReal; ++j)
+            {
+                const double root = juce::jlimit(-maxPoleRadius, maxPoleRadius, realRoots[j]);
+                for (int i = degree + 1; i >= 1; --i)
+                    poly[i] -= root * poly[i - 1];
+                degree += 1;
+            }
+
+            std::copy(poly, poly + order + 1, shiftedPolynomial);
+
+            // --- Step-down recursion: polynomial -> reflection coefficients ---
+            for (int m = order; m >= 1; --m)
+            {
+                const double km = poly[m];
+                if (std::abs(km) >= 1.0)
+                    return false;
+
+                kOut[m - 1] = (float)km;
+
+                const double denom = 1.0 - km * km;
+                double lower[order + 1];
+                for (int i = 1; i < m; ++i)
+                    lower[i] = (poly[i] - km * poly[m - i]) / denom;
+                for (int i = 1; i < m; ++i)
+                    poly[i] = lower[i];
+            }
+
+            return true;
+        }
+
+        static constexpr int maxRootIterations = 60;
+        static constexpr double rootTolerance = 1.0e-9;
+
+        double sampleRate = 44100.0;
+        int analysisSize = 1024;
+        int hopSize = 256;
+        int samplesUntilFrame = 0;
+
+        // Analysis input
+        std::vector<float> history; // Circular, pre-emphasised
+        std::vector<float> analysisFrame;
+        std::vector<float> analysisWindow;
+        int historyPos = 0;
+        float preEmphasisState = 0.0f;
+        float deEmphasisState = 0.0f;
+
+        // LPC model of the latest frame
+        double predictor[order + 1] = {1.0};
+        double shiftedPolynomial[order + 1] = {1.0};
+        double gridCos[levelGridSize][order + 1] = {};
+        double gridSin[levelGridSize][order + 1] = {};
+        Complex roots[order];
+        Complex pairRoots[order];
+        double realRoots[order] = {};
+        bool rootsValid = false;
+        float detectedHz[maxDetected] = {};
+        int numDetected = 0;
+
+        // Lattice filters (interpolated per sample)
+        float kAnalysis[order] = {};
+        float kSynthesis[order] = {};
+        float kAnalysisStep[order] = {};
+        float kSynthesisStep[order] = {};
+        float analysisState[order] = {};  // b_m[n-1] of the FIR lattice
+        float synthesisState[order] = {}; // b_m[n-1] of the IIR lattice
+        float gain = 1.0f;
+        float gainStep = 0.0f;
+    };
+
+} // namespace dsp
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Zero-latency filtering with a minimum-phase FIR designed from a magnitude response.
+     *
+     * Design (cepstral folding): the real cepstrum of log|H| is folded onto positive
+     * quefrencies (c[0], 2c[n], c[N/2]), transformed back and exponentiated, which gives the
+     * minimum-phase spectrum with the same magnitude. Its impulse response has its energy
+     * at the start, so it can be truncated to filterLength taps with a short taper.
+     *
+     * Convolution: the first partitionSize taps run as a direct dot product per sample;
+     * the remaining taps run as a uniformly partitioned overlap-save convolution (UPOLS)
+     * over blocks of partitionSize. The tail starts exactly one partition in, so its block
+     * delay is already accounted for and the output has no algorithmic latency. Work per
+     * sample is bounded by the partition size and the number of partitions.
+     *
+     * A new filter is crossfaded in over one partition, starting at the next block boundary.
+     * Updates must therefore be at least two partitions apart.
+     */
+    class MinimumPhaseConvolver
+    {
+    public:
+        static constexpr int partitionSize = 64;
+        static constexpr int filterLength = 256;
+
+        MinimumPhaseConvolver() = default;
+
+        /** @param designFftSize FFT size of the magnitude responses passed to setMagnitudeResponse(). */
+        void prepare(int designFftSize)
+        {
+            designSize = designFftSize;
+            designFFT = std::make_unique<juce::dsp::FFT>((int)std::log2(designSize));
+            designBuffer.assign((size_t)designSize * 2, 0.0f);
+            impulse.assign((size_t)filterLength, 0.0f);
+
+            blockFFT = std::make_unique<juce::dsp::FFT>((int)std::log2(blockFftSize));
+            blockBuffer.assign((size_t)blockFftSize * 2, 0.0f);
+
+            for (auto &filter : filters)
+            {
+                filter.head.assign((size_t)partitionSize, 0.0f);
+                filter.tailSpectra.assign((size_t)(numTailPartitions * spectrumFloats), 0.0f);
+                filter.tailOutput.assign((size_t)partitionSize, 0.0f);
+            }
+
+            inputSpectra.assign((size_t)(numTailPartitions * spectrumFloats), 0.0f);
+            headHistory.assign((size_t)partitionSize * 2, 0.0f);
+            previousBlock.assign((size_t)partitionSize, 0.0f);
+            currentBlock.assign((size_t)partitionSize, 0.0f);
+
+            reset();
+        }
+
+        /** Clears the signal state and resets the filter to a unit impulse (pass-through). */
+        void reset()
+        {
+            std::fill(inputSpectra.begin(), inputSpectra.end(), 0.0f);
+            std::fill(headHistory.begin(), headHistory.end(), 0.0f);
+            std::fill(previousBlock.begin(), previousBlock.end(), 0.0f);
+            std::fill(currentBlock.begin(), currentBlock.end(), 0.0f);
+
+            for (auto &filter : filters)
+            {
+                std::fill(filter.head.begin(), filter.head.end(), 0.0f);
+                std::fill(filter.tailSpectra.begin(), filter.tailSpectra.end(), 0.0f);
+                std::fill(filter.tailOutput.begin(), filter.tailOutput.end(), 0.0f);
+                if (!filter.head.empty()) // Not prepared yet
+                    filter.head[0] = 1.0f;
+            }
+
+            active = 0;
+            blockPos = 0;
+            historyPos = 0;
+            newestSpectrum = 0;
+            updatePending = false;
+            crossfading = false;
+        }
+
+        /**
+         * Designs the minimum-phase filter for a linear magnitude response (designFftSize / 2 + 1
+         * bins) and schedules the crossfade to it.
+         */
+        void setMagnitudeResponse(const std::vector<float> &magnitude)
+        {
+            // A crossfade in progress still reads the other slot: skip this update, the next one lands after it.
+            if (crossfading)
+                return;
+
+            designMinimumPhase(magnitude);
+            loadFilter(filters[1 - active]);
+            updatePending = true;
+        }
+
+        float processSample(float x)
+        {
+            // Newest sample first, duplicated so the head dot product never wraps.
+            historyPos = (historyPos + partitionSize - 1) % partitionSize;
+            headHistory[(size_t)historyPos] = x;
+            headHistory[(size_t)(historyPos + partitionSize)] = x;
+            currentBlock[(size_t)blockPos] = x;
+
+            const float *recent = headHistory.data() + historyPos;
+            float y = headOutput(filters[active], recent) + filters[active].tailOutput[(size_t)blockPos];
+
+            if (crossfading)
+            {
+                auto &next = filters[1 - active];
+                const float yNext = headOutput(next, recent) + next.tailOutput[(size_t)blockPos];
+                const float fade = (float)(blockPos + 1) / (float)partitionSize;
+                y += fade * (yNext - y);
+            }
+
+            if (++blockPos == partitionSize)
+                finishBlock();
+
+            return y;
+        }
+
+        /** Denormals in the convolution state: input history and spectra, pending tail outputs. */
+        int countDenormals() const
+        {
+            int count = 0;
+            for (const auto *state : {&headHistory, &inputSpectra, &currentBlock, &previousBlock,
+                                      &filters[0].tailOutput, &filters[1].tailOutput})
+                for (float value : *state)
+                    if (std::fpclassify(value) == FP_SUBNORMAL)
+                        ++count;
+            return count;
+        }
+
+    private:
+        static constexpr int blockFftSize = partitionSize * 2;
+        static constexpr int numTailPartitions = (filterLength - partitionSize) / partitionSize;
+        static constexpr int spectrumFloats = blockFftSize + 2; // (blockFftSize / 2 + 1) complex bins, interleaved
+
+        struct Filter
+        {
+            std::vector<float> head;        // Taps [0, partitionSize)
+            std::vector<float> tailSpectra; // Partition p (taps [(p + 1) B, (p + 2) B)) spectrum
+            std::vector<float> tailOutput;  // Tail contribution for the current block
+        };
+
+        static float headOutput(const Filter &filter, const float *recent)
+        {
+            float sum = 0.0f;
+            for (int t = 0; t < partitionSize; ++t)
+                sum += filter.head[(size_t)t] * recent[t];
+            return sum;
+        }
+
+        /** Cepstral folding: magnitude -> minimum-phase impulse (first filterLength taps, tapered) in `impulse`. */
+        void designMinimumPhase(const std::vector<float> &magnitude)
+        {
+            const int n = designSize;
+            const int halfN = n / 2;
+            const float invN = 1.0f / (float)n;
+
+            // log|H| -> real cepstrum
+            std::fill(designBuffer.begin(), designBuffer.end(), 0.0f);
+            for (int k = 0; k <= halfN; ++k)
+                designBuffer[(size_t)k * 2] = std::log(std::max(magnitude[(size_t)k], 1.0e-6f));
+
+            designFFT->performRealOnlyInverseTransform(designBuffer.data());
+
+            // Fold onto positive quefrencies (JUCE's inverse is unnormalized: scale by 1/N here)
+            designBuffer[0] *= invN;
+            for (int q = 1; q < halfN; ++q)
+                designBuffer[(size_t)q] *= 2.0f * invN;
+            designBuffer[(size_t)halfN] *= invN;
+            std::fill(designBuffer.begin() + halfN + 1, designBuffer.end(), 0.0f);
+
+            // -> complex log spectrum -> exp -> minimum-phase spectrum
+            designFFT->performRealOnlyForwardTransform(designBuffer.data());
+            for (int k = 0; k <= halfN; ++k)
+            {
+                const float logMag = juce::jlimit(-20.0f, 20.0f, designBuffer[(size_t)k * 2]);
+                const float phase = designBuffer[(size_t)k * 2 + 1];
+                const float mag = std::exp(logMag);
+                designBuffer[(size_t)k * 2] = mag * std::cos(phase);
+                designBuffer[(size_t)k * 2 + 1] = mag * std::sin(phase);
+            }
+
+            designFFT->performRealOnlyInverseTransform(designBuffer.data());
+
+            // Truncate with a half-Hann taper over the last quarter
+            const int taperLength = filterLength / 4;
+            for (int t = 0; t < filterLength; ++t)
+            {
+                float value = designBuffer[(size_t)t] * invN;
+                const int fromEnd = filterLength - 1 - t;
+                if (fromEnd < taperLength)
+                    value *= 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (float)fromEnd / (float)taperLength);
+                impulse[(size_t)t] = value;
+            }
+        }
+
+        /** Splits `impulse` into head taps and tail partition spectra. */
+        void loadFilter(Filter &filter)
+        {
+            std::copy(impulse.begin(), impulse.begin() + partitionSize, filter.head.begin());
+
+            for (int p = 0; p < numTailPartitions; ++p)
+            {
+                std::fill(blockBuffer.begin(), blockBuffer.end(), 0.0f);
+                const auto first = impulse.begin() + (p + 1) * partitionSize;
+                std::copy(first, first + partitionSize, blockBuffer.begin());
+                blockFFT->performRealOnlyForwardTransform(blockBuffer.data());
+                std::copy(blockBuffer.begin(), blockBuffer.begin() + spectrumFloats,
+                          filter.tailSpectra.begin() + p * spectrumFloats);
+            }
+        }
+
+        /** Block boundary: input spectrum into the delay line, tail output for the next block. */
+        void finishBlock()
+        {
+            blockPos = 0;
+
+            if (crossfading)
+            {
+                active = 1 - active;
+                crossfading = false;
+            }
+            if (updatePending)
+            {
+                crossfading = true;
+                updatePending = false;
+            }
+
+            // Overlap-save input: [previous block, current block]
+            std::copy(previousBlock.begin(), previousBlock.end(), blockBuffer.begin());
+            std::copy(currentBlock.begin(), currentBlock.end(), blockBuffer.begin() + partitionSize);
+            std::fill(blockBuffer.begin() + blockFftSize, blockBuffer.end(), 0.0f);
+            blockFFT->performRealOnlyForwardTransform(blockBuffer.data());
+
+            newestSpectrum = (newestSpectrum + numTailPartitions - 1) % numTailPartitions;
+            std::copy(blockBuffer.begin(), blockBuffer.begin() + spectrumFloats,
+                      inputSpectra.begin() + newestSpectrum * spectrumFloats);
+
+            std::swap(previousBlock, currentBlock);
+
+            computeTail(filters[active]);
+            if (crossfading)
+                computeTail(filters[1 - active]);
+        }
+
+        /** Output block k tail = last half of IFFT(sum_p X[k-1-p] * H_tail[p]). */
+        void computeTail(Filter &filter)
+        {
+            std::fill(blockBuffer.begin(), blockBuffer.end(), 0.0f);
+
+            for (int p = 0; p < numTailPartitions; ++p)
+            {
+                const float *x = inputSpectra.data() + ((newestSpectrum + p) % numTailPartitions) * spectrumFloats;
+                const float *h = filter.tailSpectra.data() + p * spectrumFloats;
+
+                for (int k = 0; k < spectrumFloats; k += 2)
+                {
+                    blockBuffer[(size_t)k] += x[k] * h[k] - x[k + 1] * h[k + 1];
+                    blockBuffer[(size_t)k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+                }
+            }
+
+            blockFFT->performRealOnlyInverseTransform(blockBuffer.data());
+
+            const float invSize = 1.0f / (float)blockFftSize;
+            for (int t = 0; t < partitionSize; ++t)
+                filter.tailOutput[(size_t)t] = blockBuffer[(size_t)(partitionSize + t)] * invSize;
+        }
+
+        // Design
+        int designSize = 1024;
+        std::unique_ptr<juce::dsp::FFT> designFFT;
+        std::vector<float> designBuffer;
+        std::vector<float> impulse;
+
+        // Partitioned convolution
+        std::unique_ptr<juce::dsp::FFT> blockFFT;
+        std::vector<float> blockBuffer;
+        std::vector<float> inputSpectra; // Frequency-domain delay line, newest at newestSpectrum
+        std::vector<float> headHistory;  // Last partitionSize inputs (newest first), stored twice
+        std::vector<float> previousBlock;
+        std::vector<float> currentBlock;
+        Filter filters[2];
+
+        int active = 0;
+        int blockPos = 0;
+        int historyPos = 0;
+        int newestSpectrum = 0;
+        bool updatePending = false;
+        bool crossfading = false;
+    };
+
+} // namespace dsp
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "SpectralProcessor.h"
+
+namespace dsp
+{
+
+    /**
+     * Multi-resolution STFT engine: a long frame for the low band, a short frame for the highs.
+     *
+     * Low band: the input is lowpass filtered and decimated (by 4 at 44.1/48 kHz) and analysed
+     * with a lowFftOrder STFT at the reduced rate, i.e. the frequency resolution of a 4x larger
+     * FFT (10.8 Hz per bin at 44.1 kHz) for resolving F1 / F2 of low voices, at a quarter of its
+     * cost. High band: a highFftOrder STFT at the full rate (64-sample hops) on the full-band
+     * input, in band envelope mode (see syncBands()). Both bands run the normal SpectralProcessor
+     * chain with the same targets. Only the parent of a multi-resolution engine allocates one.
+     *
+     * Crossover: the low band output is interpolated with the same FIR. From the high band output
+     * only the complement of that decimate/interpolate chain is kept, high - chain(high), with the
+     * delays lined up so that the chain terms cancel when the bands are unmodified: the split
+     * itself reconstructs the input exactly (decimation aliasing included), delayed by
+     * getLatencySamples(). The crossover is around 2.5 kHz.
+     *
+     * Not offered by the plugin: a full-rate STFT costs about as much per sample at 256 points as
+     * at 4096 (the hop shrinks with the frame), so the two bands together cost more than a single
+     * 4096-point STFT in band envelope mode, with about 95 ms of latency on top. Kept for the
+     * benchmark and the formant accuracy test.
+     */
+    class MultiResolutionProcessor
+    {
+    public:
+        static constexpr int lowFftOrder = 10; // 1024 at the decimated rate
+        static constexpr int highFftOrder = 8; // 256 at the full rate
+        static constexpr float splitCutoffHz = 2500.0f;   // Lowpass (-6 dB) of the decimation filter
+        static constexpr float splitTransitionHz = 3000.0f;
+
+        MultiResolutionProcessor() : lowBand(lowFftOrder), highBand(highFftOrder)
+        {
+            lowBand.isResolutionBand = true;
+            highBand.isResolutionBand = true;
+        }
+
+        void prepare(double sampleRate, int maximumBlockSize)
+        {
+            decimation = sampleRate <= 50000.0 ? 4 : sampleRate <= 100000.0 ? 8 : 16;
+
+            // Blackman-windowed sinc, odd length, unity DC gain
+            const int numTaps = (int)std::ceil(5.5 * sampleRate / (double)splitTransitionHz) | 1;
+            const double centre = 0.5 * (double)(numTaps - 1);
+            const double cutoff = (double)splitCutoffHz / sampleRate;
+            coefficients.resize((size_t)numTaps);
+            double sum = 0.0;
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const double t = (double)k - centre;
+                const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(juce::MathConstants<double>::twoPi * cutoff * t) / (juce::MathConstants<double>::pi * t);
+                const double windowPhase = juce::MathConstants<double>::twoPi * (double)k / (double)(numTaps - 1);
+                const double blackman = 0.42 - 0.5 * std::cos(windowPhase) + 0.08 * std::cos(2.0 * windowPhase);
+                coefficients[(size_t)k] = (float)(sinc * blackman);
+                sum += sinc * blackman;
+            }
+            for (auto &c : coefficients)
+                c = (float)((double)c / sum);
+
+            // The high band input waits until the low band (lowFft * decimation samples later) is ready.
+            highBandDelay = (1 << lowFftOrder) * decimation - (1 << highFftOrder);
+            filterDelay = numTaps - 1;
+
+            const int maxDecimated = maximumBlockSize / decimation + 1;
+            lowBand.prepare({sampleRate / (double)decimation, (juce::uint32)maxDecimated, 1});
+            highBand.prepare({sampleRate, (juce::uint32)maximumBlockSize, 1});
+
+            lowBuffer.assign((size_t)maxDecimated, 0.0f);
+            highBuffer.assign((size_t)maximumBlockSize, 0.0f);
+            highInputDelay.assign((size_t)highBandDelay, 0.0f);
+            highOutputDelay.assign((size_t)filterDelay, 0.0f);
+
+            for (auto *decimator : {&lowDecimator, &referenceDecimator})
+                decimator->prepare(numTaps);
+            for (auto *interpolator : {&lowInterpolator, &referenceInterpolator})
+                interpolator->prepare(numTaps, decimation);
+
+            reset();
+        }
+
+        void reset()
+        {
+            lowBand.reset();
+            highBand.reset();
+            for (auto *decimator : {&lowDecimator, &referenceDecimator})
+                decimator->reset();
+            for (auto *interpolator : {&lowInterpolator, &referenceInterpolator})
+                interpolator->reset();
+            std::fill(highInputDelay.begin(), highInputDelay.end(), 0.0f);
+            std::fill(highOutputDelay.begin(), highOutputDelay.end(), 0.0f);
+            highInputPos = 0;
+            highOutputPos = 0;
+            phase = 0;
+        }
+
+        int getLatencySamples() const { return (1 << lowFftOrder) * decimation + filterDelay; }
+
+        /** Warm start of the parent (see SpectralProcessor::setPrepareWarmup()): the bands' and the crossover's buffers. */
+        void addWorkingBuffers(LockedMemory &memory)
+        {
+            lowBand.addWorkingBuffers(memory);
+            highBand.addWorkingBuffers(memory);
+            for (auto *buffer : {&lowBuffer, &highBuffer, &highInputDelay, &highOutputDelay})
+                memory.add(*buffer);
+        }
+
+        /** One block of the parent's channel 0; settings and targets are taken from the parent. */
+        void process(SpectralProcessor &parent, const float *input, float *output, int numSamples)
+        {
+            syncBands(parent);
+
+            const int maxChunk = (int)highBuffer.size();
+            for (int start = 0; start < numSamples; start += maxChunk)
+                processChunk(parent, input + start, output + start, std::min(maxChunk, numSamples - start));
+
+            parent.copyVisualizationFrom(highBand);
+        }
+
+        /** Message thread: time-varying targets are kept per band (each looks them up at its own rate). */
+        void setTargetTrajectory(const SpectralProcessor::FormantTrajectory &trajectory)
+        {
+            lowBand.setTargetTrajectory(trajectory);
+            highBand.setTargetTrajectory(trajectory);
+        }
+
+        void setTargetEnvelope(const SpectralProcessor::TargetEnvelope &envelope)
+        {
+            lowBand.setTargetEnvelope(envelope);
+            highBand.setTargetEnvelope(envelope);
+        }
+
+        void setTargetFormantsHz(const std::array<float, SpectralProcessor::numFormants> &targetHz)
+        {
+            lowBand.setTargetFormantsHz(targetHz);
+            highBand.setTargetFormantsHz(targetHz);
+        }
+
+        /** Message thread: one target update per band (see SpectralProcessor::prepareTargetUpdate()). */
+        void prepareTargetUpdates(std::vector<SpectralProcessor::TargetUpdate> &updates,
+                                  const SpectralProcessor::FormantTrajectory &trajectory,
+                                  const SpectralProcessor::TargetEnvelope &envelope) const
+        {
+            updates.resize(2);
+            lowBand.prepareTargetUpdate(updates[0], trajectory, envelope);
+            highBand.prepareTargetUpdate(updates[1], trajectory, envelope);
+        }
+
+        /** Audio thread: installs the band updates; false if either has to be retried. */
+        bool applyTargetUpdates(std::vector<SpectralProcessor::TargetUpdate> &updates)
+        {
+            if (updates.size() != 2)
+                return true;
+
+            const bool lowApplied = lowBand.applyTargetUpdate(updates[0]);
+            const bool highApplied = highBand.applyTargetUpdate(updates[1]);
+            return lowApplied && highApplied;
+        }
+
+        /** The bands start on their targets (a context taking over, see SpectralProcessor::copyFormantTargetsFrom()). */
+        void snapTargets()
+        {
+            for (auto *band : {&lowBand, &highBand})
+                band->staticTargetsHz = band->hopTargetsHz = band->targetFormantsHz;
+        }
+
+        /** Target changes handed to the bands that either band has not reached yet. */
+        bool hasPendingTargetChanges() const { return lowBand.hasPendingTargetChanges() || highBand.hasPendingTargetChanges(); }
+
+        int countDenormals() const { return lowBand.countDenormals() + highBand.countDenormals(); }
+
+    private:
+        void processChunk(SpectralProcessor &parent, const float *input, float *output, int numSamples)
+        {
+            // Low band: decimate, process at the reduced rate
+            int numDecimated = 0;
+            int p = phase;
+            for (int n = 0; n < numSamples; ++n)
+            {
+                lowDecimator.push(input[n]);
+                if (p == 0)
+                    lowBuffer[(size_t)numDecimated++] = lowDecimator.output(coefficients);
+                p = (p + 1) % decimation;
+            }
+            processBand(lowBand, lowBuffer.data(), numDecimated);
+
+            // High band: the full-band input, delayed to line up with the low band
+            for (int n = 0; n < numSamples; ++n)
+            {
+                highBuffer[(size_t)n] = highInputDelay[(size_t)highInputPos];
+                highInputDelay[(size_t)highInputPos] = input[n];
+                highInputPos = (highInputPos + 1) % highBandDelay;
+            }
+            processBand(highBand, highBuffer.data(), numSamples);
+
+            // Both STFTs to the parent's level (their window gains differ slightly with the size)
+            const float lowGain = parent.stftUnityGain / lowBand.stftUnityGain;
+            const float highGain = parent.stftUnityGain / highBand.stftUnityGain;
+
+            // Interpolate the low band; keep the complement of the same chain from the high band
+            int k = 0;
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const float high = highGain * highBuffer[(size_t)n];
+                referenceDecimator.push(high);
+
+                if (phase == 0)
+                {
+                    lowInterpolator.push(lowGain * lowBuffer[(size_t)k++]);
+                    referenceInterpolator.push(referenceDecimator.output(coefficients));
+                }
+
+                const float highDelayed = highOutputDelay[(size_t)highOutputPos];
+                highOutputDelay[(size_t)highOutputPos] = high;
+                highOutputPos = (highOutputPos + 1) % filterDelay;
+
+                output[n] = lowInterpolator.output(coefficients, phase)
+                            + highDelayed - referenceInterpolator.output(coefficients, phase);
+                phase = (phase + 1) % decimation;
+            }
+        }
+
+        /** Polyphase decimator: the FIR is evaluated only for the kept samples. */
+        struct Decimator
+        {
+            std::vector<float> history; // Doubled, so the newest numTaps samples are contiguous
+            int numTaps = 0;
+            int pos = 0;
+
+            void prepare(int taps)
+            {
+                numTaps = taps;
+                history.assign((size_t)taps * 2, 0.0f);
+            }
+
+            void reset()
+            {
+                std::fill(history.begin(), history.end(), 0.0f);
+                pos = 0;
+            }
+
+            void push(float x)
+            {
+                history[(size_t)pos] = x;
+                history[(size_t)(pos + numTaps)] = x;
+                pos = (pos + 1) % numTaps;
+            }
+
+            float output(const std::vector<float> &h) const
+            {
+                // history[pos .. pos + numTaps) runs oldest to newest
+                const float *x = history.data() + pos;
+                float sum = 0.0f;
+                for (int k = 0; k < numTaps; ++k)
+                    sum += h[(size_t)k] * x[numTaps - 1 - k];
+                return sum;
+            }
+        };
+
+        /** Polyphase interpolator: zero stuffing by `factor` and the FIR (gain factor), one phase per output. */
+        struct Interpolator
+        {
+            std::vector<float> history; // Doubled, newest decimated sample last
+            int length = 0;
+            int factor = 1;
+            int pos = 0;
+
+            void prepare(int taps, int interpolation)
+            {
+                factor = interpolation;
+                length = (taps + interpolation - 1) / interpolation;
+                history.assign((size_t)length * 2, 0.0f);
+            }
+
+            void reset()
+            {
+                std::fill(history.begin(), history.end(), 0.0f);
+                pos = 0;
+            }
+
+            void push(float v)
+            {
+                history[(size_t)pos] = v;
+                history[(size_t)(pos + length)] = v;
+                pos = (pos + 1) % length;
+            }
+
+            /** Output `phase` samples after the newest decimated sample: factor * sum_j h[phase + j * factor] * v[m - j]. */
+            float output(const std::vector<float> &h, int phase) const
+            {
+                const float *v = history.data() + pos + length - 1; // newest
+                const int numTaps = (int)h.size();
+                float sum = 0.0f;
+                for (int j = 0, tap = phase; tap < numTaps; ++j, tap += factor)
+                    sum += h[(size_t)tap] * v[-j];
+                return (float)factor * sum;
+            }
+        };
+
+        void syncBands(SpectralProcessor &parent)
+        {
+            lowBand.copySettingsFrom(parent);
+            highBand.copySettingsFrom(parent);
+
+            // Above the crossover the mel bands are about as fine as the short frame's cepstral
+            // envelope, and they spare the high band two of its four FFTs per hop. The
+            // full-envelope target needs the cepstral analysis.
+            highBand.bandMode = parent.bandMode || !(parent.fullEnvelopeTarget && highBand.hasTargetEnvelope());
+
+            // Host time of each band's input: the low band sees the decimation filter's delay,
+            // the high band highBandDelay.
+            const juce::int64 position = parent.playbackPosition;
+            const int decimatorDelay = filterDelay / 2;
+            lowBand.setPlaybackPosition((position - decimatorDelay) / decimation, parent.hostIsPlaying);
+            highBand.setPlaybackPosition(position - highBandDelay, parent.hostIsPlaying);
+
+            // Queued target switches move to the sample each band sees the event at. The bands
+            // own them from here; the parent reports them pending until both have applied them.
+            for (int c = 0; c < parent.numPendingTargetChanges; ++c)
+            {
+                const auto &change = parent.pendingTargetChanges[(size_t)c];
+                lowBand.queueTargetChange((change.sampleOffset + decimatorDelay) / decimation, change.targetHz);
+                highBand.queueTargetChange(change.sampleOffset + highBandDelay, change.targetHz);
+            }
+            parent.numPendingTargetChanges = 0;
+        }
+
+        static void processBand(SpectralProcessor &band, float *samples, int numSamples)
+        {
+            float *channels[] = {samples};
+            juce::dsp::AudioBlock<float> block(channels, 1, (size_t)numSamples);
+            band.process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+
+        SpectralProcessor lowBand;
+        SpectralProcessor highBand;
+
+        std::vector<float> coefficients;
+        int decimation = 4;
+        int filterDelay = 0;   // Of the decimate + interpolate chain
+        int highBandDelay = 0;
+        int phase = 0;         // Position within the decimation period
+
+        Decimator lowDecimator, referenceDecimator;
+        Interpolator lowInterpolator, referenceInterpolator;
+
+        std::vector<float> lowBuffer;
+        std::vector<float> highBuffer;
+        std::vector<float> highInputDelay;
+        std::vector<float> highOutputDelay;
+        int highInputPos = 0;
+        int highOutputPos = 0;
+    };
+
+} // namespace dsp
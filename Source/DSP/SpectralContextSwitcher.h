@@ -0,0 +1,537 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "SpectralProcessor.h"
+
+namespace dsp
+{
+
+    /**
+     * Hot-swaps SpectralProcessor contexts (FFT size, engine, analysis padding) without stopping the audio.
+     *
+     * A configuration change is built on a background thread as a complete, prepared context
+     * (buffers, FFT plans, state) with the targets of the current one, and published through an
+     * atomic pointer. The audio thread adopts it at the start of a block, runs both contexts
+     * on the input until the new one has filled its latency, crossfades the outputs over
+     * crossfadeMs and hands the old context back. Contexts can differ in latency (LPC has none,
+     * STFT has its FFT size): the output with the lower latency is delayed by the difference for
+     * the transition, so the two are faded in time with each other, and getLatencySamples()
+     * reports the new latency only once the fade is done. The background thread deletes it. The audio
+     * thread only exchanges pointers: it never allocates, frees or waits for a lock here, apart
+     * from signalling the builder's event on a changed request or a finished crossfade. The
+     * builder sleeps on that event in between.
+     *
+     * Message thread: targets and GUI queries go through this class. The targets are kept here
+     * (under contextLock, with the builder): a new context is built with them, and for every
+     * context already built a SpectralProcessor::TargetUpdate is prepared and left in its mailbox.
+     * The audio thread swaps it in at beginBlock() and hands the replaced data back through the
+     * same mailbox, so it never shares a context's targets with another thread. Nothing set while
+     * a context is being built is lost, and no context is deleted while it is being used there.
+     */
+    class SpectralContextSwitcher : private juce::Thread
+    {
+    public:
+        struct Config
+        {
+            int fftOrder = SpectralProcessor::defaultFftOrder;
+            SpectralProcessor::Engine engine = SpectralProcessor::Engine::stft;
+            int analysisPadding = 1;
+
+            bool operator==(const Config &other) const
+            {
+                return fftOrder == other.fftOrder && engine == other.engine && analysisPadding == other.analysisPadding;
+            }
+            bool operator!=(const Config &other) const { return !(*this == other); }
+        };
+
+        static constexpr int minFftOrder = 9;  // 512
+        static constexpr int maxFftOrder = 12; // 4096
+        static constexpr double crossfadeMs = 20.0;
+        static constexpr int maxLatencySamples = 1 << maxFftOrder; // STFT 4096, the longest of the plugin's engines
+
+        SpectralContextSwitcher() : juce::Thread("SpectralContextSwitcher")
+        {
+            contexts.push_back(std::make_unique<Context>(std::make_unique<SpectralProcessor>()));
+            audioContext = contexts.back().get();
+        }
+
+        ~SpectralContextSwitcher() override
+        {
+            stopBuilder();
+        }
+
+        /**
+         * Message thread, audio stopped (prepareToPlay): replaces every context with one prepared
+         * for the spec and config, synchronously, and starts the builder thread.
+         */
+        void prepare(const juce::dsp::ProcessSpec &newSpec, Config config)
+        {
+            stopBuilder();
+
+            {
+                const juce::ScopedLock lock(contextLock);
+                pendingContext = nullptr;
+                finishedContext = nullptr;
+                fadingContext = nullptr;
+
+                spec = newSpec;
+                config.fftOrder = juce::jlimit(minFftOrder, maxFftOrder, config.fftOrder);
+
+                auto context = buildContext(config, spec, formantRecorder, prepareWarmup.load());
+                installTargets(*context);
+                contexts.clear();
+                contexts.push_back(std::make_unique<Context>(std::move(context)));
+                audioContext = contexts.back().get();
+
+                builtConfig = config;
+                requestedOrder = config.fftOrder;
+                requestedEngine = (int)config.engine;
+                requestedPadding = config.analysisPadding;
+
+                fadeBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+                for (auto &line : delayLines)
+                    line.prepare((int)spec.numChannels);
+                crossfadeSamples = std::max(1, (int)(crossfadeMs * 0.001 * spec.sampleRate));
+            }
+
+            startThread();
+        }
+
+        /**
+         * Audio thread: asks for a configuration. Lock-free apart from waking the builder thread,
+         * which only happens when the request changes.
+         */
+        void requestConfig(Config config)
+        {
+            const int order = juce::jlimit(minFftOrder, maxFftOrder, config.fftOrder);
+            bool changed = requestedOrder.exchange(order, std::memory_order_relaxed) != order;
+            changed = requestedEngine.exchange((int)config.engine, std::memory_order_relaxed) != (int)config.engine || changed;
+            changed = requestedPadding.exchange(config.analysisPadding, std::memory_order_relaxed) != config.analysisPadding || changed;
+
+            if (changed)
+                builderWakeUp.signal();
+        }
+
+        /**
+         * Audio thread, start of a block: adopts a published context (the previous one keeps
+         * running until the crossfade is done) and installs the targets set since the last block.
+         * Call before setting up the contexts for the block.
+         */
+        void beginBlock()
+        {
+            adoptPendingContext();
+
+            applyTargetUpdate(*audioContext);
+            if (fadingContext != nullptr)
+                applyTargetUpdate(*fadingContext);
+        }
+
+        /** Audio thread: the context that produces the output (the new one during a transition). */
+        SpectralProcessor &getAudioContext() { return *audioContext->processor; }
+
+        /** Audio thread: calls fn for every context that runs this block, to pass the block's settings. */
+        template <typename Function>
+        void forEachAudioContext(Function &&fn)
+        {
+            fn(*audioContext->processor);
+            if (fadingContext != nullptr)
+                fn(*fadingContext->processor);
+        }
+
+        /** Audio thread: latency to report, the old context's until the crossfade is done. */
+        int getLatencySamples() const
+        {
+            return (fadingContext != nullptr ? fadingContext : audioContext)->processor->getLatencySamples();
+        }
+
+        /** Audio thread: processes a block (at most the prepared block size). */
+        void process(const juce::dsp::ProcessContextReplacing<float> &context)
+        {
+            auto &block = context.getOutputBlock();
+            auto &heardLine = delayLines[heardLineIndex];
+
+            if (fadingContext == nullptr)
+            {
+                audioContext->processor->process(context);
+                heardLine.process(block, 0); // History, for a transition that has to delay this output
+                return;
+            }
+
+            const int numChannels = std::min((int)block.getNumChannels(), fadeBuffer.getNumChannels());
+            const int numSamples = std::min((int)block.getNumSamples(), fadeBuffer.getNumSamples());
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                fadeBuffer.copyFrom(ch, 0, block.getChannelPointer((size_t)ch), numSamples);
+
+            auto fadeBlock = juce::dsp::AudioBlock<float>(fadeBuffer).getSubsetChannelBlock(0, (size_t)numChannels).getSubBlock(0, (size_t)numSamples);
+            fadingContext->processor->process(juce::dsp::ProcessContextReplacing<float>(fadeBlock));
+            audioContext->processor->process(context);
+
+            // Both outputs at the larger of the two latencies
+            heardLine.process(fadeBlock, fadingDelaySamples);
+            delayLines[1 - heardLineIndex].process(block, audioDelaySamples);
+
+            // Old output while the new context fills its latency, then a linear crossfade.
+            const int warmup = std::min(warmupSamplesLeft, numSamples);
+            const int fadeLength = std::min(crossfadeSamplesLeft, numSamples - warmup);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto *out = block.getChannelPointer((size_t)ch);
+                const auto *old = fadeBuffer.getReadPointer(ch);
+
+                for (int i = 0; i < warmup; ++i)
+                    out[i] = old[i];
+
+                for (int i = 0; i < fadeLength; ++i)
+                {
+                    const float gain = 1.0f - (float)(crossfadeSamplesLeft - i) / (float)crossfadeSamples;
+                    out[warmup + i] = old[warmup + i] + gain * (out[warmup + i] - old[warmup + i]);
+                }
+            }
+
+            warmupSamplesLeft -= warmup;
+            crossfadeSamplesLeft -= fadeLength;
+
+            if (crossfadeSamplesLeft == 0)
+            {
+                // The new output goes back to its own latency, which is reported from now on.
+                heardLineIndex = 1 - heardLineIndex;
+                finishedContext.store(fadingContext, std::memory_order_release);
+                fadingContext = nullptr;
+                builderWakeUp.signal();
+            }
+        }
+
+        // Message thread: targets for every context (see the class comment)
+        void setTargetFormantsHz(const std::array<float, SpectralProcessor::numFormants> &targetHz)
+        {
+            const juce::ScopedLock lock(contextLock);
+            targets.formantsHz = targetHz;
+            targets.hasFormants = true;
+            postTargetUpdates(true);
+        }
+
+        void setTargetTrajectory(const SpectralProcessor::FormantTrajectory &trajectory)
+        {
+            const juce::ScopedLock lock(contextLock);
+            targets.trajectory = trajectory;
+            postTargetUpdates(false);
+        }
+
+        void setTargetEnvelope(const SpectralProcessor::TargetEnvelope &envelope)
+        {
+            const juce::ScopedLock lock(contextLock);
+            targets.envelope = envelope;
+            postTargetUpdates(false);
+        }
+
+        /**
+         * Warm start of every context built from now on (SpectralProcessor::setPrepareWarmup()):
+         * at prepare() on the calling thread, for a hot swap on the builder thread before the
+         * context is published, so the audio thread always adopts a warm one.
+         */
+        void setPrepareWarmup(bool enabled) { prepareWarmup.store(enabled); }
+
+        /** Before processing starts: the recorder of every context built from now on. */
+        void setFormantRecorder(FormantRecorder *recorder)
+        {
+            const juce::ScopedLock lock(contextLock);
+            formantRecorder = recorder;
+            contexts.back()->processor->setFormantRecorder(recorder);
+        }
+
+        // Message thread: GUI / analysis queries on the newest context
+        void getLatestVisualizationData(std::vector<float> &spectrum, std::vector<float> &envelope, float &f1, float &f2)
+        {
+            const juce::ScopedLock lock(contextLock);
+            contexts.back()->processor->getLatestVisualizationData(spectrum, envelope, f1, f2);
+        }
+
+        std::array<float, SpectralProcessor::numFormants> getLatestDetectedFormantsHz()
+        {
+            const juce::ScopedLock lock(contextLock);
+            return contexts.back()->processor->getLatestDetectedFormantsHz();
+        }
+
+        int getHopSamples()
+        {
+            const juce::ScopedLock lock(contextLock);
+            return contexts.back()->processor->getHopSamples();
+        }
+
+        /** Soak tests, between process() calls: denormals in the contexts the audio thread runs. */
+        int countDenormals() const
+        {
+            return audioContext->processor->countDenormals() + (fadingContext != nullptr ? fadingContext->processor->countDenormals() : 0);
+        }
+
+    private:
+        /** A context and its target mailbox. */
+        struct Context
+        {
+            explicit Context(std::unique_ptr<SpectralProcessor> p) : processor(std::move(p)) {}
+
+            ~Context()
+            {
+                delete stagedTargets.load();
+                delete returnedTargets.load();
+            }
+
+            std::unique_ptr<SpectralProcessor> processor;
+            std::atomic<SpectralProcessor::TargetUpdate *> stagedTargets{nullptr};   // Message -> audio thread
+            std::atomic<SpectralProcessor::TargetUpdate *> returnedTargets{nullptr}; // Audio -> message thread (replaced data)
+
+            JUCE_DECLARE_NON_COPYABLE(Context)
+        };
+
+        /** Delay of up to maxLatencySamples, used to line the outputs of two contexts up. */
+        class DelayLine
+        {
+        public:
+            void prepare(int numChannels)
+            {
+                buffer.setSize(numChannels, maxLatencySamples + 1);
+                reset();
+            }
+
+            void reset()
+            {
+                buffer.clear();
+                writePosition = 0;
+            }
+
+            /** Writes the block into the line and replaces it with the samples delaySamples earlier. */
+            void process(const juce::dsp::AudioBlock<float> &block, int delaySamples)
+            {
+                const int size = buffer.getNumSamples();
+                const int numSamples = (int)block.getNumSamples();
+                const int numChannels = std::min((int)block.getNumChannels(), buffer.getNumChannels());
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto *line = buffer.getWritePointer(ch);
+                    auto *samples = block.getChannelPointer((size_t)ch);
+                    int write = writePosition;
+                    int read = write >= delaySamples ? write - delaySamples : write - delaySamples + size;
+
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        line[write] = samples[i];
+                        samples[i] = line[read];
+                        write = write + 1 < size ? write + 1 : 0;
+                        read = read + 1 < size ? read + 1 : 0;
+                    }
+                }
+
+                writePosition = (writePosition + numSamples) % size;
+            }
+
+        private:
+            juce::AudioBuffer<float> buffer;
+            int writePosition = 0;
+        };
+
+        // The targets every context gets, set on the message thread
+        struct Targets
+        {
+            std::array<float, SpectralProcessor::numFormants> formantsHz{};
+            bool hasFormants = false;
+            SpectralProcessor::FormantTrajectory trajectory;
+            SpectralProcessor::TargetEnvelope envelope;
+        };
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                releaseFinishedContext();
+
+                const Config wanted{requestedOrder.load(std::memory_order_relaxed),
+                                    (SpectralProcessor::Engine)requestedEngine.load(std::memory_order_relaxed),
+                                    requestedPadding.load(std::memory_order_relaxed)};
+                if (wanted != builtConfig)
+                    publish(wanted);
+
+                // Signalled by requestConfig(), a finished crossfade and stopBuilder()
+                builderWakeUp.wait(-1);
+            }
+        }
+
+        void stopBuilder()
+        {
+            signalThreadShouldExit();
+            builderWakeUp.signal();
+            stopThread(2000);
+        }
+
+        void publish(Config config)
+        {
+            juce::dsp::ProcessSpec buildSpec;
+            FormantRecorder *recorder = nullptr;
+            {
+                const juce::ScopedLock lock(contextLock);
+                buildSpec = spec;
+                recorder = formantRecorder;
+            }
+
+            // The expensive part (allocation, FFT plans) runs without the lock.
+            auto context = buildContext(config, buildSpec, recorder, prepareWarmup.load());
+
+            const juce::ScopedLock lock(contextLock);
+            installTargets(*context);
+            contexts.push_back(std::make_unique<Context>(std::move(context)));
+            auto *published = contexts.back().get();
+            builtConfig = config;
+
+            // A published context the audio thread hasn't adopted yet is replaced and freed.
+            if (auto *superseded = pendingContext.exchange(published, std::memory_order_acq_rel))
+                removeContext(superseded);
+        }
+
+        void releaseFinishedContext()
+        {
+            if (auto *finished = finishedContext.load(std::memory_order_acquire))
+            {
+                {
+                    const juce::ScopedLock lock(contextLock);
+                    removeContext(finished);
+                }
+                finishedContext.store(nullptr, std::memory_order_release);
+            }
+        }
+
+        // Audio thread
+        void adoptPendingContext()
+        {
+            // One transition at a time, and only once the previous old context was collected.
+            if (fadingContext != nullptr || finishedContext.load(std::memory_order_acquire) != nullptr)
+                return;
+
+            auto *next = pendingContext.exchange(nullptr, std::memory_order_acq_rel);
+            if (next == nullptr)
+                return;
+
+            fadingContext = audioContext;
+            fadingContext->processor->setFormantRecorder(nullptr); // Only the new context records
+            audioContext = next;
+            audioContext->processor->copyFormantTargetsFrom(*fadingContext->processor);
+
+            // The lower-latency output is delayed by the difference. The line of the heard output
+            // holds its history, so the old output continues from there; the new one starts silent.
+            const int oldLatency = std::min(fadingContext->processor->getLatencySamples(), maxLatencySamples);
+            const int newLatency = std::min(audioContext->processor->getLatencySamples(), maxLatencySamples);
+            const int alignedLatency = std::max(oldLatency, newLatency);
+            fadingDelaySamples = alignedLatency - oldLatency;
+            audioDelaySamples = alignedLatency - newLatency;
+            delayLines[1 - heardLineIndex].reset();
+
+            warmupSamplesLeft = alignedLatency;
+            crossfadeSamplesLeft = crossfadeSamples;
+        }
+
+        // Audio thread
+        void applyTargetUpdate(Context &context)
+        {
+            // The previous update has to be collected first: it holds the data it replaced.
+            if (context.returnedTargets.load(std::memory_order_acquire) != nullptr)
+                return;
+
+            auto *update = context.stagedTargets.exchange(nullptr, std::memory_order_acq_rel);
+            if (update == nullptr)
+                return;
+
+            if (!context.processor->applyTargetUpdate(*update))
+            {
+                // Retried next block, unless a newer update was posted meanwhile (it replaces all of it).
+                SpectralProcessor::TargetUpdate *expected = nullptr;
+                if (context.stagedTargets.compare_exchange_strong(expected, update, std::memory_order_acq_rel))
+                    return;
+            }
+
+            context.returnedTargets.store(update, std::memory_order_release);
+        }
+
+        // Under contextLock: a context that is not running yet gets the targets directly.
+        void installTargets(SpectralProcessor &context) const
+        {
+            if (targets.hasFormants)
+                context.setTargetFormantsHz(targets.formantsHz);
+            context.setTargetTrajectory(targets.trajectory);
+            context.setTargetEnvelope(targets.envelope);
+        }
+
+        // Under contextLock: an update of every context to the current targets.
+        void postTargetUpdates(bool formantsChanged)
+        {
+            for (auto &context : contexts)
+            {
+                delete context->returnedTargets.exchange(nullptr, std::memory_order_acq_rel);
+
+                // An update the audio thread hasn't taken yet is replaced; its static targets are kept.
+                std::unique_ptr<SpectralProcessor::TargetUpdate> previous(context->stagedTargets.exchange(nullptr, std::memory_order_acq_rel));
+
+                auto update = std::make_unique<SpectralProcessor::TargetUpdate>();
+                context->processor->prepareTargetUpdate(*update, targets.trajectory, targets.envelope);
+                update->formantsHz = targets.formantsHz;
+                update->hasFormants = formantsChanged || (previous != nullptr && previous->hasFormants);
+
+                context->stagedTargets.store(update.release(), std::memory_order_release);
+            }
+        }
+
+        static std::unique_ptr<SpectralProcessor> buildContext(Config config, const juce::dsp::ProcessSpec &buildSpec, FormantRecorder *recorder, bool warmup)
+        {
+            auto context = std::make_unique<SpectralProcessor>(config.fftOrder);
+            context->setFormantRecorder(recorder);
+            context->setAnalysisPadding(config.analysisPadding);
+            context->setEngine(config.engine); // Before prepare(), so its warm-up runs this engine
+            context->setPrepareWarmup(warmup);
+            context->prepare(buildSpec);
+            return context;
+        }
+
+        // Under contextLock
+        void removeContext(Context *context)
+        {
+            contexts.erase(std::remove_if(contexts.begin(), contexts.end(), [context](const auto &c)
+                                          { return c.get() == context; }),
+                           contexts.end());
+        }
+
+        // Owned by the message / builder threads, guarded by contextLock. The newest is last.
+        juce::CriticalSection contextLock;
+        std::vector<std::unique_ptr<Context>> contexts;
+        juce::dsp::ProcessSpec spec{44100.0, 512, 2};
+        Config builtConfig;
+        FormantRecorder *formantRecorder = nullptr;
+        Targets targets;
+
+        // Hand-over between the threads
+        std::atomic<Context *> pendingContext{nullptr};  // Builder -> audio thread
+        std::atomic<Context *> finishedContext{nullptr}; // Audio thread -> builder
+        juce::WaitableEvent builderWakeUp;
+        std::atomic<int> requestedOrder{SpectralProcessor::defaultFftOrder};
+        std::atomic<int> requestedEngine{0};
+        std::atomic<int> requestedPadding{1};
+        std::atomic<bool> prepareWarmup{true};
+
+        // Audio thread
+        Context *audioContext = nullptr;
+        Context *fadingContext = nullptr;
+        juce::AudioBuffer<float> fadeBuffer;
+        std::array<DelayLine, 2> delayLines; // The heard context's (with its history) and the incoming one's
+        int heardLineIndex = 0;
+        int fadingDelaySamples = 0;
+        int audioDelaySamples = 0;
+        int crossfadeSamples = 1;
+        int warmupSamplesLeft = 0;
+        int crossfadeSamplesLeft = 0;
+    };
+
+} // namespace dsp
@@ -1,4 +1,7 @@
 #include "SpectralProcessor.h"
+#include "FormantRecorder.h"
+#include "MultiResolutionProcessor.h"
+#include "TrajectoryAligner.h"
 
 #include <algorithm>
 #include <array>
@@ -7,7 +10,11 @@
 namespace dsp
 {
 
-  SpectralProcessor::SpectralProcessor()
+  SpectralProcessor::SpectralProcessor(int order)
+      : fftOrder(order),
+        fftSize(1 << order),
+        hopSize(fftSize / 4),
+        trajectoryHopSize(hopSize * 2)
   {
     fft = std::make_unique<juce::dsp::FFT>(fftOrder);
     window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::hann);
@@ -15,12 +22,49 @@ namespace dsp
     inputFifo.resize(fftSize, 0.0f);
     outputAccumulator.resize(fftSize, 0.0f);
     fftBuffer.resize(fftSize * 2, 0.0f);
+    hopFrame.resize(fftSize, 0.0f);
 
     const int numBins = fftSize / 2 + 1;
     magnitudeSpectrum.resize((size_t)numBins);
     extractedEnvelope.resize((size_t)numBins);
     warpedEnvelope.resize((size_t)numBins);
 
+    warpPoints.reserve(numFormants + 2);
+
+    analysisPhase.resize((size_t)numBins);
+    synthesisPhase.resize((size_t)numBins);
+    shiftedMagnitude.resize((size_t)numBins);
+    shiftedFrequency.resize((size_t)numBins);
+    shiftedPeak.resize((size_t)numBins);
+
+    sinusoidBuffer.resize((size_t)(hopSize * sinusoidalVoicedHopFactor));
+    resynthesisEnvelope.resize((size_t)numBins);
+    envelopeScale.resize((size_t)numBins);
+    bandSpectrum.resize((size_t)BandEnvelope::numBands);
+    warpedCepstrum.resize((size_t)EnvelopeExtractor::defaultCutoffBin + 1);
+    cepstralLogScale.resize((size_t)numBins);
+    warpedBandSpectrum.resize((size_t)BandEnvelope::numBands);
+    partialAmplitudes.resize((size_t)sinusoidalMaxPartials);
+
+    // Level of the STFT path for an unmodified input (sum of window^2 over the overlapping frames
+    // and the normalization below), applied to the other engines / modes so all are equally loud.
+    // A windowed sinusoid of amplitude A peaks at A * sum(w) / 2.
+    {
+      std::vector<float> ones((size_t)fftSize, 1.0f);
+      window->multiplyWithWindowingTable(ones.data(), fftSize);
+
+      float windowSum = 0.0f;
+      float windowSquares = 0.0f;
+      for (float w : ones)
+      {
+        windowSum += w;
+        windowSquares += w * w;
+      }
+
+      stftUnityGain = windowSquares / ((float)hopSize * overlapAddSum);
+      sinusoidAmplitudeScale = stftUnityGain * 2.0f / windowSum;
+    }
+
     visSpectrum.resize((size_t)numBins);
     visEnvelope.resize((size_t)numBins);
   }
@@ -31,7 +75,135 @@ namespace dsp
   {
     currentSampleRate = spec.sampleRate;
     envelopeExtractor.prepare(fftSize);
+    if (analysisPadding > 1)
+    {
+      paddedSpectrum.prepare(fftOrder, analysisPadding);
+      paddedEnvelopeExtractor.prepare(fftSize * analysisPadding);
+      paddedMagnitude.assign((size_t)paddedSpectrum.getNumBins(), 0.0f);
+      paddedEnvelope.assign((size_t)paddedSpectrum.getNumBins(), 0.0f);
+    }
+    oscillatorBank.prepare(spec.sampleRate, sinusoidalMaxPartials);
+    lpcShifter.prepare(spec.sampleRate);
+    zeroLatencyConvolver.prepare(fftSize);
+    bandEnvelope.prepare(fftSize, spec.sampleRate);
+    // Warp maps are rebuilt per hop on the audio thread: room for all control points up front.
+    bandWarpPoints.reserve(std::max((size_t)BandEnvelope::numBands, numFormants + 2));
+    bandWarper.reservePoints((int)numFormants + 2);
+    bandScaleWarper.reservePoints(BandEnvelope::numBands);
+    formantWarper.reservePoints((int)numFormants + 2);
+    cepstralWarper.prepare(fftSize / 2 + 1, EnvelopeExtractor::defaultCutoffBin + 1);
+    bandScaleMapRatio = 0.0f;
+
+    const double glideSamples = targetGlideMs * 0.001 * spec.sampleRate;
+    stftTargetGlide = (float)(1.0 - std::exp(-(double)hopSize / glideSamples));
+    lpcTargetGlide = (float)(1.0 - std::exp(-(double)lpcShifter.getHopSize() / glideSamples));
+
+    {
+      // The stored target envelope on this rate's bins
+      const juce::ScopedLock lock(targetEnvelopeLock);
+      buildTargetEnvelopeCurve(targetEnvelope, targetEnvelopeCurve);
+    }
+
+    // Only the multi-resolution engine pays for the two band processors.
+    if (isResolutionBand || engine != Engine::multiResolution)
+    {
+      multiResolution.reset();
+    }
+    else
+    {
+      if (multiResolution == nullptr)
+      {
+        // Targets installed before this prepare()
+        multiResolution = std::make_unique<MultiResolutionProcessor>();
+        multiResolution->setTargetFormantsHz(targetFormantsHz);
+        {
+          const juce::ScopedLock lock(trajectoryLock);
+          multiResolution->setTargetTrajectory(targetTrajectory);
+        }
+        {
+          const juce::ScopedLock lock(targetEnvelopeLock);
+          multiResolution->setTargetEnvelope(targetEnvelope);
+        }
+      }
+
+      multiResolution->prepare(spec.sampleRate, (int)spec.maximumBlockSize);
+    }
+
     reset();
+
+    lockedMemory.unlock();
+    if (prepareWarmup && !isResolutionBand)
+    {
+      addWorkingBuffers(lockedMemory);
+      if (multiResolution != nullptr)
+        multiResolution->addWorkingBuffers(lockedMemory);
+
+      warmUp((int)spec.maximumBlockSize);
+    }
+  }
+
+  void SpectralProcessor::addWorkingBuffers(LockedMemory &memory)
+  {
+    for (auto *buffer : {&inputFifo, &outputAccumulator, &fftBuffer, &hopFrame, &magnitudeSpectrum, &extractedEnvelope,
+                         &warpedEnvelope, &analysisPhase, &synthesisPhase, &shiftedMagnitude, &shiftedFrequency,
+                         &shiftedPeak, &sinusoidBuffer, &resynthesisEnvelope, &partialAmplitudes, &envelopeScale, &bandSpectrum,
+                         &warpedBandSpectrum, &warpedCepstrum, &cepstralLogScale, &paddedMagnitude, &paddedEnvelope})
+      memory.add(*buffer);
+  }
+
+  void SpectralProcessor::warmUp(int maximumBlockSize)
+  {
+    // Nothing of the warm-up is recorded or left behind (reset() and the cleared visualization below).
+    auto *recorder = formantRecorder;
+    formantRecorder = nullptr;
+    const auto position = playbackPosition;
+
+    // A quiet 150 Hz buzz with a little noise: voiced, so the pitch and sinusoidal stages run too.
+    const int numSamples = getLatencySamples() + warmupFrames * fftSize;
+    const int blockSize = std::max(1, maximumBlockSize);
+    juce::AudioBuffer<float> input(1, numSamples);
+    juce::Random random(0x5eed);
+    float phase = 0.0f;
+    const float phaseStep = 150.0f / (float)currentSampleRate;
+    for (int i = 0; i < numSamples; ++i)
+    {
+      input.setSample(0, i, 0.01f * (2.0f * phase - 1.0f) + 0.0005f * (random.nextFloat() - 0.5f));
+      phase += phaseStep;
+      phase -= std::floor(phase);
+    }
+
+    juce::AudioBuffer<float> block(1, blockSize);
+    const auto runEngine = [&](bool zeroLatencyPath)
+    {
+      for (int start = 0; start < numSamples; start += blockSize)
+      {
+        const int count = std::min(blockSize, numSamples - start);
+        if (zeroLatencyPath)
+        {
+          processZeroLatency(input.getReadPointer(0, start), block.getWritePointer(0), count);
+          continue;
+        }
+
+        block.copyFrom(0, 0, input, 0, start, count);
+        auto audioBlock = juce::dsp::AudioBlock<float>(block).getSubBlock(0, (size_t)count);
+        process(juce::dsp::ProcessContextReplacing<float>(audioBlock));
+      }
+      reset();
+    };
+
+    runEngine(false);
+    if (engine == Engine::stft && !zeroLatency)
+      runEngine(true);
+
+    formantRecorder = recorder;
+    playbackPosition = position;
+
+    const juce::ScopedLock lock(visualizationLock);
+    std::fill(visSpectrum.begin(), visSpectrum.end(), 0.0f);
+    std::fill(visEnvelope.begin(), visEnvelope.end(), 0.0f);
+    visF1 = 0.0f;
+    visF2 = 0.0f;
+    visDetectedHz.fill(0.0f);
   }
 
   void SpectralProcessor::reset()
@@ -41,24 +213,275 @@ namespace dsp
     hopCounter = 0;
     inputWritePos = 0;
     outputReadPos = 0;
+    pitchStateValid = false;
+    oscillatorBank.reset();
+    sinusoidalHopsToSkip = 0;
+    lpcShifter.reset();
+    zeroLatencyConvolver.reset();
+    if (multiResolution != nullptr)
+      multiResolution->reset();
+
+    // Queued target changes still take effect, without the crossfade.
+    if (numPendingTargetChanges > 0)
+      targetFormantsHz = pendingTargetChanges[(size_t)numPendingTargetChanges - 1].targetHz;
+    numPendingTargetChanges = 0;
+    crossfadeHopsLeft = 0;
+    staticTargetsHz = targetFormantsHz;
+  }
+
+  void SpectralProcessor::setEngine(Engine newEngine)
+  {
+    if (newEngine == engine)
+      return;
+
+    engine = newEngine;
+    reset();
+  }
+
+  void SpectralProcessor::setZeroLatency(bool enabled)
+  {
+    if (enabled == zeroLatency)
+      return;
+
+    zeroLatency = enabled;
+    reset();
+  }
+
+  void SpectralProcessor::setPitchShift(float semitones, bool useOriginalFormants)
+  {
+    const float newRatio = std::pow(2.0f, semitones / 12.0f);
+
+    // Phases restart from the analysis phases when the shifter is (re)engaged.
+    if (std::abs(pitchRatio - 1.0f) < 1.0e-4f && std::abs(newRatio - 1.0f) >= 1.0e-4f)
+      pitchStateValid = false;
+
+    pitchRatio = newRatio;
+    pitchUsesOriginalFormants = useOriginalFormants;
   }
 
   void SpectralProcessor::setTargetFormantsHz(const std::array<float, numFormants> &targetHz)
   {
     targetFormantsHz = targetHz;
+    enforceFormantOrdering(targetFormantsHz);
+
+    if (multiResolution != nullptr)
+      multiResolution->setTargetFormantsHz(targetFormantsHz);
+  }
+
+  void SpectralProcessor::queueTargetChange(int sampleOffset, const std::array<float, numFormants> &targetHz)
+  {
+    // When full, the newest change replaces the last one: it would win at that hop anyway.
+    if (numPendingTargetChanges == maxPendingTargetChanges)
+      --numPendingTargetChanges;
+
+    auto &change = pendingTargetChanges[(size_t)numPendingTargetChanges++];
+    change.sampleOffset = sampleOffset;
+    change.targetHz = targetHz;
+    enforceFormantOrdering(change.targetHz);
+  }
+
+  bool SpectralProcessor::hasPendingTargetChanges() const
+  {
+    // The multi-resolution engine moves its queue to the bands, which apply it at their own hops.
+    return numPendingTargetChanges > 0 || (multiResolution != nullptr && multiResolution->hasPendingTargetChanges());
+  }
+
+  void SpectralProcessor::applyPendingTargetChanges(int blockOffset)
+  {
+    int numApplied = 0;
+    while (numApplied < numPendingTargetChanges && pendingTargetChanges[(size_t)numApplied].sampleOffset < blockOffset)
+      ++numApplied;
+
+    if (numApplied == 0)
+      return;
+
+    // Several changes within one hop: only the last one is heard, crossfaded from what was playing.
+    crossfadeFromHz = staticTargetsHz;
+    targetFormantsHz = pendingTargetChanges[(size_t)numApplied - 1].targetHz;
+    crossfadeHopsLeft = targetCrossfadeHops;
+
+    std::copy(pendingTargetChanges.begin() + numApplied, pendingTargetChanges.begin() + numPendingTargetChanges, pendingTargetChanges.begin());
+    numPendingTargetChanges -= numApplied;
+  }
+
+  void SpectralProcessor::enforceFormantOrdering(std::array<float, numFormants> &formantsHz)
+  {
+    for (size_t i = 0; i < formantsHz.size(); ++i)
+    {
+      const float minHz = (i == 0) ? 200.0f : formantsHz[i - 1] + 20.0f;
+      formantsHz[i] = std::max(minHz, formantsHz[i]);
+    }
+  }
+
+  void SpectralProcessor::setTargetTrajectory(FormantTrajectory trajectory)
+  {
+    if (multiResolution != nullptr)
+      multiResolution->setTargetTrajectory(trajectory);
+
+    {
+      const juce::ScopedLock lock(trajectoryLock);
+      std::swap(targetTrajectory, trajectory);
+      hasTrajectory = !targetTrajectory.isEmpty();
+    }
+    // The previous trajectory is released here, outside the lock.
+  }
+
+  void SpectralProcessor::setTargetEnvelope(TargetEnvelope newEnvelope)
+  {
+    if (multiResolution != nullptr)
+      multiResolution->setTargetEnvelope(newEnvelope);
+
+    std::vector<float> curve;
+    buildTargetEnvelopeCurve(newEnvelope, curve);
+
+    {
+      const juce::ScopedLock lock(targetEnvelopeLock);
+      std::swap(targetEnvelope, newEnvelope);
+      std::swap(targetEnvelopeCurve, curve);
+      hasStoredEnvelope = !targetEnvelope.isEmpty();
+    }
+    // The previous envelope is released here, outside the lock.
+  }
+
+  void SpectralProcessor::buildTargetEnvelopeCurve(const TargetEnvelope &envelope, std::vector<float> &curve) const
+  {
+    curve.clear();
+    if (envelope.isEmpty())
+      return;
+
+    // The stored curve at this processor's bin frequencies (its last value above the stored
+    // range), with a mean log level of 0 over them: the input's c[0] it is brought to is the mean
+    // over the same range, which for a multi-resolution band is only part of the stored one.
+    const int numBins = fftSize / 2 + 1;
+    const double storedHzPerBin = 0.5 * envelope.sampleRate / (double)(envelope.envelope.size() - 1);
+    const float storedBinsPerBin = (float)(currentSampleRate / (double)fftSize / storedHzPerBin);
+
+    curve.resize((size_t)numBins);
+    double logSum = 0.0;
+    for (int k = 0; k < numBins; ++k)
+    {
+      curve[(size_t)k] = std::max(interpolateBin(envelope.envelope, (float)k * storedBinsPerBin), 1.0e-9f);
+      logSum += std::log((double)curve[(size_t)k]);
+    }
+
+    const float normalization = (float)std::exp(-logSum / (double)numBins);
+    for (auto &value : curve)
+      value *= normalization;
+  }
+
+  void SpectralProcessor::copyFormantTargetsFrom(const SpectralProcessor &other)
+  {
+    // Starts on the targets instead of gliding in from the previous ones.
+    setTargetFormantsHz(other.targetFormantsHz);
+    staticTargetsHz = targetFormantsHz;
+    hopTargetsHz = targetFormantsHz;
+    if (multiResolution != nullptr)
+      multiResolution->snapTargets();
+  }
+
+  void SpectralProcessor::prepareTargetUpdate(TargetUpdate &update, const FormantTrajectory &trajectory, const TargetEnvelope &envelope) const
+  {
+    update.trajectory = trajectory;
+    update.envelope = envelope;
+    buildTargetEnvelopeCurve(envelope, update.envelopeCurve);
+    update.applied = false;
+
+    update.bands.clear();
+    if (multiResolution != nullptr)
+      multiResolution->prepareTargetUpdates(update.bands, trajectory, envelope);
+  }
+
+  bool SpectralProcessor::applyTargetUpdate(TargetUpdate &update)
+  {
+    if (!update.applied)
+    {
+      // Nothing else takes these locks while the switcher owns the processor; never wait anyway.
+      const juce::ScopedTryLock trajectoryScope(trajectoryLock);
+      const juce::ScopedTryLock envelopeScope(targetEnvelopeLock);
+      if (!trajectoryScope.isLocked() || !envelopeScope.isLocked())
+        return false;
+
+      std::swap(targetTrajectory, update.trajectory);
+      hasTrajectory = !targetTrajectory.isEmpty();
+      std::swap(targetEnvelope, update.envelope);
+      std::swap(targetEnvelopeCurve, update.envelopeCurve);
+      hasStoredEnvelope = !targetEnvelope.isEmpty();
+
+      if (update.hasFormants)
+        setTargetFormantsHz(update.formantsHz);
+
+      update.applied = true;
+    }
+
+    return multiResolution == nullptr || multiResolution->applyTargetUpdates(update.bands);
+  }
 
-    for (size_t i = 0; i < targetFormantsHz.size(); ++i)
+  int SpectralProcessor::getLatencySamples() const
+  {
+    if (engine == Engine::multiResolution && multiResolution != nullptr)
+      return multiResolution->getLatencySamples();
+
+    return (engine == Engine::lpc || isZeroLatencyActive()) ? 0 : fftSize;
+  }
+
+  void SpectralProcessor::setPlaybackPosition(juce::int64 timeInSamples, bool isPlaying)
+  {
+    playbackPosition = timeInSamples;
+    hostIsPlaying = isPlaying;
+  }
+
+  void SpectralProcessor::updateHopTargets(juce::int64 frameStart, int blockOffset, float glide)
+  {
+    hopFrameStart = frameStart;
+    applyPendingTargetChanges(blockOffset);
+
+    if (crossfadeHopsLeft > 0)
+    {
+      --crossfadeHopsLeft;
+      const float amount = 1.0f - (float)crossfadeHopsLeft / (float)targetCrossfadeHops;
+      for (size_t i = 0; i < numFormants; ++i)
+        staticTargetsHz[i] = crossfadeFromHz[i] + amount * (targetFormantsHz[i] - crossfadeFromHz[i]);
+    }
+    else
     {
-      const float minHz = (i == 0) ? 200.0f : targetFormantsHz[i - 1] + 20.0f;
-      targetFormantsHz[i] = std::max(minHz, targetFormantsHz[i]);
+      // Same coefficient for every formant: the ordering of the targets is kept.
+      for (size_t i = 0; i < numFormants; ++i)
+        staticTargetsHz[i] += glide * (targetFormantsHz[i] - staticTargetsHz[i]);
     }
+    hopTargetsHz = staticTargetsHz;
+
+    if (!hostIsPlaying || !hasTrajectory.load())
+      return;
+
+    // Never block the audio thread: keep the static targets if the trajectory is being replaced.
+    const juce::ScopedTryLock lock(trajectoryLock);
+    if (!lock.isLocked() || targetTrajectory.isEmpty())
+      return;
+
+    const double framePos = (double)frameStart * (targetTrajectory.sampleRate / currentSampleRate) / (double)targetTrajectory.hopSamples;
+    const int lastFrame = (int)targetTrajectory.framesHz.size() - 1;
+    if (framePos < 0.0 || framePos > (double)lastFrame)
+      return;
+
+    const int f0 = (int)framePos;
+    const int f1 = std::min(f0 + 1, lastFrame);
+    const float frac = (float)(framePos - (double)f0);
+
+    const auto &a = targetTrajectory.framesHz[(size_t)f0];
+    const auto &b = targetTrajectory.framesHz[(size_t)f1];
+    for (size_t i = 0; i < numFormants; ++i)
+      hopTargetsHz[i] = a[i] + frac * (b[i] - a[i]);
+
+    enforceFormantOrdering(hopTargetsHz);
   }
 
   void SpectralProcessor::detectFormants(const std::vector<float> &envelope,
+                                         const std::vector<float> &cepstrum,
                                          double sampleRate,
                                          std::array<float, numFormants> &formantBins) const
   {
-    const float hzPerBin = (float)sampleRate / (float)fftSize;
+    const int analysisSize = 2 * ((int)envelope.size() - 1);
+    const float hzPerBin = (float)sampleRate / (float)analysisSize;
     const int minBin = std::max(1, (int)(150.0f / hzPerBin));
     const int maxBin = std::min((int)envelope.size() - 2, (int)(9000.0f / hzPerBin));
     const int minDistanceBins = std::max(2, (int)(120.0f / hzPerBin));
@@ -119,59 +542,126 @@ namespace dsp
       }
 
       formantBins[i] = (float)juce::jlimit(minBin, maxBin, lastBin);
+
+      if (i < selected.size() && lastBin == selected[i])
+      {
+        if (!cepstrum.empty())
+        {
+          // Real peaks: Newton steps on the slope of the continuous cepstral envelope
+          // give sub-bin positions independent of the FFT size.
+          formantBins[i] = refinePeakBin(cepstrum, analysisSize, (float)lastBin, (float)minBin, (float)maxBin);
+        }
+        else
+        {
+          const float below = std::log(std::max(envelope[(size_t)lastBin - 1], 1e-20f));
+          const float centre = std::log(std::max(envelope[(size_t)lastBin], 1e-20f));
+          const float above = std::log(std::max(envelope[(size_t)lastBin + 1], 1e-20f));
+          const float curvature = below - 2.0f * centre + above;
+          if (curvature < 0.0f)
+            formantBins[i] += juce::jlimit(-0.5f, 0.5f, 0.5f * (below - above) / curvature);
+        }
+      }
     }
   }
 
-  std::array<float, SpectralProcessor::numFormants> SpectralProcessor::estimateFormantsFromBuffer(const juce::AudioBuffer<float> &sourceBuffer,
-                                                                                                  double sourceSampleRate)
+  void SpectralProcessor::computeLpcEnvelope(double sampleRate)
   {
-    std::array<float, numFormants> estimatedHz = targetFormantsHz;
+    const int numBins = fftSize / 2 + 1;
+    const int order = juce::jlimit(8, maxLpcOrder, 2 + (int)(sampleRate / 1000.0));
+    lpcEnvelope.resize((size_t)numBins);
 
-    if (sourceBuffer.getNumSamples() <= 0 || sourceBuffer.getNumChannels() <= 0)
-      return estimatedHz;
+    // Power spectrum times |1 - a e^-jw|^2 (pre-emphasis, so the high formants are modelled too)
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    const float piOverH = juce::MathConstants<float>::pi / (float)(numBins - 1);
+    for (int k = 0; k < numBins; ++k)
+    {
+      const float emphasis = 1.0f + lpcPreEmphasis * lpcPreEmphasis - 2.0f * lpcPreEmphasis * std::cos(piOverH * (float)k);
+      fftBuffer[(size_t)k * 2] = magnitudeSpectrum[(size_t)k] * magnitudeSpectrum[(size_t)k] * emphasis;
+    }
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
 
-    std::vector<float> frame((size_t)fftSize, 0.0f);
-    const int totalSamples = sourceBuffer.getNumSamples();
-    const int start = std::max(0, (totalSamples / 2) - (fftSize / 2));
-    const int copyCount = std::min(fftSize, totalSamples - start);
+    std::array<double, maxLpcOrder + 1> r{}, a{}, previous{};
+    for (int lag = 0; lag <= order; ++lag)
+      r[(size_t)lag] = (double)fftBuffer[(size_t)lag];
+
+    if (r[0] <= 1.0e-20)
+    {
+      std::fill(lpcEnvelope.begin(), lpcEnvelope.end(), 1.0f);
+      return;
+    }
 
-    const float *readPtr = sourceBuffer.getReadPointer(0);
-    std::copy(readPtr + start, readPtr + start + copyCount, frame.begin());
+    // White-noise correction (-40 dB) keeps the recursion well conditioned.
+    r[0] *= 1.0001;
 
-    window->multiplyWithWindowingTable(frame.data(), fftSize);
+    // Levinson-Durbin
+    a[0] = 1.0;
+    double error = r[0];
+    for (int m = 1; m <= order && error > 0.0; ++m)
+    {
+      double acc = r[(size_t)m];
+      for (int i = 1; i < m; ++i)
+        acc += a[(size_t)i] * r[(size_t)(m - i)];
 
-    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
-    std::copy(frame.begin(), frame.end(), fftBuffer.begin());
+      const double k = -acc / error;
+      previous = a;
+      for (int i = 1; i < m; ++i)
+        a[(size_t)i] = previous[(size_t)i] + k * previous[(size_t)(m - i)];
+      a[(size_t)m] = k;
+      error *= 1.0 - k * k;
+    }
 
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    for (int i = 0; i <= order; ++i)
+      fftBuffer[(size_t)i] = (float)a[(size_t)i];
     fft->performRealOnlyForwardTransform(fftBuffer.data());
 
-    const int numBins = fftSize / 2 + 1;
-    for (int i = 0; i < numBins; ++i)
+    for (int k = 0; k < numBins; ++k)
     {
-      const float real = fftBuffer[(size_t)i * 2];
-      const float imag = fftBuffer[(size_t)i * 2 + 1];
-      magnitudeSpectrum[(size_t)i] = std::sqrt(real * real + imag * imag);
+      const float real = fftBuffer[(size_t)k * 2];
+      const float imag = fftBuffer[(size_t)k * 2 + 1];
+      lpcEnvelope[(size_t)k] = 1.0f / std::sqrt(std::max(real * real + imag * imag, 1.0e-20f));
     }
+  }
 
-    envelopeExtractor.process(magnitudeSpectrum, extractedEnvelope);
+  float SpectralProcessor::refinePeakBin(const std::vector<float> &cepstrum, int analysisSize, float bin, float minBin, float maxBin) const
+  {
+    const float start = bin;
+    for (int iteration = 0; iteration < peakRefinementIterations; ++iteration)
+    {
+      float slope = 0.0f;
+      float curvature = 0.0f;
+      EnvelopeExtractor::evaluateLogEnvelope(cepstrum, analysisSize, bin, slope, curvature);
 
-    std::array<float, numFormants> bins{};
-    detectFormants(extractedEnvelope, sourceSampleRate, bins);
+      // Only climb a maximum (negative curvature); the grid peak is within half a bin of it.
+      if (curvature >= 0.0f)
+        break;
 
-    const float hzPerBin = (float)sourceSampleRate / (float)fftSize;
-    for (size_t i = 0; i < numFormants; ++i)
-      estimatedHz[i] = bins[i] * hzPerBin;
+      bin = juce::jlimit(start - 1.0f, start + 1.0f, bin - slope / curvature);
+    }
 
-    return estimatedHz;
+    return juce::jlimit(minBin, maxBin, bin);
   }
 
-  void SpectralProcessor::processBlock(std::vector<float> &data)
+  void SpectralProcessor::detectLiveFormants()
   {
-    // --- Analysis ---
-    window->multiplyWithWindowingTable(data.data(), fftSize);
+    if (analysisPadding == 1)
+    {
+      detectFormants(extractedEnvelope, envelopeExtractor.getEnvelopeCepstrum(), currentSampleRate, currentFormantBins);
+      return;
+    }
 
-    std::copy(data.begin(), data.end(), fftBuffer.begin());
-    std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+    // Peaks picked on the padded grid (closer formants stay apart), then in bins of fftSize
+    detectFormants(paddedEnvelope, paddedEnvelopeExtractor.getEnvelopeCepstrum(), currentSampleRate, currentFormantBins);
+    for (auto &bin : currentFormantBins)
+      bin /= (float)analysisPadding;
+  }
+
+  void SpectralProcessor::analyzeFrame(const float *samples, int numSamples)
+  {
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    std::copy(samples, samples + std::min(fftSize, numSamples), fftBuffer.begin());
+
+    window->multiplyWithWindowingTable(fftBuffer.data(), fftSize);
 
     fft->performRealOnlyForwardTransform(fftBuffer.data());
 
@@ -183,112 +673,924 @@ namespace dsp
       magnitudeSpectrum[(size_t)i] = std::sqrt(real * real + imag * imag);
     }
 
-    // --- Envelope Extraction (Cepstral) ---
     envelopeExtractor.process(magnitudeSpectrum, extractedEnvelope);
+  }
 
-    // --- Formant Detection & Warping ---
-    detectFormants(extractedEnvelope, currentSampleRate, currentFormantBins);
-
-    std::vector<WarpingPoint> points;
-    points.reserve(numFormants + 2);
-    points.push_back({0.0f, 0.0f});
+  std::array<float, SpectralProcessor::numFormants> SpectralProcessor::estimateFormantsFromBuffer(const juce::AudioBuffer<float> &sourceBuffer,
+                                                                                                  double sourceSampleRate)
+  {
+    std::array<float, numFormants> estimatedHz = targetFormantsHz;
 
-    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
-    float lastDst = 0.0f;
-    for (size_t i = 0; i < numFormants; ++i)
-    {
-      const float src = currentFormantBins[i];
-      const float targetBin = targetFormantsHz[i] / std::max(1.0f, hzPerBin);
-      const float dst = juce::jlimit(lastDst + 1.0f, (float)(numBins - 2), targetBin);
-      points.push_back({src, dst});
-      lastDst = dst;
-    }
+    if (sourceBuffer.getNumSamples() <= 0 || sourceBuffer.getNumChannels() <= 0)
+      return estimatedHz;
 
-    points.push_back({(float)(numBins - 1), (float)(numBins - 1)});
+    const int totalSamples = sourceBuffer.getNumSamples();
+    const int start = std::max(0, (totalSamples / 2) - (fftSize / 2));
+    const int copyCount = std::min(fftSize, totalSamples - start);
 
-    formantWarper.calculateWarpMap(numBins, points);
-    formantWarper.process(extractedEnvelope, warpedEnvelope);
+    analyzeFrame(sourceBuffer.getReadPointer(0) + start, copyCount);
+    computeLpcEnvelope(sourceSampleRate);
 
-    // --- Visualization data (lock-free tryEnter) ---
-    if (visualizationLock.tryEnter())
-    {
-      visSpectrum = magnitudeSpectrum;
-      visEnvelope = warpedEnvelope;
-      visF1 = points[1].dstBin;
-      visF2 = points[2].dstBin;
-      visualizationLock.exit();
-    }
+    std::array<float, numFormants> bins{};
+    detectFormants(lpcEnvelope, {}, sourceSampleRate, bins);
 
-    // --- Apply warped envelope (Source-Filter resynthesis) ---
-    // Scale = warpedEnv / originalEnv, clamped to prevent extreme amplification.
-    const float maxGainLinear = std::pow(10.0f, maxEnvelopeGainDb / 20.0f);
-    for (int i = 0; i < numBins; ++i)
-    {
-      const float originalEnv = std::max(extractedEnvelope[(size_t)i], 1e-7f);
-      const float warpedVal = std::max(warpedEnvelope[(size_t)i], 1e-9f);
-      const float scale = juce::jlimit(0.0f, maxGainLinear, warpedVal / originalEnv);
+    const float hzPerBin = (float)sourceSampleRate / (float)fftSize;
+    for (size_t i = 0; i < numFormants; ++i)
+      estimatedHz[i] = bins[i] * hzPerBin;
 
-      fftBuffer[(size_t)i * 2] *= scale;
-      fftBuffer[(size_t)i * 2 + 1] *= scale;
-    }
+    return estimatedHz;
+  }
 
-    // --- Synthesis (IFFT + window) ---
-    fft->performRealOnlyInverseTransform(fftBuffer.data());
+  SpectralProcessor::FormantTrajectory SpectralProcessor::analyzeFormantTrajectory(const juce::AudioBuffer<float> &sourceBuffer,
+                                                                                    double sourceSampleRate)
+  {
+    FormantTrajectory trajectory;
+    trajectory.sampleRate = sourceSampleRate;
+    trajectory.hopSamples = trajectoryHopSize;
 
-    // Normalize: JUCE IFFT does not divide by N.
-    // Combined with overlap-add of Hann^2 (= 1.5), total normalization = 1/(N * 1.5)
-    const float normFactor = 1.0f / ((float)fftSize * overlapAddSum);
-    for (int i = 0; i < fftSize; ++i)
-      fftBuffer[(size_t)i] *= normFactor;
+    const int totalSamples = sourceBuffer.getNumSamples();
+    if (totalSamples <= 0 || sourceBuffer.getNumChannels() <= 0)
+      return trajectory;
 
-    window->multiplyWithWindowingTable(fftBuffer.data(), fftSize);
+    const int numFrames = getNumTrajectoryFrames(totalSamples);
+    trajectory.framesHz.resize((size_t)numFrames);
+    trajectory.energyDb.resize((size_t)numFrames);
 
-    for (int i = 0; i < fftSize; ++i)
-      data[(size_t)i] = fftBuffer[(size_t)i];
+    analyzeTrajectoryFrames(sourceBuffer.getReadPointer(0), totalSamples, sourceSampleRate, 0, numFrames, trajectory, nullptr);
+    return trajectory;
   }
 
-  void SpectralProcessor::process(const juce::dsp::ProcessContextReplacing<float> &context)
+  void SpectralProcessor::analyzeTrajectoryFrames(const float *samples, int totalSamples, double sourceSampleRate,
+                                                  int firstFrame, int numFrames, FormantTrajectory &trajectory, float *frameCepstra)
   {
-    const auto &inputBlock = context.getInputBlock();
-    auto &outputBlock = context.getOutputBlock();
-    const size_t numSamples = inputBlock.getNumSamples();
-    const size_t numChannels = inputBlock.getNumChannels();
+    const float hzPerBin = (float)sourceSampleRate / (float)fftSize;
+    const int firstSample = firstFrame * trajectoryHopSize;
 
-    auto *src = inputBlock.getChannelPointer(0);
-    auto *dst = outputBlock.getChannelPointer(0);
+    std::array<float, numFormants> bins{};
+    for (int f = firstFrame; f < firstFrame + numFrames; ++f)
+    {
+      const int start = f * trajectoryHopSize;
+      const int count = std::min(fftSize, totalSamples - start);
+      const float *frame = samples + (start - firstSample);
+
+      float sumSquares = 0.0f;
+      for (int k = 0; k < count; ++k)
+        sumSquares += frame[k] * frame[k];
+
+      analyzeFrame(frame, count);
+      computeLpcEnvelope(sourceSampleRate);
+      detectFormants(lpcEnvelope, {}, sourceSampleRate, bins);
+
+      for (size_t i = 0; i < numFormants; ++i)
+        trajectory.framesHz[(size_t)f][i] = bins[i] * hzPerBin;
+
+      trajectory.energyDb[(size_t)f] = juce::Decibels::gainToDecibels(std::sqrt(sumSquares / (float)fftSize), -100.0f);
+
+      if (frameCepstra != nullptr)
+      {
+        const auto &cepstrum = envelopeExtractor.getEnvelopeCepstrum();
+        std::copy(cepstrum.begin(), cepstrum.end(), frameCepstra + (size_t)(f - firstFrame) * frameCepstrumSize);
+      }
+    }
+  }
+
+  SpectralProcessor::TargetEnvelope SpectralProcessor::analyzeAverageEnvelope(const juce::AudioBuffer<float> &sourceBuffer,
+                                                                             double sourceSampleRate)
+  {
+    TargetEnvelope result;
+    result.sampleRate = sourceSampleRate;
+
+    const int totalSamples = sourceBuffer.getNumSamples();
+    if (totalSamples <= 0 || sourceBuffer.getNumChannels() <= 0)
+      return result;
+
+    const int numFrames = getNumTrajectoryFrames(totalSamples);
+    FormantTrajectory trajectory;
+    trajectory.sampleRate = sourceSampleRate;
+    trajectory.hopSamples = trajectoryHopSize;
+    trajectory.framesHz.resize((size_t)numFrames);
+    trajectory.energyDb.resize((size_t)numFrames);
+    std::vector<float> frameCepstra((size_t)numFrames * frameCepstrumSize);
+
+    analyzeTrajectoryFrames(sourceBuffer.getReadPointer(0), totalSamples, sourceSampleRate, 0, numFrames, trajectory, frameCepstra.data());
+    return averageEnvelopeFromFrames(trajectory, frameCepstra);
+  }
+
+  SpectralProcessor::TargetEnvelope SpectralProcessor::averageEnvelopeFromFrames(const FormantTrajectory &trajectory,
+                                                                                const std::vector<float> &frameCepstra) const
+  {
+    TargetEnvelope result;
+    result.sampleRate = trajectory.sampleRate;
+
+    const auto &frameDb = trajectory.energyDb;
+    if (frameDb.empty())
+      return result;
 
-    for (size_t i = 0; i < numSamples; ++i)
+    // Only frames within 30 dB of the loudest, so silence and breaths do not pull the average down.
+    const float gateDb = *std::max_element(frameDb.begin(), frameDb.end()) - 30.0f;
+
+    // The log envelope is linear in the cepstral coefficients, so averaging those averages the curve.
+    std::vector<float> averageCepstrum((size_t)frameCepstrumSize, 0.0f);
+    int numAveraged = 0;
+    for (size_t f = 0; f < frameDb.size(); ++f)
     {
-      // Write new input sample into circular buffer
-      inputFifo[(size_t)inputWritePos] = src[i];
+      if (frameDb[f] < gateDb)
+        continue;
+
+      const float *cepstrum = frameCepstra.data() + f * frameCepstrumSize;
+      for (size_t q = 0; q < averageCepstrum.size(); ++q)
+        averageCepstrum[q] += cepstrum[q];
+      ++numAveraged;
+    }
+
+    if (numAveraged == 0)
+      return result;
+
+    for (auto &c : averageCepstrum)
+      c /= (float)numAveraged;
+    averageCepstrum[0] = 0.0f; // Mean log level 0; the input's level is applied per hop
+
+    const int numBins = fftSize / 2 + 1;
+    result.envelope.resize((size_t)numBins);
+    float slope = 0.0f;
+    float curvature = 0.0f;
+    for (int k = 0; k < numBins; ++k)
+      result.envelope[(size_t)k] = std::exp(EnvelopeExtractor::evaluateLogEnvelope(averageCepstrum, fftSize, (float)k, slope, curvature));
+
+    std::array<float, numFormants> bins{};
+    detectFormants(result.envelope, averageCepstrum, trajectory.sampleRate, bins);
+
+    const float hzPerBin = (float)trajectory.sampleRate / (float)fftSize;
+    for (size_t i = 0; i < numFormants; ++i)
+      result.formantsHz[i] = bins[i] * hzPerBin;
+
+    return result;
+  }
+
+  SpectralProcessor::FormantTrajectory SpectralProcessor::alignTrajectory(const FormantTrajectory &guide,
+                                                                           const FormantTrajectory &take,
+                                                                           double bandRadiusSeconds)
+  {
+    FormantTrajectory aligned;
+    aligned.sampleRate = take.sampleRate;
+    aligned.hopSamples = take.hopSamples;
+
+    if (guide.isEmpty() || take.isEmpty())
+      return aligned;
+
+    // Features: log2 frequency of F1-F4 (articulation) and frame level (phrasing).
+    // Higher formants are mostly spacing fill-ins from the detector and would only add noise.
+    constexpr int numTrackedFormants = 4;
+    const std::vector<float> weights{1.0f, 1.0f, 0.5f, 0.5f, 0.25f};
+    const int numDims = (int)weights.size();
+
+    auto buildFeatures = [&](const FormantTrajectory &t)
+    {
+      const int frames = (int)t.framesHz.size();
+      std::vector<float> features((size_t)(numDims * frames));
+      for (int f = 0; f < frames; ++f)
+      {
+        for (int d = 0; d < numTrackedFormants; ++d)
+          features[(size_t)(d * frames + f)] = std::log2(std::max(1.0f, t.framesHz[(size_t)f][(size_t)d]));
+
+        const float db = (size_t)f < t.energyDb.size() ? t.energyDb[(size_t)f] : 0.0f;
+        features[(size_t)(numTrackedFormants * frames + f)] = db / 20.0f;
+      }
+      return features;
+    };
+
+    const int guideFrames = (int)guide.framesHz.size();
+    const int takeFrames = (int)take.framesHz.size();
+    const int bandRadius = std::max(8, (int)(bandRadiusSeconds * guide.sampleRate / (double)guide.hopSamples));
+
+    TrajectoryAligner aligner;
+    const auto path = aligner.align(buildFeatures(guide), guideFrames, buildFeatures(take), takeFrames, weights, bandRadius);
+
+    aligned.framesHz.resize(path.size());
+    aligned.energyDb = take.energyDb;
+
+    for (size_t j = 0; j < path.size(); ++j)
+    {
+      const int g0 = juce::jlimit(0, guideFrames - 1, (int)path[j]);
+      const int g1 = std::min(g0 + 1, guideFrames - 1);
+      const float frac = path[j] - (float)g0;
+
+      for (size_t i = 0; i < numFormants; ++i)
+      {
+        const float a = guide.framesHz[(size_t)g0][i];
+        const float b = guide.framesHz[(size_t)g1][i];
+        aligned.framesHz[j][i] = a + frac * (b - a);
+      }
+    }
+
+    return aligned;
+  }
+
+  void SpectralProcessor::setGlobalScale(bool enabled, float ratio, float blendToFormants)
+  {
+    globalScaleEnabled = enabled;
+    globalScaleRatio = juce::jlimit(0.25f, 4.0f, ratio);
+    globalScaleBlend = juce::jlimit(0.0f, 1.0f, blendToFormants);
+  }
+
+  void SpectralProcessor::buildFormantWarpPoints(int numBins)
+  {
+    warpPoints.clear();
+    warpPoints.push_back({0.0f, 0.0f});
+
+    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
+    float lastDst = 0.0f;
+    for (size_t i = 0; i < numFormants; ++i)
+    {
+      // Small FFTs / low rates: the remaining targets don't fit below the top bin.
+      if (lastDst + 1.0f > (float)(numBins - 2))
+        break;
+
+      const float src = currentFormantBins[i];
+      const float targetBin = hopTargetsHz[i] / std::max(1.0f, hzPerBin);
+      const float dst = juce::jlimit(lastDst + 1.0f, (float)(numBins - 2), targetBin);
+      warpPoints.push_back({src, dst});
+      lastDst = dst;
+    }
+
+    warpPoints.push_back({(float)(numBins - 1), (float)(numBins - 1)});
+  }
+
+  bool SpectralProcessor::computeWarpedEnvelope(int numBins)
+  {
+    if (fullEnvelopeTarget && hasStoredEnvelope.load())
+    {
+      // Never block the audio thread: fall back to the formant targets while the envelope is replaced.
+      const juce::ScopedTryLock lock(targetEnvelopeLock);
+      if (lock.isLocked() && !targetEnvelopeCurve.empty())
+      {
+        detectLiveFormants();
+        applyTargetEnvelope(numBins);
+        return true;
+      }
+    }
+
+    if (globalScaleEnabled)
+    {
+      // Closed-form map, rebuilt only when the ratio changes.
+      if (globalScaleRatio != globalScaleMapRatio)
+      {
+        globalScaleWarper.calculateScaleWarpMap(numBins, globalScaleRatio);
+        globalScaleMapRatio = globalScaleRatio;
+      }
+
+      // Pure scaling needs no peak detection at all.
+      if (globalScaleBlend <= 0.0f)
+      {
+        warpEnvelope(globalScaleWarper);
+        return false;
+      }
+    }
+
+    detectLiveFormants();
+    buildFormantWarpPoints(numBins);
+    formantWarper.calculateWarpMap(numBins, warpPoints);
+
+    if (globalScaleEnabled)
+      formantWarper.blendWarpMap(globalScaleWarper, 1.0f - globalScaleBlend);
+
+    warpEnvelope(formantWarper);
+    return true;
+  }
+
+  void SpectralProcessor::applyTargetEnvelope(int numBins)
+  {
+    // Map output bins (input's formants) onto the stored curve's bins (its own formants); the
+    // curve is on this processor's bins (buildTargetEnvelopeCurve()).
+    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
+    const float lastBin = (float)(numBins - 1);
+
+    warpPoints.clear();
+    warpPoints.push_back({0.0f, 0.0f});
+
+    float lastDst = 0.0f;
+    for (size_t i = 0; i < numFormants; ++i)
+    {
+      if (lastDst + 1.0f > (float)(numBins - 2))
+        break;
+
+      const float src = std::min(lastBin, targetEnvelope.formantsHz[i] / hzPerBin);
+      const float dst = juce::jlimit(lastDst + 1.0f, (float)(numBins - 2), currentFormantBins[i]);
+      warpPoints.push_back({src, dst});
+      lastDst = dst;
+    }
+
+    warpPoints.push_back({lastBin, lastBin});
+
+    formantWarper.calculateWarpMap(numBins, warpPoints);
+    formantWarper.process(targetEnvelopeCurve, warpedEnvelope);
+
+    // The stored curve has a mean log level of 0; the input's mean log level is its c[0].
+    const float level = std::exp(juce::jlimit(-20.0f, 20.0f, liveEnvelopeExtractor().getEnvelopeCepstrum()[0]));
+    for (auto &value : warpedEnvelope)
+      value *= level;
+  }
+
+  void SpectralProcessor::warpEnvelope(FormantWarper &warper)
+  {
+    if (!cepstralWarp)
+    {
+      warper.process(extractedEnvelope, warpedEnvelope);
+      return;
+    }
+
+    // Warp the coefficients, then evaluate only the difference: warped = original * exp(c' - c)
+    const auto &cepstrum = liveEnvelopeExtractor().getEnvelopeCepstrum();
+    cepstralWarper.setWarpMap(warper.getWarpMap());
+    cepstralWarper.warp(cepstrum, warpedCepstrum);
+
+    for (size_t q = 0; q < warpedCepstrum.size(); ++q)
+      warpedCepstrum[q] -= cepstrum[q];
+
+    cepstralWarper.evaluate(warpedCepstrum, cepstralLogScale);
+
+    const size_t numBins = warpedEnvelope.size();
+    for (size_t k = 0; k < numBins; ++k)
+      warpedEnvelope[k] = extractedEnvelope[k] * std::exp(juce::jlimit(-20.0f, 20.0f, cepstralLogScale[k]));
+  }
+
+  void SpectralProcessor::detectFormantsInBands(const std::vector<float> &bands,
+                                                std::array<float, numFormants> &formantBins) const
+  {
+    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
+    const int numBins = fftSize / 2 + 1;
+    const float minBin = std::max(1.0f, 150.0f / hzPerBin);
+    const float maxBin = std::min((float)(numBins - 2), 9000.0f / hzPerBin);
+    const float minDistanceBins = std::max(2.0f, 120.0f / hzPerBin);
+
+    const int firstBand = std::max(1, (int)std::ceil(bandEnvelope.hzToBand(150.0f)));
+    const int lastBand = std::min(BandEnvelope::numBands - 2, (int)bandEnvelope.hzToBand(9000.0f));
+
+    struct Peak
+    {
+      float band = 0.0f;
+      float bin = 0.0f;
+      float mag = 0.0f;
+    };
+
+    // Local maxima, refined with a parabola through the neighbouring log values
+    // (a band spans several bins, so the integer band centre alone is too coarse).
+    std::array<Peak, BandEnvelope::numBands> candidates{};
+    size_t numCandidates = 0;
+    for (int b = firstBand; b <= lastBand; ++b)
+    {
+      const float v = bands[(size_t)b];
+      if (!(v > bands[(size_t)b - 1] && v >= bands[(size_t)b + 1]))
+        continue;
+
+      const float l = std::log(std::max(bands[(size_t)b - 1], 1e-9f));
+      const float c = std::log(std::max(v, 1e-9f));
+      const float r = std::log(std::max(bands[(size_t)b + 1], 1e-9f));
+      const float denom = l - 2.0f * c + r;
+      const float offset = denom < 0.0f ? juce::jlimit(-0.5f, 0.5f, 0.5f * (l - r) / denom) : 0.0f;
+
+      candidates[numCandidates++] = {(float)b + offset, bandEnvelope.bandToBin((float)b + offset), v};
+    }
+
+    std::sort(candidates.begin(), candidates.begin() + (std::ptrdiff_t)numCandidates, [](const Peak &a, const Peak &b)
+              { return a.mag > b.mag; });
+
+    // Same minimum spacing as detectFormants(), in band units: 120 Hz above the lower peak, and
+    // never less than one band, the resolution of the band envelope (refined maxima of one broad
+    // peak can end up a single band apart).
+    const auto minDistanceBands = [this](float lowerBand)
+    {
+      const float hz = bandEnvelope.bandToHz(lowerBand);
+      return std::max(1.0f, bandEnvelope.hzToBand(hz + 120.0f) - lowerBand);
+    };
+
+    std::array<Peak, numFormants> selected{};
+    size_t numSelected = 0;
+    for (size_t i = 0; i < numCandidates && numSelected < numFormants; ++i)
+    {
+      const auto &peak = candidates[i];
+      if (peak.bin < minBin || peak.bin > maxBin)
+        continue;
+
+      bool tooClose = false;
+      for (size_t j = 0; j < numSelected && !tooClose; ++j)
+      {
+        const float lowerBand = std::min(peak.band, selected[j].band);
+        tooClose = std::abs(peak.band - selected[j].band) < minDistanceBands(lowerBand);
+      }
+
+      if (!tooClose)
+        selected[numSelected++] = peak;
+    }
+
+    std::sort(selected.begin(), selected.begin() + (std::ptrdiff_t)numSelected, [](const Peak &a, const Peak &b)
+              { return a.band < b.band; });
+
+    // Same fill-in as detectFormants(): missing formants continue above the last one found.
+    float lastBin = minBin;
+    for (size_t i = 0; i < numFormants; ++i)
+    {
+      if (i < numSelected)
+        lastBin = std::max(lastBin + (i == 0 ? 0.0f : minDistanceBins * 0.5f), selected[i].bin);
+      else
+        lastBin = std::min(maxBin, lastBin + minDistanceBins);
+
+      formantBins[i] = juce::jlimit(minBin, maxBin, lastBin);
+    }
+  }
+
+  bool SpectralProcessor::computeWarpedBandEnvelope(int numBins)
+  {
+    constexpr int numBands = BandEnvelope::numBands;
+    bandEnvelope.project(magnitudeSpectrum, bandSpectrum);
+
+    if (globalScaleEnabled && globalScaleRatio != bandScaleMapRatio)
+    {
+      // A uniform frequency scale is not uniform in band index: one control point per band centre.
+      bandWarpPoints.clear();
+      for (int b = 0; b < numBands; ++b)
+        bandWarpPoints.push_back({bandEnvelope.hzToBand(bandEnvelope.bandToHz((float)b) / globalScaleRatio), (float)b});
+
+      bandScaleWarper.calculateWarpMap(numBands, bandWarpPoints);
+      bandScaleMapRatio = globalScaleRatio;
+    }
+
+    bool formantsDetected = false;
+    if (globalScaleEnabled && globalScaleBlend <= 0.0f)
+    {
+      bandScaleWarper.process(bandSpectrum, warpedBandSpectrum);
+    }
+    else
+    {
+      detectFormantsInBands(bandSpectrum, currentFormantBins);
+      buildFormantWarpPoints(numBins);
+
+      // The bin-domain points (also used by the visualization) moved onto the band index
+      bandWarpPoints.clear();
+      for (const auto &point : warpPoints)
+        bandWarpPoints.push_back({bandEnvelope.binToBand(point.srcBin), bandEnvelope.binToBand(point.dstBin)});
+
+      bandWarper.calculateWarpMap(numBands, bandWarpPoints);
+      if (globalScaleEnabled)
+        bandWarper.blendWarpMap(bandScaleWarper, 1.0f - globalScaleBlend);
+
+      bandWarper.process(bandSpectrum, warpedBandSpectrum);
+      formantsDetected = true;
+    }
+
+    // Back to bins once, for the resynthesis paths
+    bandEnvelope.expandToBins(bandSpectrum, extractedEnvelope);
+    bandEnvelope.expandToBins(warpedBandSpectrum, warpedEnvelope);
+    return formantsDetected;
+  }
+
+  void SpectralProcessor::analyzeHop(std::vector<float> &data)
+  {
+    // Learn mode: frame energy before windowing
+    const bool recording = formantRecorder != nullptr && formantRecorder->isRecording();
+    float meanSquare = 0.0f;
+    if (recording)
+    {
+      for (int k = 0; k < fftSize; ++k)
+        meanSquare += data[(size_t)k] * data[(size_t)k];
+      meanSquare /= (float)fftSize;
+    }
+
+    // --- Analysis ---
+    window->multiplyWithWindowingTable(data.data(), fftSize);
+
+    std::copy(data.begin(), data.end(), fftBuffer.begin());
+    std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+
+    fft->performRealOnlyForwardTransform(fftBuffer.data());
+
+    const int numBins = fftSize / 2 + 1;
+    for (int i = 0; i < numBins; ++i)
+    {
+      const float real = fftBuffer[(size_t)i * 2];
+      const float imag = fftBuffer[(size_t)i * 2 + 1];
+      magnitudeSpectrum[(size_t)i] = std::sqrt(real * real + imag * imag);
+    }
+
+    // --- Envelope Extraction & Formant Detection & Warping ---
+    bool formantsDetected = false;
+    if (isBandModeActive())
+    {
+      formantsDetected = computeWarpedBandEnvelope(numBins);
+    }
+    else if (analysisPadding > 1)
+    {
+      // Envelope on the padded grid; the bins of fftSize are every analysisPadding-th of it.
+      paddedSpectrum.process(data.data(), magnitudeSpectrum, paddedMagnitude);
+      paddedEnvelopeExtractor.process(paddedMagnitude, paddedEnvelope);
+      for (int i = 0; i < numBins; ++i)
+        extractedEnvelope[(size_t)i] = paddedEnvelope[(size_t)(i * analysisPadding)];
+
+      formantsDetected = computeWarpedEnvelope(numBins);
+    }
+    else
+    {
+      envelopeExtractor.process(magnitudeSpectrum, extractedEnvelope);
+      formantsDetected = computeWarpedEnvelope(numBins);
+    }
+    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
+
+    if (recording)
+      recordHop(meanSquare, formantsDetected);
+
+    // --- Visualization data (lock-free tryEnter) ---
+    if (visualizationLock.tryEnter())
+    {
+      visSpectrum = magnitudeSpectrum;
+      visEnvelope = warpedEnvelope;
+      if (formantsDetected)
+      {
+        visF1 = warpPoints[1].dstBin;
+        visF2 = warpPoints[2].dstBin;
+        for (size_t i = 0; i < numFormants; ++i)
+          visDetectedHz[i] = currentFormantBins[i] * hzPerBin;
+      }
+      visualizationLock.exit();
+    }
+  }
+
+  void SpectralProcessor::recordHop(float meanSquare, bool formantsDetected)
+  {
+    FormantRecorder::Hop hop;
+    hop.timeInSamples = hopFrameStart;
+    hop.flags = (juce::uint8)((formantsDetected ? FormantRecorder::Hop::detected : 0)
+                              | (hostIsPlaying ? FormantRecorder::Hop::hostPlaying : 0));
+
+    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
+    for (size_t i = 0; i < numFormants; ++i)
+      hop.halfHz[i] = (juce::uint16)juce::jlimit(0, 65535, juce::roundToInt(2.0f * currentFormantBins[i] * hzPerBin));
+
+    const float energyDb = juce::Decibels::gainToDecibels(std::sqrt(meanSquare), -100.0f);
+    hop.energyCentiDb = (juce::int16)juce::roundToInt(100.0f * energyDb);
+
+    // Same voicing measure as the sinusoidal engine; band envelope mode has no cepstrum.
+    if (!isBandModeActive())
+    {
+      float prominence = 0.0f;
+      liveEnvelopeExtractor().estimatePitchPeriod((int)(currentSampleRate / sinusoidalMaxF0Hz),
+                                            (int)(currentSampleRate / sinusoidalMinF0Hz),
+                                            prominence);
+      const float voicing = juce::jlimit(0.0f, 1.0f, (prominence - voicingProminenceFloor) / voicingProminenceRange);
+      hop.voicing = (juce::uint8)juce::roundToInt(255.0f * voicing);
+    }
+
+    formantRecorder->push(hop);
+  }
+
+  void SpectralProcessor::computeEnvelopeScale(std::vector<float> &scale) const
+  {
+    // Scale = warpedEnv / originalEnv, clamped to prevent extreme amplification.
+    const float maxGainLinear = std::pow(10.0f, maxEnvelopeGainDb / 20.0f);
+    const int numBins = fftSize / 2 + 1;
+    for (int i = 0; i < numBins; ++i)
+    {
+      const float originalEnv = std::max(extractedEnvelope[(size_t)i], 1e-7f);
+      const float warpedVal = std::max(warpedEnvelope[(size_t)i], 1e-9f);
+      scale[(size_t)i] = juce::jlimit(0.0f, maxGainLinear, warpedVal / originalEnv);
+    }
+  }
+
+  bool SpectralProcessor::processBlock(std::vector<float> &data)
+  {
+    analyzeHop(data);
+
+    const int numBins = fftSize / 2 + 1;
+
+    if (engine == Engine::sinusoidal)
+    {
+      const bool pitchShifted = std::abs(pitchRatio - 1.0f) >= 1.0e-4f;
+      if (!synthesizeSinusoidalFrame((pitchShifted && pitchUsesOriginalFormants) ? extractedEnvelope : warpedEnvelope))
+        return false;
+    }
+    else if (std::abs(pitchRatio - 1.0f) >= 1.0e-4f)
+    {
+      applyPitchShiftedResynthesis(pitchUsesOriginalFormants ? extractedEnvelope : warpedEnvelope);
+    }
+    else
+    {
+      // --- Apply warped envelope (Source-Filter resynthesis) ---
+      computeEnvelopeScale(envelopeScale);
+      for (int i = 0; i < numBins; ++i)
+      {
+        fftBuffer[(size_t)i * 2] *= envelopeScale[(size_t)i];
+        fftBuffer[(size_t)i * 2 + 1] *= envelopeScale[(size_t)i];
+      }
+    }
+
+    // --- Synthesis (IFFT + window) ---
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    // Normalize: JUCE IFFT does not divide by N.
+    // Combined with overlap-add of Hann^2 (= 1.5), total normalization = 1/(N * 1.5)
+    const float normFactor = 1.0f / ((float)fftSize * overlapAddSum);
+    for (int i = 0; i < fftSize; ++i)
+      fftBuffer[(size_t)i] *= normFactor;
+
+    window->multiplyWithWindowingTable(fftBuffer.data(), fftSize);
+
+    for (int i = 0; i < fftSize; ++i)
+      data[(size_t)i] = fftBuffer[(size_t)i];
+
+    return true;
+  }
+
+  void SpectralProcessor::processZeroLatency(const float *input, float *output, int numSamples)
+  {
+    for (int i = 0; i < numSamples; ++i)
+    {
+      const float x = input[i];
+      inputFifo[(size_t)inputWritePos] = x;
       inputWritePos = (inputWritePos + 1) % fftSize;
 
-      // Read output sample from circular accumulator
-      dst[i] = outputAccumulator[(size_t)outputReadPos];
-      outputAccumulator[(size_t)outputReadPos] = 0.0f;
-      outputReadPos = (outputReadPos + 1) % fftSize;
+      // Audible path: the dry input through the current filter, no delay
+      output[i] = zeroLatencyConvolver.processSample(x);
 
       ++hopCounter;
       if (hopCounter >= hopSize)
       {
         hopCounter = 0;
 
-        // Assemble frame from circular input buffer (oldest to newest)
-        std::vector<float> frame((size_t)fftSize);
+        updateHopTargets(playbackPosition + (juce::int64)i + 1 - fftSize, (int)i + 1, stftTargetGlide);
+
         for (int k = 0; k < fftSize; ++k)
-          frame[(size_t)k] = inputFifo[(size_t)((inputWritePos + k) % fftSize)];
+          hopFrame[(size_t)k] = inputFifo[(size_t)((inputWritePos + k) % fftSize)];
 
-        processBlock(frame);
+        // Side path: same analysis and warp as the STFT engine, turned into the next filter
+        analyzeHop(hopFrame);
+        computeEnvelopeScale(envelopeScale);
+        for (auto &gain : envelopeScale)
+          gain *= stftUnityGain;
 
-        // Overlap-add into circular output accumulator
-        for (int k = 0; k < fftSize; ++k)
+        zeroLatencyConvolver.setMagnitudeResponse(envelopeScale);
+      }
+    }
+  }
+
+  void SpectralProcessor::processLpc(float *samples, int numSamples)
+  {
+    int done = 0;
+    while (done < numSamples)
+    {
+      if (lpcShifter.getSamplesUntilFrame() == 0)
+      {
+        // The analysis window ends at the current sample: no latency to compensate.
+        updateHopTargets(playbackPosition + done, done, lpcTargetGlide);
+
+        const float scaleWeight = globalScaleEnabled ? 1.0f - globalScaleBlend : 0.0f;
+        lpcShifter.analyzeFrame(hopTargetsHz.data(), (int)numFormants, globalScaleRatio, scaleWeight);
+
+        if (visualizationLock.tryEnter())
+        {
+          lpcShifter.getDetectedFormantsHz(visDetectedHz.data(), (int)numFormants);
+          visualizationLock.exit();
+        }
+      }
+
+      const int chunk = std::min(numSamples - done, lpcShifter.getSamplesUntilFrame());
+      lpcShifter.process(samples + done, chunk);
+      done += chunk;
+    }
+  }
+
+  float SpectralProcessor::interpolateBin(const std::vector<float> &spectrum, float bin)
+  {
+    const int lastBin = (int)spectrum.size() - 1;
+    bin = juce::jlimit(0.0f, (float)lastBin, bin);
+    const int b0 = (int)bin;
+    const int b1 = std::min(b0 + 1, lastBin);
+    const float frac = bin - (float)b0;
+    return spectrum[(size_t)b0] + frac * (spectrum[(size_t)b1] - spectrum[(size_t)b0]);
+  }
+
+  bool SpectralProcessor::synthesizeSinusoidalFrame(const std::vector<float> &outputEnvelope)
+  {
+    const int numBins = fftSize / 2 + 1;
+    const float hzPerBin = (float)currentSampleRate / (float)fftSize;
+    const float maxGainLinear = std::pow(10.0f, maxEnvelopeGainDb / 20.0f);
+
+    // Same gain ceiling as the STFT path, relative to the input's own envelope.
+    for (int k = 0; k < numBins; ++k)
+      resynthesisEnvelope[(size_t)k] = std::min(outputEnvelope[(size_t)k], std::max(extractedEnvelope[(size_t)k], 1e-7f) * maxGainLinear);
+
+    // --- F0 and voicing from the cepstrum ---
+    float prominence = 0.0f;
+    const float period = liveEnvelopeExtractor().estimatePitchPeriod((int)(currentSampleRate / sinusoidalMaxF0Hz),
+                                                               (int)(currentSampleRate / sinusoidalMinF0Hz),
+                                                               prominence);
+    const float voicing = juce::jlimit(0.0f, 1.0f, (prominence - voicingProminenceFloor) / voicingProminenceRange);
+    const float f0 = (period > 0.0f && voicing > 0.0f) ? (float)currentSampleRate / period : 0.0f;
+
+    // --- Partial amplitudes ---
+    // Each source harmonic keeps its own flattened level (peak / input envelope), so the glottal
+    // tilt the smooth cepstral envelope misses is preserved. The output envelope is read at the
+    // (possibly pitch shifted) partial frequency.
+    int numPartials = 0;
+    if (f0 > 0.0f)
+    {
+      const float outputF0 = f0 * pitchRatio;
+      const float maxHz = std::min(sinusoidalMaxFrequencyHz, 0.49f * (float)currentSampleRate);
+      numPartials = std::min({sinusoidalMaxPartials, (int)(maxHz / outputF0), (int)(maxHz / f0)});
+
+      for (int k = 0; k < numPartials; ++k)
+      {
+        const float sourceBin = f0 * (float)(k + 1) / hzPerBin;
+        const float outputBin = std::min(outputF0 * (float)(k + 1) / hzPerBin, (float)(numBins - 1));
+
+        const int peakBin = juce::jlimit(1, numBins - 2, (int)std::lround(sourceBin));
+        const float peak = std::max({magnitudeSpectrum[(size_t)peakBin - 1], magnitudeSpectrum[(size_t)peakBin], magnitudeSpectrum[(size_t)peakBin + 1]});
+        const float flat = peak / std::max(interpolateBin(extractedEnvelope, sourceBin), 1e-7f);
+
+        partialAmplitudes[(size_t)k] = voicing * sinusoidAmplitudeScale * flat * interpolateBin(resynthesisEnvelope, outputBin);
+      }
+    }
+
+    // --- Partials: rendered into the output accumulator around this frame's centre ---
+    const int hopsThisFrame = (voicing >= strongVoicingThreshold) ? sinusoidalVoicedHopFactor : 1;
+    const int span = hopSize * hopsThisFrame;
+
+    oscillatorBank.setTargets(f0 * pitchRatio, partialAmplitudes.data(), numPartials);
+
+    std::fill(sinusoidBuffer.begin(), sinusoidBuffer.begin() + span, 0.0f);
+    oscillatorBank.render(sinusoidBuffer.data(), span, hopSize);
+
+    const int renderStart = outputReadPos + fftSize / 2 - hopSize;
+    for (int n = 0; n < span; ++n)
+      outputAccumulator[(size_t)((renderStart + n) % fftSize)] += sinusoidBuffer[(size_t)n];
+
+    // Strongly voiced frames are stable enough to skip the next analysis.
+    sinusoidalHopsToSkip = hopsThisFrame - 1;
+
+    // --- Noise: envelope-shaped, random phase, scaled by (1 - voicing) ---
+    const float noiseAmount = 1.0f - voicing;
+    if (noiseAmount < 1.0f - strongVoicingThreshold)
+      return false;
+
+    // Flattened RMS level of the input, so a noise input reproduces its own level.
+    float flatSquares = 0.0f;
+    for (int k = 0; k < numBins; ++k)
+    {
+      const float flat = magnitudeSpectrum[(size_t)k] / std::max(extractedEnvelope[(size_t)k], 1e-7f);
+      flatSquares += flat * flat;
+    }
+    // Random phases overlap-add incoherently: sqrt(N / hop) restores the level of a coherent frame.
+    const float noiseGain = noiseAmount * std::sqrt(flatSquares / (float)numBins) * std::sqrt((float)fftSize / (float)hopSize);
+
+    for (int k = 0; k < numBins; ++k)
+    {
+      const float phase = noiseRandom.nextFloat() * juce::MathConstants<float>::twoPi;
+      const float mag = noiseGain * resynthesisEnvelope[(size_t)k];
+      fftBuffer[(size_t)k * 2] = mag * std::cos(phase);
+      fftBuffer[(size_t)k * 2 + 1] = mag * std::sin(phase);
+    }
+
+    return true;
+  }
+
+  void SpectralProcessor::applyPitchShiftedResynthesis(const std::vector<float> &outputEnvelope)
+  {
+    const int numBins = fftSize / 2 + 1;
+    const float twoPi = juce::MathConstants<float>::twoPi;
+    const float expectedAdvance = twoPi * (float)hopSize / (float)fftSize; // per bin index
+    const float maxGainLinear = std::pow(10.0f, maxEnvelopeGainDb / 20.0f);
+
+    std::fill(shiftedMagnitude.begin(), shiftedMagnitude.end(), 0.0f);
+    std::fill(shiftedFrequency.begin(), shiftedFrequency.end(), 0.0f);
+    std::fill(shiftedPeak.begin(), shiftedPeak.end(), 0.0f);
+
+    // --- Analysis: true frequency per bin, flattened magnitude shifted to k * ratio ---
+    for (int k = 0; k < numBins; ++k)
+    {
+      const float real = fftBuffer[(size_t)k * 2];
+      const float imag = fftBuffer[(size_t)k * 2 + 1];
+      const float phase = std::atan2(imag, real);
+
+      float deviation = phase - analysisPhase[(size_t)k] - expectedAdvance * (float)k;
+      deviation -= twoPi * std::round(deviation / twoPi);
+      analysisPhase[(size_t)k] = phase;
+
+      // First hop after (re)engaging has no phase history: assume bin-centre frequencies.
+      const float trueBin = pitchStateValid ? (float)k + deviation / expectedAdvance : (float)k;
+
+      const int target = (int)std::lround((float)k * pitchRatio);
+      if (target < 0 || target >= numBins)
+        continue;
+
+      const float flat = magnitudeSpectrum[(size_t)k] / std::max(extractedEnvelope[(size_t)k], 1e-7f);
+
+      // Several source bins can land on one target bin when shifting down: keep the strongest's frequency.
+      // Compared with the largest single bin so far, not the running sum.
+      if (flat > shiftedPeak[(size_t)target])
+      {
+        shiftedPeak[(size_t)target] = flat;
+        shiftedFrequency[(size_t)target] = trueBin * pitchRatio;
+      }
+
+      shiftedMagnitude[(size_t)target] += flat;
+    }
+
+    if (!pitchStateValid)
+    {
+      std::copy(analysisPhase.begin(), analysisPhase.end(), synthesisPhase.begin());
+      pitchStateValid = true;
+    }
+
+    // --- Synthesis: accumulate phase at the shifted frequencies, re-impose envelope ---
+    for (int k = 0; k < numBins; ++k)
+    {
+      const float freq = shiftedMagnitude[(size_t)k] > 0.0f ? shiftedFrequency[(size_t)k] : (float)k;
+      float phase = synthesisPhase[(size_t)k] + expectedAdvance * freq;
+      phase -= twoPi * std::floor(phase / twoPi);
+      synthesisPhase[(size_t)k] = phase;
+
+      // Same gain ceiling as the plain warping path, relative to the input's own envelope.
+      const float envelope = std::min(outputEnvelope[(size_t)k], std::max(extractedEnvelope[(size_t)k], 1e-7f) * maxGainLinear);
+      const float mag = shiftedMagnitude[(size_t)k] * envelope;
+
+      fftBuffer[(size_t)k * 2] = mag * std::cos(phase);
+      fftBuffer[(size_t)k * 2 + 1] = mag * std::sin(phase);
+    }
+  }
+
+  void SpectralProcessor::process(const juce::dsp::ProcessContextReplacing<float> &context)
+  {
+    const auto &inputBlock = context.getInputBlock();
+    auto &outputBlock = context.getOutputBlock();
+    const size_t numSamples = inputBlock.getNumSamples();
+    const size_t numChannels = inputBlock.getNumChannels();
+
+    auto *src = inputBlock.getChannelPointer(0);
+    auto *dst = outputBlock.getChannelPointer(0);
+
+    if (engine == Engine::lpc)
+    {
+      if (dst != src)
+        std::copy(src, src + numSamples, dst);
+
+      processLpc(dst, (int)numSamples);
+    }
+    else if (engine == Engine::multiResolution && multiResolution != nullptr)
+    {
+      multiResolution->process(*this, src, dst, (int)numSamples);
+    }
+    else if (isZeroLatencyActive())
+    {
+      processZeroLatency(src, dst, (int)numSamples);
+    }
+    else
+    {
+      for (size_t i = 0; i < numSamples; ++i)
+      {
+        // Write new input sample into circular buffer
+        inputFifo[(size_t)inputWritePos] = src[i];
+        inputWritePos = (inputWritePos + 1) % fftSize;
+
+        // Read output sample from circular accumulator
+        dst[i] = outputAccumulator[(size_t)outputReadPos];
+        outputAccumulator[(size_t)outputReadPos] = 0.0f;
+        outputReadPos = (outputReadPos + 1) % fftSize;
+
+        ++hopCounter;
+        if (hopCounter >= hopSize)
         {
-          const int pos = (outputReadPos + k) % fftSize;
-          outputAccumulator[(size_t)pos] += frame[(size_t)k];
+          hopCounter = 0;
+
+          if (sinusoidalHopsToSkip > 0)
+          {
+            // The sinusoidal engine already rendered this hop from the previous analysis.
+            --sinusoidalHopsToSkip;
+            continue;
+          }
+
+          updateHopTargets(playbackPosition + (juce::int64)i + 1 - fftSize, (int)i + 1, stftTargetGlide);
+
+          // Assemble frame from circular input buffer (oldest to newest)
+          for (int k = 0; k < fftSize; ++k)
+            hopFrame[(size_t)k] = inputFifo[(size_t)((inputWritePos + k) % fftSize)];
+
+          if (!processBlock(hopFrame))
+            continue;
+
+          // Overlap-add into circular output accumulator
+          for (int k = 0; k < fftSize; ++k)
+          {
+            const int pos = (outputReadPos + k) % fftSize;
+            outputAccumulator[(size_t)pos] += hopFrame[(size_t)k];
+          }
         }
       }
     }
 
+    playbackPosition += (juce::int64)numSamples;
+
+    // Target changes not reached yet apply at the first hops of the next block.
+    for (int c = 0; c < numPendingTargetChanges; ++c)
+      pendingTargetChanges[(size_t)c].sampleOffset -= (int)numSamples;
+
     // Copy channel 0 result to all other channels
     for (size_t ch = 1; ch < numChannels; ++ch)
     {
@@ -309,4 +1611,64 @@ namespace dsp
     f2 = visF2;
   }
 
+  std::array<float, SpectralProcessor::numFormants> SpectralProcessor::getLatestDetectedFormantsHz()
+  {
+    const juce::ScopedLock lock(visualizationLock);
+    return visDetectedHz;
+  }
+
+  int SpectralProcessor::countDenormals() const
+  {
+    int count = 0;
+    for (const auto *state : {&inputFifo, &outputAccumulator, &extractedEnvelope, &warpedEnvelope,
+                              &resynthesisEnvelope, &envelopeScale, &shiftedMagnitude})
+      for (float value : *state)
+        if (std::fpclassify(value) == FP_SUBNORMAL)
+          ++count;
+
+    // Recursive and long-tailed state of the other engines, where denormals build up in silence
+    count += lpcShifter.countDenormals() + oscillatorBank.countDenormals() + zeroLatencyConvolver.countDenormals();
+
+    if (multiResolution != nullptr)
+      count += multiResolution->countDenormals();
+
+    return count;
+  }
+
+  void SpectralProcessor::copySettingsFrom(const SpectralProcessor &other)
+  {
+    if (std::abs(pitchRatio - 1.0f) < 1.0e-4f && std::abs(other.pitchRatio - 1.0f) >= 1.0e-4f)
+      pitchStateValid = false;
+
+    pitchRatio = other.pitchRatio;
+    pitchUsesOriginalFormants = other.pitchUsesOriginalFormants;
+    globalScaleEnabled = other.globalScaleEnabled;
+    globalScaleRatio = other.globalScaleRatio;
+    globalScaleBlend = other.globalScaleBlend;
+    bandMode = other.bandMode;
+    cepstralWarp = other.cepstralWarp;
+    fullEnvelopeTarget = other.fullEnvelopeTarget;
+  }
+
+  void SpectralProcessor::copyVisualizationFrom(SpectralProcessor &band)
+  {
+    // Never block the audio thread: skip this update if the GUI holds either lock.
+    const juce::ScopedTryLock bandLock(band.visualizationLock);
+    const juce::ScopedTryLock lock(visualizationLock);
+    if (!bandLock.isLocked() || !lock.isLocked())
+      return;
+
+    // Band bins per bin of this instance; magnitudes scale with the FFT size.
+    const float binRatio = (float)band.fftSize / (float)fftSize;
+    for (size_t k = 0; k < visSpectrum.size(); ++k)
+    {
+      visSpectrum[k] = interpolateBin(band.visSpectrum, (float)k * binRatio) / binRatio;
+      visEnvelope[k] = interpolateBin(band.visEnvelope, (float)k * binRatio) / binRatio;
+    }
+
+    visF1 = band.visF1 / binRatio;
+    visF2 = band.visF2 / binRatio;
+    visDetectedHz = band.visDetectedHz;
+  }
+
 } // namespace dsp
@@ -3,55 +3,448 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
 #include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "BandEnvelope.h"
+#include "CepstralWarper.h"
 #include "EnvelopeExtractor.h"
 #include "FormantWarper.h"
+#include "HarmonicOscillatorBank.h"
+#include "LockedMemory.h"
+#include "LpcFormantShifter.h"
+#include "MinimumPhaseConvolver.h"
+#include "ZeroPaddedSpectrum.h"
+
+class SpectralProcessorBenchmark;
 
 namespace dsp
 {
+    class FormantRecorder;
+    class MultiResolutionProcessor;
 
     /**
      * Main Spectral Processing Engine.
      *
      * Implements the Source-Filter separation, warping, and reconstruction pipeline:
      * 1. Analysis: STFT with Hann Window and 75% overlap.
-     * 2. Envelope Extraction: Cepstral Analysis.
+     * 2. Envelope Extraction: Cepstral Analysis (or the mel band envelope, see BandEnvelope).
      * 3. Formant Warping: Piecewise linear warping of the envelope.
      * 4. Resynthesis: Flatten spectrum (Source) * Warped Envelope (Filter).
+     *    Optionally the flattened fine structure is pitch shifted (phase vocoder bin
+     *    shifting) before the envelope is re-imposed, all within the same STFT pass.
      * 5. Synthesis: Inverse STFT and Overlap-Add.
+     *
+     * The sinusoidal engine replaces steps 4-5 with a harmonic oscillator bank driven by the
+     * cepstral F0, plus envelope-shaped noise for the unvoiced part. The LPC engine bypasses
+     * the STFT entirely (see LpcFormantShifter). The multi-resolution engine runs this chain on
+     * two bands with different frame sizes (see MultiResolutionProcessor).
      */
     class SpectralProcessor
     {
     public:
         static constexpr size_t numFormants = 15;
 
-        SpectralProcessor();
+        enum class Engine
+        {
+            stft,      // Bin scaling of the STFT (default)
+            sinusoidal, // Harmonic oscillator bank + envelope-shaped noise
+            lpc,        // Time-domain LPC pole shifting, no FFT and no latency
+            multiResolution // Two-band STFT; benchmark and tests only, the plugin does not offer it
+        };
+
+        /**
+         * Per-frame formant track of a recording, sampled every hopSamples.
+         * Used as a time-varying target (e.g. a guide vocal aligned to a take).
+         */
+        struct FormantTrajectory
+        {
+            double sampleRate = 44100.0;
+            int hopSamples = 0;
+            std::vector<std::array<float, numFormants>> framesHz;
+            std::vector<float> energyDb;
+
+            bool isEmpty() const { return framesHz.empty() || hopSamples <= 0; }
+        };
+
+        /**
+         * Averaged spectral envelope of a recording (fftSize / 2 + 1 bins of the analysis, from 0 Hz
+         * to half of sampleRate) together with the formants found on it. The processor it is
+         * installed in resamples it to its own bins.
+         */
+        struct TargetEnvelope
+        {
+            double sampleRate = 44100.0;
+            std::vector<float> envelope; // Linear magnitude, mean log level 0
+            std::array<float, numFormants> formantsHz{};
+
+            bool isEmpty() const { return envelope.empty(); }
+        };
+
+        static constexpr int defaultFftOrder = 10; // 1024 samples
+
+        /** @param fftOrder log2 of the STFT frame size; the hop is a quarter of it. */
+        explicit SpectralProcessor(int fftOrder = defaultFftOrder);
         ~SpectralProcessor();
 
+        int getFftSize() const { return fftSize; }
+
         void prepare(const juce::dsp::ProcessSpec &spec);
         void process(const juce::dsp::ProcessContextReplacing<float> &context);
         void reset();
 
         void setTargetFormantsHz(const std::array<float, numFormants> &targetHz);
 
+        /**
+         * Switches the static targets at a sample of the next process() block (audio thread, call
+         * before process(), in time order). The change takes effect at the hop whose analysis frame
+         * contains that sample and is crossfaded over targetCrossfadeHops hops. Changes beyond the
+         * block carry over to the next one; up to maxPendingTargetChanges are kept.
+         */
+        void queueTargetChange(int sampleOffset, const std::array<float, numFormants> &targetHz);
+        bool hasPendingTargetChanges() const;
+
+        static constexpr int targetCrossfadeHops = 4;
+        static constexpr int maxPendingTargetChanges = 32;
+
+        /**
+         * Time constant of the hop-rate glide toward targets set with setTargetFormantsHz(), so
+         * that coarse control updates (UI writes at display rate, automation) don't step the warp.
+         */
+        static constexpr double targetGlideMs = 20.0;
+
+        /**
+         * Pitch shift of the fine structure (semitones, 0 = off).
+         * @param useOriginalFormants If true the input's own envelope is re-imposed after
+         *        shifting (formant-preserving pitch shift); otherwise the warped envelope is.
+         */
+        void setPitchShift(float semitones, bool useOriginalFormants);
+
+        /**
+         * Uniform "gender/size" formant scaling: the warp map is src = dst / ratio in closed form,
+         * so formant detection is skipped entirely. blendToFormants (0..1) mixes in the
+         * per-formant target map, which brings detection back.
+         */
+        void setGlobalScale(bool enabled, float ratio, float blendToFormants);
+
+        /**
+         * Selects the resynthesis engine. The STFT and sinusoidal engines share the spectral
+         * analysis; targets and global scale apply to all engines, pitch shift only to the
+         * two spectral ones. Set it before prepare(): the multi-resolution bands are only
+         * allocated there, and only for that engine.
+         */
+        void setEngine(Engine newEngine);
+
+        /**
+         * Zero-latency monitoring for the STFT engine: the analysis runs on a side path and the
+         * envelope scale curve is applied to the dry input as a minimum-phase FIR
+         * (MinimumPhaseConvolver). Pitch shift is not available in this mode.
+         */
+        void setZeroLatency(bool enabled);
+
+        /**
+         * Band envelope mode: envelope, formant detection and warping run on
+         * BandEnvelope::numBands mel bands instead of every bin, and only the resulting curves
+         * are interpolated back to bins. Much cheaper per hop, slightly coarser envelope.
+         * The sinusoidal engine keeps the cepstral envelope (its F0 comes from the cepstrum).
+         */
+        void setBandMode(bool enabled) { bandMode = enabled; }
+
+        /**
+         * Cepstral warp mode: the cepstral envelope is warped on its coefficients
+         * (CepstralWarper, matrix cached per warp map) instead of resampling every bin.
+         * Not used in band envelope mode, which has no cepstrum.
+         */
+        void setCepstralWarp(bool enabled) { cepstralWarp = enabled; }
+
+        /**
+         * Zero-padded envelope analysis (1 = off, 2 or 4): the windowed frame is padded to
+         * factor * fftSize (ZeroPaddedSpectrum, input-pruned) and the cepstral envelope and the
+         * formant peaks come from that finer grid. Window, hop and latency stay the same.
+         * Allocates, so it takes effect at the next prepare(). Used by the STFT, sinusoidal and
+         * zero-latency paths, not in band envelope mode.
+         */
+        void setAnalysisPadding(int factor) { analysisPadding = factor >= 4 ? 4 : factor >= 2 ? 2 : 1; }
+        int getAnalysisPadding() const { return analysisPadding; }
+
+        /**
+         * Warm start (default on): at the end of prepare() the working buffers are prefaulted and,
+         * where the OS permits, page-locked (LockedMemory), then getLatencySamples() + warmupFrames
+         * * fftSize samples of a quiet buzz run through the current engine (and the zero-latency
+         * path for the STFT engine) before everything is reset. The first callbacks then do not
+         * pay for page faults, cold caches and first-use FFT setup. Set the engine before prepare().
+         */
+        void setPrepareWarmup(bool enabled) { prepareWarmup = enabled; }
+        bool isPrepareWarmupEnabled() const { return prepareWarmup; }
+        static constexpr int warmupFrames = 4;
+
+        /** Working memory page-locked by the last prepare() (0 without warmup or permission). */
+        size_t getLockedBytes() const { return lockedMemory.getLockedBytes(); }
+        size_t getPrefaultedBytes() const { return lockedMemory.getPrefaultedBytes(); }
+
+        /** Latency of the current engine / mode in samples. */
+        int getLatencySamples() const;
+
+        /** Clamps F1 >= 200 Hz and keeps each formant at least 20 Hz above the previous one. */
+        static void enforceFormantOrdering(std::array<float, numFormants> &formantsHz);
+
+        /**
+         * Offline analysis of the frame in the middle of channel 0. Like analyzeFormantTrajectory(),
+         * the formants are picked on the frame's LPC envelope (see computeLpcEnvelope()).
+         */
         std::array<float, numFormants> estimateFormantsFromBuffer(const juce::AudioBuffer<float> &sourceBuffer, double sourceSampleRate);
 
+        /**
+         * Offline analysis: runs the analysis chain on every trajectoryHopSize samples of channel 0.
+         * Formants come from an all-pole (LPC) envelope of each frame, which resolves a low F1 that
+         * the 30-coefficient cepstral envelope merges into F2 or the spectral tilt; the envelope
+         * cepstra (frameCepstra, analyzeAverageEnvelope()) are still the cepstral ones.
+         * Uses this instance's analysis buffers, so call it on a dedicated (non-realtime) instance.
+         */
+        FormantTrajectory analyzeFormantTrajectory(const juce::AudioBuffer<float> &sourceBuffer, double sourceSampleRate);
+
+        /**
+         * Offline analysis: log envelope averaged over the frames within 30 dB of the loudest one,
+         * normalised to a mean log level of 0, and its formants. Same threading rules as
+         * analyzeFormantTrajectory().
+         */
+        TargetEnvelope analyzeAverageEnvelope(const juce::AudioBuffer<float> &sourceBuffer, double sourceSampleRate);
+
+        /** Envelope cepstrum values per frame written by analyzeTrajectoryFrames(). */
+        static constexpr int frameCepstrumSize = EnvelopeExtractor::defaultCutoffBin + 1;
+
+        /** Frames analyzeFormantTrajectory() makes from totalSamples samples. */
+        int getNumTrajectoryFrames(int totalSamples) const { return std::max(1, (totalSamples - fftSize) / trajectoryHopSize + 1); }
+        int getTrajectoryHopSize() const { return trajectoryHopSize; }
+
+        /**
+         * Offline analysis of frames [firstFrame, firstFrame + numFrames) of a source of
+         * totalSamples samples, as analyzeFormantTrajectory() would: `samples` holds the source
+         * from sample firstFrame * getTrajectoryHopSize() up to the end of the last frame. Writes
+         * those frames of trajectory.framesHz / energyDb (sized by the caller) and, if
+         * frameCepstra is not null, frameCepstrumSize envelope cepstrum values per frame there.
+         * Frames are independent, so a long source can be analysed in chunks on several threads,
+         * one instance each (see ParallelSourceAnalyzer).
+         */
+        void analyzeTrajectoryFrames(const float *samples, int totalSamples, double sourceSampleRate,
+                                     int firstFrame, int numFrames, FormantTrajectory &trajectory, float *frameCepstra);
+
+        /** analyzeAverageEnvelope() from a trajectory and the frame cepstra of analyzeTrajectoryFrames(). */
+        TargetEnvelope averageEnvelopeFromFrames(const FormantTrajectory &trajectory, const std::vector<float> &frameCepstra) const;
+
+        /**
+         * Installs the stored envelope for the full-envelope target mode (message thread).
+         * An empty envelope disables the mode.
+         */
+        void setTargetEnvelope(TargetEnvelope newEnvelope);
+        bool hasTargetEnvelope() const { return hasStoredEnvelope.load(); }
+
+        /**
+         * Full-envelope target mode: instead of moving the input's envelope, the output envelope is
+         * the stored source envelope, aligned so its formants sit on the input's detected formants
+         * (one lerp over bins) and brought to the input's level. The formant targets are not used.
+         * Needs a stored envelope and the cepstral analysis (not band envelope mode).
+         */
+        void setFullEnvelopeTarget(bool enabled) { fullEnvelopeTarget = enabled; }
+
+        /**
+         * Warps a guide trajectory onto a take's timeline with banded DTW.
+         * The result has the take's frame rate and can be passed to setTargetTrajectory().
+         */
+        static FormantTrajectory alignTrajectory(const FormantTrajectory &guide, const FormantTrajectory &take, double bandRadiusSeconds = 2.0);
+
+        /**
+         * Installs a time-varying target (message thread). While the host is playing and the
+         * playback position is inside the trajectory, it replaces the static targets per hop.
+         * An empty trajectory disables the mode.
+         */
+        void setTargetTrajectory(FormantTrajectory trajectory);
+        bool hasTargetTrajectory() const { return hasTrajectory.load(); }
+
+        /**
+         * Audio thread: starts on the static targets of another instance (e.g. the one it replaces)
+         * instead of gliding in. Only copies values, so it can run between two blocks.
+         */
+        void copyFormantTargetsFrom(const SpectralProcessor &other);
+
+        /**
+         * Targets built for one processor off the audio thread and installed with
+         * applyTargetUpdate(), which swaps them in without allocating. Afterwards the update holds
+         * the replaced trajectory and envelope, to be freed off the audio thread.
+         */
+        struct TargetUpdate
+        {
+            std::array<float, numFormants> formantsHz{};
+            bool hasFormants = false; // Static targets are only replaced when set
+            FormantTrajectory trajectory;
+            TargetEnvelope envelope;
+            std::vector<float> envelopeCurve; // On this processor's bins
+            std::vector<TargetUpdate> bands;  // Multi-resolution engine: one per band
+            bool applied = false;             // This processor's part (the bands track their own)
+        };
+
+        /** Message thread: fills an update for this processor (and its multi-resolution bands). */
+        void prepareTargetUpdate(TargetUpdate &update, const FormantTrajectory &trajectory, const TargetEnvelope &envelope) const;
+
+        /** Audio thread: installs an update; false if a target lock was held and it has to be retried. */
+        bool applyTargetUpdate(TargetUpdate &update);
+
+        /** Host timeline position (in samples) of the first sample of the next process() call. */
+        void setPlaybackPosition(juce::int64 timeInSamples, bool isPlaying);
+
+        /**
+         * Learn mode: while the recorder is recording, every STFT / sinusoidal analysis hop pushes
+         * its detected formants, frame energy and voicing to it (lock-free, no disk access).
+         * Set before processing starts; nullptr disables.
+         */
+        void setFormantRecorder(FormantRecorder *recorder) { formantRecorder = recorder; }
+        int getHopSamples() const { return hopSize; }
+
         /**
          * Retrieves the latest spectral data for the GUI.
          * Thread-safe using a lock (tryEnter pattern).
          */
         void getLatestVisualizationData(std::vector<float> &spectrum, std::vector<float> &envelope, float &f1, float &f2);
 
+        /** Formants detected on the input in the latest hop (Hz). Same locking as the visualization data. */
+        std::array<float, numFormants> getLatestDetectedFormantsHz();
+
+        /**
+         * Number of denormal values left in the running state: input FIFO, overlap-add accumulator,
+         * envelopes and phase vocoder magnitudes, the LPC lattice state, the oscillator bank and the
+         * minimum-phase convolver (multi-resolution bands included). For soak tests; call between
+         * process() calls.
+         */
+        int countDenormals() const;
+
     private:
+        friend class ::SpectralProcessorBenchmark; // Tools/SpectralBenchmark.cpp times the private stages
+        friend class MultiResolutionProcessor;     // Runs two instances as bands of this one
+
         /**
          * Processes a single FFT frame (frequency domain manipulation).
+         * @return true if data holds a frame to overlap-add.
          */
-        void processBlock(std::vector<float> &data);
+        bool processBlock(std::vector<float> &data);
 
-        void detectFormants(const std::vector<float> &envelope, double sampleRate, std::array<float, numFormants> &formantBins) const;
+        /**
+         * Sinusoidal engine for one analysed hop: renders the harmonic partials straight into
+         * outputAccumulator and writes envelope-shaped noise into fftBuffer.
+         * @return true if fftBuffer holds noise that still needs the inverse FFT.
+         */
+        bool synthesizeSinusoidalFrame(const std::vector<float> &outputEnvelope);
 
-        static constexpr int fftOrder = 10; // 1024 samples
-        static constexpr int fftSize = 1 << fftOrder;
-        static constexpr int hopSize = fftSize / 4; // 75% overlap (standard for STFT)
+        bool isZeroLatencyActive() const { return zeroLatency && engine == Engine::stft; }
+
+        /** Zero-latency mode: analysis per hop on the side, minimum-phase filtering of the input per sample. */
+        void processZeroLatency(const float *input, float *output, int numSamples);
+
+        /** Warm start of prepare(), see setPrepareWarmup(). */
+        void warmUp(int maximumBlockSize);
+
+        /** Adds the fixed-size buffers of the per-hop processing to memory. */
+        void addWorkingBuffers(LockedMemory &memory);
+
+        /** Window + FFT + envelope + warp of one STFT frame, and the visualization update. */
+        void analyzeHop(std::vector<float> &data);
+
+        /** Per-bin gain warpedEnvelope / extractedEnvelope, clamped to maxEnvelopeGainDb. */
+        void computeEnvelopeScale(std::vector<float> &scale) const;
+
+        /** LPC engine: the whole block in the time domain, re-analysing at the shifter's hop boundaries. */
+        void processLpc(float *samples, int numSamples);
+
+        /** Linear interpolation of a per-bin spectrum at a fractional bin. */
+        static float interpolateBin(const std::vector<float> &spectrum, float bin);
+
+        /**
+         * Phase vocoder: moves the flattened fine structure (spectrum / envelope) by pitchRatio
+         * and re-imposes the given envelope, writing the result into fftBuffer.
+         */
+        void applyPitchShiftedResynthesis(const std::vector<float> &outputEnvelope);
+
+        /** Window + FFT + magnitude + envelope for one frame (zero-padded if numSamples < fftSize). */
+        void analyzeFrame(const float *samples, int numSamples);
+
+        /**
+         * Picks up to numFormants envelope peaks (in bins of the envelope's own transform size,
+         * 2 * (envelope.size() - 1)). Peaks are refined to sub-bin accuracy on the continuous
+         * envelope given by `cepstrum` (the coefficients `envelope` was made from), or by a
+         * parabola through the log envelope around the peak if `cepstrum` is empty.
+         */
+        void detectFormants(const std::vector<float> &envelope, const std::vector<float> &cepstrum, double sampleRate,
+                            std::array<float, numFormants> &formantBins) const;
+
+        /** Newton iteration on the log envelope slope from a grid peak, kept within one bin of it. */
+        float refinePeakBin(const std::vector<float> &cepstrum, int analysisSize, float bin, float minBin, float maxBin) const;
+
+        /**
+         * Offline analysis: lpcEnvelope = 1 / |A(e^jw)| of the all-pole model of the last analyzed
+         * frame. The autocorrelation is the inverse FFT of the pre-emphasized power spectrum in
+         * magnitudeSpectrum, the predictor (order 2 + fs / 1 kHz) comes from Levinson-Durbin and
+         * |A| from one forward FFT. A silent frame gives a flat envelope.
+         */
+        void computeLpcEnvelope(double sampleRate);
+
+        /** detectFormants() on the live envelope (the padded one if enabled) into currentFormantBins. */
+        void detectLiveFormants();
+
+        /** The extractor of the live envelope: envelopeExtractor, or paddedEnvelopeExtractor if padded. */
+        const EnvelopeExtractor &liveEnvelopeExtractor() const { return analysisPadding > 1 ? paddedEnvelopeExtractor : envelopeExtractor; }
+
+        /**
+         * Builds warpedEnvelope from extractedEnvelope for the current mode.
+         * @return true if formants were detected (and warpPoints / currentFormantBins are valid).
+         */
+        bool computeWarpedEnvelope(int numBins);
+
+        /** Band envelope mode: bandSpectrum -> warpedBandSpectrum, expanded into extractedEnvelope / warpedEnvelope. */
+        bool computeWarpedBandEnvelope(int numBins);
+
+        /** detectFormants() on the band envelope; the result is in FFT bins like detectFormants(). */
+        void detectFormantsInBands(const std::vector<float> &bands, std::array<float, numFormants> &formantBins) const;
+
+        bool isBandModeActive() const { return bandMode && engine != Engine::sinusoidal; }
+
+        /** extractedEnvelope -> warpedEnvelope with the warper's map (per bin, or on the cepstrum in cepstral warp mode). */
+        void warpEnvelope(FormantWarper &warper);
+
+        /** Full-envelope target: warpedEnvelope from the stored envelope, aligned to currentFormantBins. */
+        void applyTargetEnvelope(int numBins);
+
+        /** The stored envelope resampled to this processor's bins at currentSampleRate (off the audio thread). */
+        void buildTargetEnvelopeCurve(const TargetEnvelope &envelope, std::vector<float> &curve) const;
+
+        /** Control points from the detected formants (currentFormantBins) to hopTargetsHz. */
+        void buildFormantWarpPoints(int numBins);
+
+        /**
+         * Picks the targets for the hop whose analysis frame starts at frameStart (host timeline).
+         * blockOffset is the number of samples of the current block the frame contains; queued
+         * target changes before it are applied first. glide is the one-pole coefficient toward
+         * targetFormantsHz for one hop of the calling engine (stftTargetGlide / lpcTargetGlide).
+         */
+        void updateHopTargets(juce::int64 frameStart, int blockOffset, float glide);
+
+        /** Applies the queued target changes at sample offsets below blockOffset and starts the crossfade. */
+        void applyPendingTargetChanges(int blockOffset);
+
+        /** Learn mode: pushes the current hop (currentFormantBins, energy, voicing) to formantRecorder. */
+        void recordHop(float meanSquare, bool formantsDetected);
+
+        /** Multi-resolution bands: pitch shift, global scale and envelope modes of the parent. */
+        void copySettingsFrom(const SpectralProcessor &other);
+
+        /** Multi-resolution: shows a band's analysis (same sample rate) on this instance's bins. */
+        void copyVisualizationFrom(SpectralProcessor &band);
+
+        const int fftOrder;
+        const int fftSize;
+        const int hopSize;           // 75% overlap (standard for STFT)
+        const int trajectoryHopSize; // Offline trajectory frame rate
+        static constexpr int peakRefinementIterations = 3;
+        static constexpr int maxLpcOrder = 64;
+        static constexpr float lpcPreEmphasis = 0.97f;
 
         double currentSampleRate = 44100.0;
 
@@ -63,29 +456,143 @@ namespace dsp
         std::vector<float> inputFifo;         // Input buffering for STFT
         std::vector<float> outputAccumulator; // Overlap-Add accumulator
         std::vector<float> fftBuffer;         // Temp buffer for FFT operations
+        std::vector<float> hopFrame;          // Frame of the current hop, oldest sample first
 
         // Spectral Data containers
         std::vector<float> magnitudeSpectrum;
+        std::vector<float> lpcEnvelope; // Offline analysis only, sized on first use
         std::vector<float> extractedEnvelope;
         std::vector<float> warpedEnvelope;
 
+        // Phase vocoder state (pitch shift)
+        std::vector<float> analysisPhase;     // Previous hop's phase per bin
+        std::vector<float> synthesisPhase;    // Accumulated output phase per bin
+        std::vector<float> shiftedMagnitude;  // Flattened magnitude after bin shifting
+        std::vector<float> shiftedFrequency;  // True frequency (in bins) after shifting
+        std::vector<float> shiftedPeak;       // Largest single source bin landed on each target bin
+        float pitchRatio = 1.0f;
+        bool pitchUsesOriginalFormants = false;
+        bool pitchStateValid = false;
+
+        // Sinusoidal engine
+        Engine engine = Engine::stft;
+        HarmonicOscillatorBank oscillatorBank;
+        std::vector<float> sinusoidBuffer;       // Partials for the current render span
+        std::vector<float> resynthesisEnvelope;  // Output envelope after the gain ceiling
+        std::vector<float> partialAmplitudes;
+        float sinusoidAmplitudeScale = 1.0f;     // Envelope magnitude -> oscillator amplitude
+        float stftUnityGain = 1.0f;              // Gain of the STFT path for an unmodified input
+        juce::Random noiseRandom;
+        int sinusoidalHopsToSkip = 0;            // Hops left before the next analysis
+
+        // LPC engine
+        LpcFormantShifter lpcShifter;
+
+        // Zero-latency mode
+        bool zeroLatency = false;
+        MinimumPhaseConvolver zeroLatencyConvolver;
+        std::vector<float> envelopeScale; // Per-bin gain of the current hop
+
+        // Band envelope mode
+        bool bandMode = false;
+        BandEnvelope bandEnvelope;
+        std::vector<float> bandSpectrum;       // Smoothed band envelope of the current hop
+        std::vector<float> warpedBandSpectrum;
+        FormantWarper bandWarper;              // Warp maps over the band index
+        FormantWarper bandScaleWarper;
+        std::vector<WarpingPoint> bandWarpPoints;
+        float bandScaleMapRatio = 0.0f;
+
+        // Cepstral warp mode
+        bool cepstralWarp = false;
+        CepstralWarper cepstralWarper;
+        std::vector<float> warpedCepstrum;
+        std::vector<float> cepstralLogScale; // log(warped / original) per bin
+
+        static constexpr int sinusoidalMaxPartials = 160;
+        static constexpr float sinusoidalMaxFrequencyHz = 16000.0f;
+        static constexpr float sinusoidalMinF0Hz = 70.0f;
+        static constexpr float sinusoidalMaxF0Hz = 1000.0f;
+        static constexpr int sinusoidalVoicedHopFactor = 2; // Analysis interval (in hops) for strongly voiced frames
+        static constexpr float strongVoicingThreshold = 0.9f;
+
+        // Voicing = (cepstral peak prominence - floor) / range, clamped to 0..1
+        static constexpr float voicingProminenceFloor = 3.5f;
+        static constexpr float voicingProminenceRange = 4.0f;
+
+        // Zero-padded analysis (see setAnalysisPadding())
+        int analysisPadding = 1;
+        ZeroPaddedSpectrum paddedSpectrum;
+        EnvelopeExtractor paddedEnvelopeExtractor; // Sized for the padded transform, same lifter
+        std::vector<float> paddedMagnitude;
+        std::vector<float> paddedEnvelope;
+
         // Helper classes
         EnvelopeExtractor envelopeExtractor;
         FormantWarper formantWarper;
+        FormantWarper globalScaleWarper;
+        std::vector<WarpingPoint> warpPoints;
+
+        // Global scale mode
+        bool globalScaleEnabled = false;
+        float globalScaleRatio = 1.0f;
+        float globalScaleBlend = 0.0f;
+        float globalScaleMapRatio = 0.0f; // Ratio the cached map was built for
 
         std::array<float, numFormants> targetFormantsHz{
             500.0f, 1500.0f, 2500.0f, 3200.0f, 3800.0f,
             4400.0f, 5000.0f, 5600.0f, 6200.0f, 6800.0f,
             7400.0f, 8000.0f, 8600.0f, 9200.0f, 9800.0f};
 
+        std::array<float, numFormants> hopTargetsHz = targetFormantsHz;
         std::array<float, numFormants> currentFormantBins{};
 
+        // Sample-accurate target switching (e.g. MIDI vowel slots)
+        struct PendingTargetChange
+        {
+            int sampleOffset = 0; // Relative to the current block
+            std::array<float, numFormants> targetHz{};
+        };
+        std::array<PendingTargetChange, maxPendingTargetChanges> pendingTargetChanges;
+        int numPendingTargetChanges = 0;
+        std::array<float, numFormants> staticTargetsHz = targetFormantsHz; // Static targets of the latest hop (mid-crossfade)
+        std::array<float, numFormants> crossfadeFromHz = targetFormantsHz;
+        int crossfadeHopsLeft = 0;
+        float stftTargetGlide = 1.0f; // Per STFT hop, see targetGlideMs
+        float lpcTargetGlide = 1.0f;  // Per LPC frame
+
+        // Time-varying target (guide trajectory aligned to the take)
+        juce::CriticalSection trajectoryLock;
+        FormantTrajectory targetTrajectory;
+        std::atomic<bool> hasTrajectory{false};
+
+        // Full-envelope target (averaged source envelope)
+        juce::CriticalSection targetEnvelopeLock;
+        TargetEnvelope targetEnvelope;
+        std::vector<float> targetEnvelopeCurve; // targetEnvelope on this processor's bins
+        std::atomic<bool> hasStoredEnvelope{false};
+        bool fullEnvelopeTarget = false;
+        juce::int64 playbackPosition = 0;
+        juce::int64 hopFrameStart = 0; // Host time of the current hop's analysis frame
+        bool hostIsPlaying = false;
+
+        FormantRecorder *formantRecorder = nullptr;
+
+        // Warm start (see setPrepareWarmup())
+        bool prepareWarmup = true;
+        LockedMemory lockedMemory;
+
+        // Multi-resolution engine (created in prepare(), not for the bands themselves)
+        std::unique_ptr<MultiResolutionProcessor> multiResolution;
+        bool isResolutionBand = false;
+
         // Visualization (Thread Synchronization)
         juce::CriticalSection visualizationLock;
         std::vector<float> visSpectrum;
         std::vector<float> visEnvelope;
         float visF1 = 0.0f;
         float visF2 = 0.0f;
+        std::array<float, numFormants> visDetectedHz{};
 
         // STFT state
         int hopCounter = 0;
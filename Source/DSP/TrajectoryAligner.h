@@ -0,0 +1,217 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Aligns two feature trajectories with banded Dynamic Time Warping.
+     *
+     * Used to map a guide performance (imported source) onto a target take whose
+     * timing differs. Both trajectories are given as feature matrices in
+     * structure-of-arrays layout: features[dim * numFrames + frame].
+     *
+     * The search is restricted to a Sakoe-Chiba band around the (slope-corrected)
+     * diagonal, so memory and time are O(takeFrames * bandWidth) instead of
+     * O(takeFrames * guideFrames). The per-row local cost is evaluated with
+     * juce::FloatVectorOperations over contiguous guide frames, which keeps
+     * multi-minute takes practical.
+     *
+     * Recurrence (row = take frame j, column = guide frame i):
+     *   D[j][i] = cost(j, i) + min(D[j-1][i-1], D[j-1][i], D[j][i-1])
+     */
+    class TrajectoryAligner
+    {
+    public:
+        TrajectoryAligner() = default;
+
+        /**
+         * Computes the warping path.
+         *
+         * @param guideFeatures  Guide features, SoA layout (numDims x guideFrames).
+         * @param guideFrames    Number of guide frames.
+         * @param takeFeatures   Take features, SoA layout (numDims x takeFrames).
+         * @param takeFrames     Number of take frames.
+         * @param dimWeights     Per-dimension weights (size numDims).
+         * @param bandRadius     Half width of the search band in guide frames.
+         * @return For each take frame, the (fractional) guide frame aligned to it.
+         *         Empty if either trajectory is empty.
+         */
+        std::vector<float> align(const std::vector<float> &guideFeatures, int guideFrames,
+                                 const std::vector<float> &takeFeatures, int takeFrames,
+                                 const std::vector<float> &dimWeights, int bandRadius)
+        {
+            std::vector<float> result;
+            const int numDims = (int)dimWeights.size();
+
+            if (guideFrames <= 0 || takeFrames <= 0 || numDims <= 0)
+                return result;
+
+            jassert(guideFeatures.size() == (size_t)(numDims * guideFrames));
+            jassert(takeFeatures.size() == (size_t)(numDims * takeFrames));
+
+            // The band must at least absorb the rounding of the slope-corrected diagonal.
+            bandRadius = std::max(bandRadius, 1);
+            const int bandWidth = std::min(2 * bandRadius + 1, guideFrames);
+
+            directions.assign((size_t)takeFrames * (size_t)bandWidth, stepNone);
+            bandStart.resize((size_t)takeFrames);
+            previousRow.assign((size_t)bandWidth, infinity);
+            currentRow.assign((size_t)bandWidth, infinity);
+            localCost.resize((size_t)bandWidth);
+            difference.resize((size_t)bandWidth);
+            verticalCandidates.resize((size_t)bandWidth);
+            diagonalCandidates.resize((size_t)bandWidth);
+
+            const float slope = takeFrames > 1 ? (float)(guideFrames - 1) / (float)(takeFrames - 1) : 0.0f;
+
+            for (int j = 0; j < takeFrames; ++j)
+            {
+                const int centre = (int)std::lround((float)j * slope);
+                const int lo = juce::jlimit(0, guideFrames - bandWidth, centre - bandWidth / 2);
+                bandStart[(size_t)j] = lo;
+
+                // --- Local cost: weighted squared distance, vectorized over the band ---
+                juce::FloatVectorOperations::clear(localCost.data(), bandWidth);
+                for (int d = 0; d < numDims; ++d)
+                {
+                    const float *guideRow = guideFeatures.data() + (size_t)d * (size_t)guideFrames + (size_t)lo;
+                    const float takeValue = takeFeatures[(size_t)d * (size_t)takeFrames + (size_t)j];
+
+                    juce::FloatVectorOperations::add(difference.data(), guideRow, -takeValue, bandWidth);
+                    juce::FloatVectorOperations::multiply(difference.data(), std::sqrt(dimWeights[(size_t)d]), bandWidth);
+                    juce::FloatVectorOperations::addWithMultiply(localCost.data(), difference.data(), difference.data(), bandWidth);
+                }
+
+                auto *dir = directions.data() + (size_t)j * (size_t)bandWidth;
+
+                if (j == 0)
+                {
+                    // First row starts at (0, 0) and can only advance horizontally.
+                    jassert(lo == 0);
+                    float acc = 0.0f;
+                    for (int k = 0; k < bandWidth; ++k)
+                    {
+                        acc += localCost[(size_t)k];
+                        currentRow[(size_t)k] = acc;
+                        dir[k] = (k == 0) ? stepNone : stepHorizontal;
+                    }
+                }
+                else
+                {
+                    // --- Vertical / diagonal predecessors re-indexed into this row's band ---
+                    const int prevLo = bandStart[(size_t)j - 1];
+                    gatherShifted(verticalCandidates, lo - prevLo, bandWidth);
+                    gatherShifted(diagonalCandidates, lo - prevLo - 1, bandWidth);
+
+                    juce::FloatVectorOperations::min(currentRow.data(), verticalCandidates.data(), diagonalCandidates.data(), bandWidth);
+
+                    // --- Horizontal predecessor is a true recurrence: sequential pass ---
+                    float left = infinity;
+                    for (int k = 0; k < bandWidth; ++k)
+                    {
+                        const float vertical = verticalCandidates[(size_t)k];
+                        const float diagonal = diagonalCandidates[(size_t)k];
+                        float best = currentRow[(size_t)k];
+                        std::uint8_t step = (diagonal <= vertical) ? stepDiagonal : stepVertical;
+
+                        if (left < best)
+                        {
+                            best = left;
+                            step = stepHorizontal;
+                        }
+
+                        const float value = (best >= infinity) ? infinity : best + localCost[(size_t)k];
+                        currentRow[(size_t)k] = value;
+                        dir[k] = (best >= infinity) ? stepNone : step;
+                        left = value;
+                    }
+                }
+
+                std::swap(previousRow, currentRow);
+            }
+
+            // --- Backtrack from (takeFrames-1, guideFrames-1) ---
+            result.assign((size_t)takeFrames, 0.0f);
+            std::vector<int> columnsPerRow((size_t)takeFrames, 0);
+
+            int j = takeFrames - 1;
+            int i = guideFrames - 1;
+            while (j >= 0)
+            {
+                result[(size_t)j] += (float)i;
+                columnsPerRow[(size_t)j] += 1;
+
+                const int k = i - bandStart[(size_t)j];
+                const std::uint8_t step = (k >= 0 && k < bandWidth) ? directions[(size_t)j * (size_t)bandWidth + (size_t)k] : stepNone;
+
+                if (step == stepDiagonal)
+                {
+                    --j;
+                    --i;
+                }
+                else if (step == stepVertical)
+                {
+                    --j;
+                }
+                else if (step == stepHorizontal)
+                {
+                    --i;
+                }
+                else
+                {
+                    // Unreachable cell (or origin): fall back to the diagonal.
+                    --j;
+                    i = std::max(0, i - 1);
+                }
+            }
+
+            // A take frame that matched several guide frames takes their mean.
+            for (size_t r = 0; r < result.size(); ++r)
+                result[r] /= (float)std::max(1, columnsPerRow[r]);
+
+            return result;
+        }
+
+    private:
+        static constexpr float infinity = std::numeric_limits<float>::max();
+
+        // Back-pointer codes
+        static constexpr std::uint8_t stepNone = 0;
+        static constexpr std::uint8_t stepDiagonal = 1;
+        static constexpr std::uint8_t stepVertical = 2;
+        static constexpr std::uint8_t stepHorizontal = 3;
+
+        /** Copies previousRow into dest, shifted so that dest[k] = previousRow[k + offset] (infinity outside). */
+        void gatherShifted(std::vector<float> &dest, int offset, int bandWidth) const
+        {
+            const int first = std::max(0, -offset);
+            const int last = std::min(bandWidth, bandWidth - offset);
+
+            if (first >= last)
+            {
+                juce::FloatVectorOperations::fill(dest.data(), infinity, bandWidth);
+                return;
+            }
+
+            juce::FloatVectorOperations::fill(dest.data(), infinity, first);
+            juce::FloatVectorOperations::copy(dest.data() + first, previousRow.data() + first + offset, last - first);
+            juce::FloatVectorOperations::fill(dest.data() + last, infinity, bandWidth - last);
+        }
+
+        std::vector<std::uint8_t> directions; // takeFrames x bandWidth back-pointers
+        std::vector<int> bandStart;           // First guide frame of each row's band
+        std::vector<float> previousRow;
+        std::vector<float> currentRow;
+        std::vector<float> localCost;
+        std::vector<float> difference;
+        std::vector<float> verticalCandidates;
+        std::vector<float> diagonalCandidates;
+    };
+
+} // namespace dsp
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace dsp
+{
+
+    /**
+     * Magnitude spectrum of an N-sample frame zero-padded to padding * N, without the big FFT.
+     *
+     * Only the first N of the M = padding * N input samples are non-zero, so the M-point DFT
+     * splits by output residue: X[padding * m + r] = sum_n x[n] e^{-2 pi i n r / M} e^{-2 pi i n m / N},
+     * an N-point FFT of the frame modulated by residue r's twiddles (input pruning: the zeros are
+     * never transformed). Residue 0 is the frame's own N-point spectrum, which the caller already
+     * has, and for a real frame |X[k]| = |X[M - k]| maps residue padding - r onto residue r. So 2x
+     * costs one complex N-point FFT and 4x two, on top of the unpadded transform.
+     */
+    class ZeroPaddedSpectrum
+    {
+    public:
+        static constexpr int maxPadding = 4;
+
+        /** @param newPadding 2 or 4. */
+        void prepare(int fftOrder, int newPadding)
+        {
+            size = 1 << fftOrder;
+            padding = newPadding;
+            fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+
+            // Residues 1 .. padding / 2 are transformed; their twiddles e^{-2 pi i n r / M}
+            const int numTransformed = padding / 2;
+            const double paddedSize = (double)size * (double)padding;
+            modulation.resize((size_t)(numTransformed * size));
+            for (int r = 1; r <= numTransformed; ++r)
+                for (int n = 0; n < size; ++n)
+                {
+                    const double phase = -juce::MathConstants<double>::twoPi * (double)n * (double)r / paddedSize;
+                    modulation[(size_t)((r - 1) * size + n)] = {(float)std::cos(phase), (float)std::sin(phase)};
+                }
+
+            modulated.resize((size_t)size);
+            transformed.resize((size_t)(numTransformed * size));
+        }
+
+        int getPadding() const { return padding; }
+        int getNumBins() const { return size * padding / 2 + 1; }
+
+        /**
+         * @param frame     The windowed frame (N samples).
+         * @param unpadded  Its N-point magnitude spectrum (N / 2 + 1 bins).
+         * @param magnitude Output, getNumBins() bins of the padded spectrum.
+         */
+        void process(const float *frame, const std::vector<float> &unpadded, std::vector<float> &magnitude)
+        {
+            const int numTransformed = padding / 2;
+            for (int r = 1; r <= numTransformed; ++r)
+            {
+                const auto *twiddles = modulation.data() + (r - 1) * size;
+                for (int n = 0; n < size; ++n)
+                    modulated[(size_t)n] = frame[n] * twiddles[n];
+
+                fft->perform(modulated.data(), transformed.data() + (r - 1) * size, false);
+            }
+
+            const int halfSize = size / 2;
+            for (int m = 0; m < halfSize; ++m)
+            {
+                float *bins = magnitude.data() + m * padding;
+                bins[0] = unpadded[(size_t)m];
+
+                for (int r = 1; r < padding; ++r)
+                    bins[r] = r <= numTransformed ? std::abs(transformed[(size_t)((r - 1) * size + m)])
+                                                  : std::abs(transformed[(size_t)((padding - r - 1) * size + size - 1 - m)]);
+            }
+            magnitude[(size_t)(halfSize * padding)] = unpadded[(size_t)halfSize];
+        }
+
+    private:
+        int size = 0;
+        int padding = 1;
+        std::unique_ptr<juce::dsp::FFT> fft;
+        std::vector<juce::dsp::Complex<float>> modulation; // Per transformed residue, N twiddles
+        std::vector<juce::dsp::Complex<float>> modulated;
+        std::vector<juce::dsp::Complex<float>> transformed; // Per transformed residue, N bins
+    };
+
+} // namespace dsp
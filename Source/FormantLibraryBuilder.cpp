@@ -0,0 +1,54 @@
+#include "FormantLibraryBuilder.h"
+
+FormantLibraryBuilder::FormantLibraryBuilder()
+{
+  formatManager.registerBasicFormats();
+}
+
+bool FormantLibraryBuilder::analyzeFile(const juce::File &file, dsp::FormantProfile &profile)
+{
+  std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+  if (reader == nullptr || reader->sampleRate <= 0.0)
+    return false;
+
+  const juce::int64 numSamples = juce::jmin<juce::int64>((juce::int64)(reader->sampleRate * maxSecondsPerFile), reader->lengthInSamples);
+  if (numSamples <= 0)
+    return false;
+
+  juce::AudioBuffer<float> buffer(1, (int)numSamples);
+  if (!reader->read(&buffer, 0, (int)numSamples, 0, true, true))
+    return false;
+
+  dsp::SpectralProcessor analyzer;
+  analyzer.setPrepareWarmup(false); // Offline only
+  analyzer.prepare({reader->sampleRate, 512, 1});
+
+  const auto trajectory = analyzer.analyzeFormantTrajectory(buffer, reader->sampleRate);
+  if (trajectory.isEmpty())
+    return false;
+
+  profile = dsp::FormantProfileIndex::makeProfile(trajectory, file.getFileNameWithoutExtension());
+  return true;
+}
+
+int FormantLibraryBuilder::buildFromFolder(const juce::File &folder, dsp::FormantProfileIndex &index, ProgressCallback progress)
+{
+  const auto files = folder.findChildFiles(juce::File::findFiles, true, formatManager.getWildcardForAllFormats());
+
+  std::vector<dsp::FormantProfile> profiles;
+  profiles.reserve((size_t)files.size());
+
+  for (int i = 0; i < files.size(); ++i)
+  {
+    dsp::FormantProfile profile;
+    if (analyzeFile(files.getReference(i), profile))
+      profiles.push_back(std::move(profile));
+
+    if (progress && !progress(i + 1, files.size()))
+      return -1;
+  }
+
+  const int added = (int)profiles.size();
+  index.setProfiles(std::move(profiles));
+  return added;
+}
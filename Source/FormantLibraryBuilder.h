@@ -0,0 +1,38 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <functional>
+#include "DSP/FormantProfileIndex.h"
+
+/**
+ * Analyzes a folder of reference recordings into a FormantProfileIndex.
+ * Shared by the in-plugin library browser and the FormantIndexer command line tool.
+ * Runs the offline analysis chain on its own SpectralProcessor, so it may be used from any
+ * non-realtime thread.
+ */
+class FormantLibraryBuilder
+{
+public:
+    /** Called after each file; return false to cancel. */
+    using ProgressCallback = std::function<bool(int filesDone, int filesTotal)>;
+
+    FormantLibraryBuilder();
+
+    bool analyzeFile(const juce::File &file, dsp::FormantProfile &profile);
+
+    /**
+     * Analyzes every supported audio file below folder (recursively).
+     * @return Number of profiles added, or -1 if cancelled.
+     */
+    int buildFromFolder(const juce::File &folder, dsp::FormantProfileIndex &index, ProgressCallback progress = {});
+
+    juce::String getWildcardForAllFormats() const { return formatManager.getWildcardForAllFormats(); }
+
+private:
+    juce::AudioFormatManager formatManager;
+
+    // Only the first part of each reference is analyzed; a profile is a long-term average.
+    static constexpr double maxSecondsPerFile = 30.0;
+
+    JUCE_DECLARE_NON_COPYABLE(FormantLibraryBuilder)
+};
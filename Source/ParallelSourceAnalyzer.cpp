@@ -0,0 +1,121 @@
+#include "ParallelSourceAnalyzer.h"
+#include <atomic>
+
+ParallelSourceAnalyzer::ParallelSourceAnalyzer(juce::AudioFormatManager &manager)
+    : formatManager(manager)
+{
+}
+
+bool ParallelSourceAnalyzer::analyzeFile(const juce::File &file, double maxSeconds, Result &result, juce::String &message)
+{
+  if (!file.existsAsFile())
+  {
+    message = "ソース音源ファイルが見つかりません。";
+    return false;
+  }
+
+  std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+  if (reader == nullptr || reader->sampleRate <= 0.0)
+  {
+    message = "音源の読み込みに失敗しました。対応フォーマットを確認してください。";
+    return false;
+  }
+
+  const juce::int64 maxReadSamples = juce::jmin<juce::int64>((juce::int64)(reader->sampleRate * maxSeconds), reader->lengthInSamples);
+  if (maxReadSamples <= 0)
+  {
+    message = "音源に有効なサンプルがありません。";
+    return false;
+  }
+
+  const int totalSamples = (int)maxReadSamples;
+  const double sampleRate = reader->sampleRate;
+
+  // Frame layout of the offline analysis; every chunk owns a run of whole frames.
+  dsp::SpectralProcessor layout;
+  layout.setPrepareWarmup(false); // Offline only
+  layout.prepare({sampleRate, 512, 1});
+  const int fftSize = layout.getFftSize();
+  const int hopSize = layout.getTrajectoryHopSize();
+  const int numFrames = layout.getNumTrajectoryFrames(totalSamples);
+  const int framesPerChunk = juce::jmax(1, (int)(chunkSeconds * sampleRate) / hopSize);
+  const int numChunks = (numFrames + framesPerChunk - 1) / framesPerChunk;
+
+  result.samples.setSize(1, totalSamples);
+  result.sampleRate = sampleRate;
+  result.trajectory = {};
+  result.trajectory.sampleRate = sampleRate;
+  result.trajectory.hopSamples = hopSize;
+  result.trajectory.framesHz.resize((size_t)numFrames);
+  result.trajectory.energyDb.resize((size_t)numFrames);
+  result.frameCepstra.assign((size_t)numFrames * dsp::SpectralProcessor::frameCepstrumSize, 0.0f);
+
+  // One reader per chunk, each opened by the job that decodes it: readers keep their own stream
+  // position and decoder state, and opening one (parsing headers, scanning MP3 frames) is work
+  // the workers share too. Chunk 0 reuses the reader that probed the file.
+  std::atomic<bool> openFailed{false};
+  std::atomic<bool> readFailed{false};
+  std::atomic<int> chunksRemaining{numChunks};
+  juce::WaitableEvent allChunksDone;
+
+  auto analyzeChunk = [&](int c)
+  {
+    const int firstFrame = c * framesPerChunk;
+    const int chunkFrames = juce::jmin(framesPerChunk, numFrames - firstFrame);
+    const int firstSample = firstFrame * hopSize;
+    const int lastFrameEnd = juce::jmin(totalSamples, (firstFrame + chunkFrames - 1) * hopSize + fftSize);
+    const int ownedEnd = c == numChunks - 1 ? totalSamples : (firstFrame + chunkFrames) * hopSize;
+    const int decodeStart = juce::jmax(0, firstSample - decoderPreRollSamples);
+    const int decodeEnd = juce::jmax(lastFrameEnd, ownedEnd);
+
+    std::unique_ptr<juce::AudioFormatReader> chunkReader(c == 0 ? reader.release() : formatManager.createReaderFor(file));
+    if (chunkReader == nullptr)
+    {
+      openFailed.store(true);
+      return;
+    }
+
+    juce::AudioBuffer<float> decoded(1, decodeEnd - decodeStart);
+    if (!chunkReader->read(&decoded, 0, decoded.getNumSamples(), decodeStart, true, true))
+    {
+      readFailed.store(true);
+      return;
+    }
+
+    // Owned ranges are disjoint, so the chunks never write the same samples or frames.
+    const float *chunkSamples = decoded.getReadPointer(0, firstSample - decodeStart);
+    result.samples.copyFrom(0, firstSample, chunkSamples, ownedEnd - firstSample);
+
+    dsp::SpectralProcessor analyzer;
+    analyzer.setPrepareWarmup(false);
+    analyzer.prepare({sampleRate, 512, 1});
+    analyzer.analyzeTrajectoryFrames(chunkSamples, totalSamples, sampleRate, firstFrame, chunkFrames, result.trajectory,
+                                     result.frameCepstra.data() + (size_t)firstFrame * dsp::SpectralProcessor::frameCepstrumSize);
+  };
+
+  {
+    juce::ThreadPool pool(juce::jmin(numChunks, juce::SystemStats::getNumCpus()));
+    for (int c = 0; c < numChunks; ++c)
+      pool.addJob([&, c]
+                  {
+        analyzeChunk(c);
+        if (--chunksRemaining == 0)
+          allChunksDone.signal(); });
+
+    allChunksDone.wait();
+  }
+
+  if (openFailed.load())
+  {
+    message = "音源の読み込みに失敗しました。対応フォーマットを確認してください。";
+    return false;
+  }
+
+  if (readFailed.load())
+  {
+    message = "音源サンプルの読取に失敗しました。";
+    return false;
+  }
+
+  return true;
+}
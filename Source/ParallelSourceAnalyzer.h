@@ -0,0 +1,41 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "DSP/SpectralProcessor.h"
+
+/**
+ * Decodes and analyzes a source recording in parallel chunks.
+ * The file is split into chunks of whole trajectory frames; each chunk opens its own reader on
+ * a worker, is decoded there and analyzed right away, so long compressed imports (MP3, FLAC)
+ * use every core from the first byte on instead of decoding the whole file first. The result
+ * is the same as the serial analyzeFormantTrajectory() / analyzeAverageEnvelope() chain.
+ */
+class ParallelSourceAnalyzer
+{
+public:
+    struct Result
+    {
+        juce::AudioBuffer<float> samples; // Mono, the analyzed part of the file
+        double sampleRate = 0.0;
+        dsp::SpectralProcessor::FormantTrajectory trajectory;
+        std::vector<float> frameCepstra; // SpectralProcessor::frameCepstrumSize per trajectory frame
+    };
+
+    explicit ParallelSourceAnalyzer(juce::AudioFormatManager &formatManager);
+
+    /** Reads up to maxSeconds of file. On failure message holds the reason for the user. */
+    bool analyzeFile(const juce::File &file, double maxSeconds, Result &result, juce::String &message);
+
+private:
+    juce::AudioFormatManager &formatManager;
+
+    // About 8 s per chunk: enough to amortize the seek and pre-roll, small enough to spread a
+    // song over all cores.
+    static constexpr double chunkSeconds = 8.0;
+
+    // Decoded and dropped before each chunk: covers the MP3 bit reservoir and lets a decoder
+    // settle after the seek, so chunk boundaries decode exactly like a serial read.
+    static constexpr int decoderPreRollSamples = 4096;
+
+    JUCE_DECLARE_NON_COPYABLE(ParallelSourceAnalyzer)
+};
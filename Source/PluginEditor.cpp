@@ -9,6 +9,19 @@ namespace
   }
 }
 
+XYFormantPad::XYFormantPad(SpectralFormantMorpherAudioProcessor &p)
+    : processor(p),
+      f1Param(p.getAPVTS().getParameter("FORMANT_1")),
+      f2Param(p.getAPVTS().getParameter("FORMANT_2"))
+{
+}
+
+XYFormantPad::~XYFormantPad()
+{
+  // Closing the editor mid-drag still ends the gesture.
+  endGesture();
+}
+
 void XYFormantPad::paint(juce::Graphics &g)
 {
   auto bounds = getLocalBounds().toFloat().reduced(10.0f);
@@ -17,8 +30,9 @@ void XYFormantPad::paint(juce::Graphics &g)
   g.setColour(juce::Colours::grey);
   g.drawRoundedRectangle(bounds, 8.0f, 1.0f);
 
-  const float f1 = processor.getAPVTS().getRawParameterValue("FORMANT_1")->load();
-  const float f2 = processor.getAPVTS().getRawParameterValue("FORMANT_2")->load();
+  // While dragging, the pointer position (the host may not have the latest write yet)
+  const float f1 = dragging ? pendingF1 : processor.getAPVTS().getRawParameterValue("FORMANT_1")->load();
+  const float f2 = dragging ? pendingF2 : processor.getAPVTS().getRawParameterValue("FORMANT_2")->load();
 
   const float x = juce::jmap(f2, 800.0f, 3500.0f, bounds.getX(), bounds.getRight());
   const float y = juce::jmap(f1, 1000.0f, 200.0f, bounds.getY(), bounds.getBottom());
@@ -33,12 +47,64 @@ void XYFormantPad::paint(juce::Graphics &g)
 
 void XYFormantPad::mouseDown(const juce::MouseEvent &event)
 {
+  if (f1Param == nullptr || f2Param == nullptr)
+    return;
+
+  f1Param->beginChangeGesture();
+  f2Param->beginChangeGesture();
+  dragging = true;
+
+  // The first point is written right away, the rest at writeRateHz.
   updateFromPosition(event.position);
+  writePendingValues();
+  startTimerHz(writeRateHz);
 }
 
 void XYFormantPad::mouseDrag(const juce::MouseEvent &event)
 {
-  updateFromPosition(event.position);
+  if (dragging)
+    updateFromPosition(event.position);
+}
+
+void XYFormantPad::mouseUp(const juce::MouseEvent &)
+{
+  endGesture();
+  repaint();
+}
+
+void XYFormantPad::timerCallback()
+{
+  writePendingValues();
+}
+
+void XYFormantPad::writePendingValues()
+{
+  if (!hasPendingWrite)
+    return;
+
+  hasPendingWrite = false;
+
+  // Unchanged values are not sent again (a pointer held still, or moving along one axis).
+  const float f1Value = f1Param->convertTo0to1(pendingF1);
+  if (f1Value != f1Param->getValue())
+    f1Param->setValueNotifyingHost(f1Value);
+
+  const float f2Value = f2Param->convertTo0to1(pendingF2);
+  if (f2Value != f2Param->getValue())
+    f2Param->setValueNotifyingHost(f2Value);
+}
+
+void XYFormantPad::endGesture()
+{
+  if (!dragging)
+    return;
+
+  stopTimer();
+  writePendingValues(); // The release position is always the last value of the gesture
+  dragging = false;
+
+  f1Param->endChangeGesture();
+  f2Param->endChangeGesture();
 }
 
 void XYFormantPad::updateFromPosition(juce::Point<float> pos)
@@ -47,14 +113,9 @@ void XYFormantPad::updateFromPosition(juce::Point<float> pos)
   const float x = juce::jlimit(bounds.getX(), bounds.getRight(), pos.x);
   const float y = juce::jlimit(bounds.getY(), bounds.getBottom(), pos.y);
 
-  const float newF2 = juce::jmap(x, bounds.getX(), bounds.getRight(), 800.0f, 3500.0f);
-  const float newF1 = juce::jmap(y, bounds.getBottom(), bounds.getY(), 200.0f, 1000.0f);
-
-  if (auto *f1Param = processor.getAPVTS().getParameter("FORMANT_1"))
-    f1Param->setValueNotifyingHost(f1Param->convertTo0to1(newF1));
-
-  if (auto *f2Param = processor.getAPVTS().getParameter("FORMANT_2"))
-    f2Param->setValueNotifyingHost(f2Param->convertTo0to1(newF2));
+  pendingF2 = juce::jmap(x, bounds.getX(), bounds.getRight(), 800.0f, 3500.0f);
+  pendingF1 = juce::jmap(y, bounds.getBottom(), bounds.getY(), 200.0f, 1000.0f);
+  hasPendingWrite = true;
 
   repaint();
 }
@@ -108,19 +169,125 @@ SpectralFormantMorpherAudioProcessorEditor::SpectralFormantMorpherAudioProcessor
   gainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
       audioProcessor.getAPVTS(), "OUTPUT_GAIN", gainSlider);
 
+  // Pitch shift slider
+  pitchSlider.setSliderStyle(juce::Slider::Rotary);
+  pitchSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 16);
+  pitchSlider.setTextValueSuffix(" st");
+  addAndMakeVisible(pitchSlider);
+  pitchLabel.setText("Pitch", juce::dontSendNotification);
+  pitchLabel.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(pitchLabel);
+  pitchAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+      audioProcessor.getAPVTS(), "PITCH_SHIFT", pitchSlider);
+
+  addAndMakeVisible(keepFormantsToggle);
+  keepFormantsAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+      audioProcessor.getAPVTS(), "PITCH_KEEP_FORMANTS", keepFormantsToggle);
+
+  // Global scale mode
+  addAndMakeVisible(scaleModeToggle);
+  scaleModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+      audioProcessor.getAPVTS(), "SCALE_MODE", scaleModeToggle);
+
+  scaleSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+  scaleSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 54, 18);
+  scaleSlider.setTextValueSuffix(" x");
+  addAndMakeVisible(scaleSlider);
+  scaleAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+      audioProcessor.getAPVTS(), "FORMANT_SCALE", scaleSlider);
+
+  scaleBlendSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+  scaleBlendSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 54, 18);
+  scaleBlendSlider.setTextValueSuffix(" %");
+  addAndMakeVisible(scaleBlendSlider);
+  scaleBlendAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+      audioProcessor.getAPVTS(), "SCALE_BLEND", scaleBlendSlider);
+
+  // Resynthesis engine (items must exist before the attachment syncs the selection)
+  engineBox.addItemList({"STFT", "正弦波+ノイズ", "LPC (低負荷)"}, 1);
+  addAndMakeVisible(engineBox);
+  engineAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.getAPVTS(), "ENGINE", engineBox);
+
+  // STFT frame size, switched without interrupting playback
+  fftSizeBox.addItemList({"FFT 512", "FFT 1024", "FFT 2048", "FFT 4096"}, 1);
+  addAndMakeVisible(fftSizeBox);
+  fftSizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.getAPVTS(), "FFT_SIZE", fftSizeBox);
+
+  // Zero-padded envelope analysis (same window / latency)
+  paddingBox.addItemList({"ゼロ詰めなし", "ゼロ詰め 2x", "ゼロ詰め 4x"}, 1);
+  addAndMakeVisible(paddingBox);
+  paddingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.getAPVTS(), "ANALYSIS_PADDING", paddingBox);
+
+  // Minimum-phase monitoring path (STFT engine)
+  addAndMakeVisible(zeroLatencyToggle);
+  zeroLatencyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+      audioProcessor.getAPVTS(), "ZERO_LATENCY", zeroLatencyToggle);
+
+  // Reduced-resolution (mel band) envelope
+  addAndMakeVisible(bandModeToggle);
+  bandModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+      audioProcessor.getAPVTS(), "BAND_MODE", bandModeToggle);
+
+  // Envelope warping on the cepstral coefficients
+  addAndMakeVisible(cepstralWarpToggle);
+  cepstralWarpAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+      audioProcessor.getAPVTS(), "CEPSTRAL_WARP", cepstralWarpToggle);
+
+  // Imported source's whole envelope as the target
+  addAndMakeVisible(fullEnvelopeToggle);
+  fullEnvelopeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+      audioProcessor.getAPVTS(), "FULL_ENVELOPE_TARGET", fullEnvelopeToggle);
+
   loadSourceButton.addListener(this);
   addAndMakeVisible(loadSourceButton);
 
+  alignTakeButton.addListener(this);
+  addAndMakeVisible(alignTakeButton);
+
+  clearAlignButton.addListener(this);
+  addAndMakeVisible(clearAlignButton);
+
+  for (auto *button : {&buildLibraryButton, &loadLibraryButton, &applyProfileButton, &recordTrackButton, &importTrackButton, &storeSlotButton})
+  {
+    button->addListener(this);
+    addAndMakeVisible(*button);
+  }
+
+  for (int slot = 0; slot < SpectralFormantMorpherAudioProcessor::numVowelSlots; ++slot)
+    vowelSlotBox.addItem(SpectralFormantMorpherAudioProcessor::getVowelSlotName(slot), slot + 1);
+  vowelSlotBox.setSelectedItemIndex(0, juce::dontSendNotification);
+  addAndMakeVisible(vowelSlotBox);
+
+  nearestProfileBox.setTextWhenNothingSelected("最も近いリファレンス");
+  nearestProfileBox.setTextWhenNoChoicesAvailable("ライブラリ未読込");
+  nearestProfileBox.onChange = [this]
+  {
+    // Only user selections notify; the refresh selects with dontSendNotification.
+    const int item = nearestProfileBox.getSelectedItemIndex();
+    if (juce::isPositiveAndBelow(item, (int)nearestProfiles.size()))
+      chosenProfileIndex = nearestProfiles[(size_t)item].index;
+  };
+  addAndMakeVisible(nearestProfileBox);
+
   statusLabel.setText("ソース音源を読み込むとF1〜F15を自動設定します", juce::dontSendNotification);
   statusLabel.setJustificationType(juce::Justification::centredLeft);
   addAndMakeVisible(statusLabel);
 
-  setSize(1080, 680);
+  setSize(1160, 744);
+  startTimerHz(4);
 }
 
 SpectralFormantMorpherAudioProcessorEditor::~SpectralFormantMorpherAudioProcessorEditor()
 {
   loadSourceButton.removeListener(this);
+  alignTakeButton.removeListener(this);
+  clearAlignButton.removeListener(this);
+
+  for (auto *button : {&buildLibraryButton, &loadLibraryButton, &applyProfileButton, &recordTrackButton, &importTrackButton, &storeSlotButton})
+    button->removeListener(this);
 }
 
 void SpectralFormantMorpherAudioProcessorEditor::paint(juce::Graphics &g)
@@ -134,17 +301,44 @@ void SpectralFormantMorpherAudioProcessorEditor::resized()
 
   auto top = area.removeFromTop(34);
   loadSourceButton.setBounds(top.removeFromLeft(220));
+  alignTakeButton.setBounds(top.removeFromLeft(130).withTrimmedLeft(6));
+  clearAlignButton.setBounds(top.removeFromLeft(96).withTrimmedLeft(6));
+  cepstralWarpToggle.setBounds(top.removeFromRight(150));
+  fullEnvelopeToggle.setBounds(top.removeFromRight(140));
+  paddingBox.setBounds(top.removeFromRight(116).withTrimmedRight(6));
   statusLabel.setBounds(top.reduced(8, 0));
 
+  auto libraryRow = area.removeFromTop(34).withTrimmedTop(6);
+  buildLibraryButton.setBounds(libraryRow.removeFromLeft(130));
+  loadLibraryButton.setBounds(libraryRow.removeFromLeft(136).withTrimmedLeft(6));
+  vowelSlotBox.setBounds(libraryRow.removeFromLeft(96).withTrimmedLeft(6));
+  storeSlotButton.setBounds(libraryRow.removeFromLeft(106).withTrimmedLeft(6));
+  importTrackButton.setBounds(libraryRow.removeFromRight(96));
+  recordTrackButton.setBounds(libraryRow.removeFromRight(102).withTrimmedRight(6));
+  applyProfileButton.setBounds(libraryRow.removeFromRight(76).withTrimmedRight(6));
+  nearestProfileBox.setBounds(libraryRow.reduced(6, 0));
+
+  auto optionsRow = area.removeFromTop(30).withTrimmedTop(4);
+  engineBox.setBounds(optionsRow.removeFromRight(150));
+  fftSizeBox.setBounds(optionsRow.removeFromRight(96).withTrimmedRight(6));
+  zeroLatencyToggle.setBounds(optionsRow.removeFromRight(130));
+  bandModeToggle.setBounds(optionsRow.removeFromRight(110));
+  keepFormantsToggle.setBounds(optionsRow.removeFromLeft(240));
+  scaleModeToggle.setBounds(optionsRow.removeFromLeft(110));
+  scaleSlider.setBounds(optionsRow.removeFromLeft(150));
+  scaleBlendSlider.setBounds(optionsRow.removeFromLeft(150).withTrimmedLeft(8));
+
   auto mid = area.removeFromTop(320);
 
-  // Left column: XY pad + Mix/Gain knobs
+  // Left column: XY pad + Mix/Gain/Pitch knobs
   auto left = mid.removeFromLeft(300);
   xyPad.setBounds(left.removeFromTop(200));
 
   auto knobArea = left.removeFromTop(110);
-  auto mixArea = knobArea.removeFromLeft(knobArea.getWidth() / 2);
-  auto gainArea = knobArea;
+  const int knobWidth = knobArea.getWidth() / 3;
+  auto mixArea = knobArea.removeFromLeft(knobWidth);
+  auto gainArea = knobArea.removeFromLeft(knobWidth);
+  auto pitchArea = knobArea;
 
   mixLabel.setBounds(mixArea.removeFromTop(18));
   mixSlider.setBounds(mixArea.reduced(8));
@@ -152,6 +346,9 @@ void SpectralFormantMorpherAudioProcessorEditor::resized()
   gainLabel.setBounds(gainArea.removeFromTop(18));
   gainSlider.setBounds(gainArea.reduced(8));
 
+  pitchLabel.setBounds(pitchArea.removeFromTop(18));
+  pitchSlider.setBounds(pitchArea.reduced(8));
+
   // Right: spectrum visualizer
   visualizer.setBounds(mid);
 
@@ -169,6 +366,63 @@ void SpectralFormantMorpherAudioProcessorEditor::resized()
 
 void SpectralFormantMorpherAudioProcessorEditor::buttonClicked(juce::Button *button)
 {
+  if (button == &alignTakeButton)
+  {
+    chooseTakeAndAlign();
+    return;
+  }
+
+  if (button == &clearAlignButton)
+  {
+    audioProcessor.clearAlignedTrajectory();
+    showStatus("テイク整列を解除しました", true);
+    return;
+  }
+
+  if (button == &storeSlotButton)
+  {
+    const int slot = vowelSlotBox.getSelectedItemIndex();
+    audioProcessor.storeVowelSlot(slot);
+    showStatus("現在のF1〜F15をスロット " + SpectralFormantMorpherAudioProcessor::getVowelSlotName(slot) + " に保存しました", true);
+    return;
+  }
+
+  if (button == &recordTrackButton)
+  {
+    toggleTrackRecording();
+    return;
+  }
+
+  if (button == &importTrackButton)
+  {
+    chooseTrackAndImport();
+    return;
+  }
+
+  if (button == &buildLibraryButton)
+  {
+    chooseLibraryFolderAndBuild();
+    return;
+  }
+
+  if (button == &loadLibraryButton)
+  {
+    chooseLibraryIndexAndLoad();
+    return;
+  }
+
+  if (button == &applyProfileButton)
+  {
+    const int selected = nearestProfileBox.getSelectedItemIndex();
+    juce::String message;
+    const bool ok = juce::isPositiveAndBelow(selected, (int)nearestProfiles.size())
+                        ? audioProcessor.applyLibraryProfile(nearestProfiles[(size_t)selected].index, message)
+                        : audioProcessor.applyLibraryProfile(-1, message);
+    showStatus(message, ok);
+    xyPad.repaint();
+    return;
+  }
+
   if (button != &loadSourceButton)
     return;
 
@@ -177,6 +431,109 @@ void SpectralFormantMorpherAudioProcessorEditor::buttonClicked(juce::Button *but
       juce::File(),
       "*.wav;*.aif;*.aiff;*.flac;*.mp3");
 
+  constexpr int chooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+  sourceFileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser &chooser)
+                                 {
+        const auto file = chooser.getResult();
+        if (!file.existsAsFile())
+            return;
+
+        // Long files take a while: analyzed on the processor's thread and applied by the
+        // processor on the message thread, even if this editor has closed by then.
+        juce::Component::SafePointer<SpectralFormantMorpherAudioProcessorEditor> safeThis(this);
+        const bool started = audioProcessor.startSourceImport(file, [safeThis](bool ok, const juce::String &message)
+        {
+            if (safeThis == nullptr)
+                return;
+
+            safeThis->updateSourceAnalysisButtons();
+            safeThis->showStatus(message, ok);
+            safeThis->xyPad.repaint();
+        });
+
+        if (!started)
+            return;
+
+        updateSourceAnalysisButtons();
+        showStatus("ソース音源を解析中...", true); });
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::chooseTakeAndAlign()
+{
+  sourceFileChooser = std::make_unique<juce::FileChooser>(
+      "整列先のテイクを選択",
+      juce::File(),
+      "*.wav;*.aif;*.aiff;*.flac;*.mp3");
+
+  constexpr int chooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+  sourceFileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser &chooser)
+                                 {
+        const auto file = chooser.getResult();
+        if (!file.existsAsFile())
+            return;
+
+        juce::Component::SafePointer<SpectralFormantMorpherAudioProcessorEditor> safeThis(this);
+        const bool started = audioProcessor.startTakeAlignment(file, [safeThis](bool ok, const juce::String &message)
+        {
+            if (safeThis == nullptr)
+                return;
+
+            safeThis->updateSourceAnalysisButtons();
+            safeThis->showStatus(message, ok);
+        });
+
+        if (!started)
+            return;
+
+        updateSourceAnalysisButtons();
+        showStatus("テイクを解析中...", true); });
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::updateSourceAnalysisButtons()
+{
+  const bool idle = !audioProcessor.isSourceAnalysisRunning();
+  loadSourceButton.setEnabled(idle);
+  alignTakeButton.setEnabled(idle);
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::toggleTrackRecording()
+{
+  juce::String message;
+  if (audioProcessor.isFormantRecording())
+  {
+    audioProcessor.stopFormantRecording(message);
+    recordTrackButton.setButtonText("学習録音");
+    showStatus(message, true);
+    return;
+  }
+
+  sourceFileChooser = std::make_unique<juce::FileChooser>(
+      "録音する軌跡ファイルを指定",
+      juce::File(),
+      juce::String("*") + dsp::FormantRecorder::fileExtension);
+
+  constexpr int chooserFlags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                               | juce::FileBrowserComponent::warnAboutOverwriting;
+  sourceFileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser &chooser)
+                                 {
+        const auto file = chooser.getResult();
+        if (file == juce::File())
+            return;
+
+        juce::String message;
+        const bool ok = audioProcessor.startFormantRecording(file.withFileExtension(dsp::FormantRecorder::fileExtension), message);
+        if (ok)
+            recordTrackButton.setButtonText("録音停止");
+        showStatus(message, ok); });
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::chooseTrackAndImport()
+{
+  sourceFileChooser = std::make_unique<juce::FileChooser>(
+      "フォルマント軌跡を選択",
+      juce::File(),
+      juce::String("*") + dsp::FormantRecorder::fileExtension);
+
   constexpr int chooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
   sourceFileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser &chooser)
                                  {
@@ -185,9 +542,137 @@ void SpectralFormantMorpherAudioProcessorEditor::buttonClicked(juce::Button *but
             return;
 
         juce::String message;
-        const bool ok = audioProcessor.analyzeSourceFileAndApplyFormants(file, message);
+        const bool ok = audioProcessor.importFormantTrack(file, message);
+        showStatus(message, ok); });
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::chooseLibraryFolderAndBuild()
+{
+  if (audioProcessor.isProfileLibraryBuildRunning())
+    return;
 
-        statusLabel.setText(message, juce::dontSendNotification);
-        statusLabel.setColour(juce::Label::textColourId, ok ? juce::Colours::lightgreen : juce::Colours::orange);
-        xyPad.repaint(); });
+  sourceFileChooser = std::make_unique<juce::FileChooser>("リファレンス音源のフォルダを選択", juce::File());
+
+  constexpr int chooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories;
+  sourceFileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser &chooser)
+                                 {
+        const auto folder = chooser.getResult();
+        if (!folder.isDirectory())
+            return;
+
+        // Thousands of files take a while: analyzed on the processor's build thread, which
+        // outlives this editor; results come back through the message thread.
+        juce::Component::SafePointer<SpectralFormantMorpherAudioProcessorEditor> safeThis(this);
+        const bool started = audioProcessor.startProfileLibraryBuild(folder, [safeThis](int done, int total)
+        {
+            if (done % 16 == 0 || done == total)
+                juce::MessageManager::callAsync([safeThis, done, total]
+                {
+                    if (safeThis != nullptr)
+                        safeThis->showStatus("ライブラリを解析中... " + juce::String(done) + " / " + juce::String(total), true);
+                });
+            return true;
+        },
+        [safeThis](bool ok, const juce::String &message)
+        {
+            juce::MessageManager::callAsync([safeThis, ok, message]
+            {
+                if (safeThis == nullptr)
+                    return;
+
+                safeThis->buildLibraryButton.setEnabled(true);
+                safeThis->showStatus(message, ok);
+                safeThis->chosenProfileIndex = -1; // Indices of the new library
+                safeThis->refreshNearestProfiles();
+            });
+        });
+
+        if (!started)
+            return;
+
+        buildLibraryButton.setEnabled(false);
+        showStatus("ライブラリを解析中...", true); });
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::chooseLibraryIndexAndLoad()
+{
+  sourceFileChooser = std::make_unique<juce::FileChooser>(
+      "ライブラリ索引を選択",
+      juce::File(),
+      "*.sfpi");
+
+  constexpr int chooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+  sourceFileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser &chooser)
+                                 {
+        const auto file = chooser.getResult();
+        if (!file.existsAsFile())
+            return;
+
+        juce::String message;
+        const bool ok = audioProcessor.loadProfileLibrary(file, message);
+        showStatus(message, ok);
+        if (ok)
+            chosenProfileIndex = -1;
+        refreshNearestProfiles(); });
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::timerCallback()
+{
+  // The recorder outlives the editor, so a reopened editor picks the state up here.
+  recordTrackButton.setButtonText(audioProcessor.isFormantRecording() ? "録音停止" : "学習録音");
+  buildLibraryButton.setEnabled(!audioProcessor.isProfileLibraryBuildRunning());
+  updateSourceAnalysisButtons();
+  refreshNearestProfiles();
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::refreshNearestProfiles()
+{
+  // Don't rebuild the list under the user's mouse.
+  if (nearestProfileBox.isPopupActive() || audioProcessor.getProfileLibrarySize() == 0)
+    return;
+
+  auto matches = audioProcessor.findClosestProfiles(5);
+
+  // The reference the user picked stays in the list (and selected) when it drops out of the nearest.
+  const auto isChosen = [this](const auto &match)
+  { return match.index == chosenProfileIndex; };
+  if (chosenProfileIndex >= 0 && std::none_of(matches.begin(), matches.end(), isChosen))
+  {
+    const auto previous = std::find_if(nearestProfiles.begin(), nearestProfiles.end(), isChosen);
+    if (previous != nearestProfiles.end())
+      matches.push_back(*previous);
+  }
+
+  const auto itemText = [](const auto &match)
+  { return match.name + "  (d=" + juce::String(match.distance, 2) + ")"; };
+
+  // Same ranking: only the distances change, the items and the selection stay.
+  const bool sameRanking = std::equal(matches.begin(), matches.end(), nearestProfiles.begin(), nearestProfiles.end(),
+                                      [](const auto &a, const auto &b)
+                                      { return a.index == b.index; });
+  nearestProfiles = std::move(matches);
+  if (sameRanking)
+  {
+    for (size_t i = 0; i < nearestProfiles.size(); ++i)
+      nearestProfileBox.changeItemText((int)i + 1, itemText(nearestProfiles[i]));
+    return;
+  }
+
+  nearestProfileBox.clear(juce::dontSendNotification);
+  int selected = 0;
+  for (size_t i = 0; i < nearestProfiles.size(); ++i)
+  {
+    nearestProfileBox.addItem(itemText(nearestProfiles[i]), (int)i + 1);
+    if (nearestProfiles[i].index == chosenProfileIndex)
+      selected = (int)i;
+  }
+
+  if (!nearestProfiles.empty())
+    nearestProfileBox.setSelectedItemIndex(selected, juce::dontSendNotification);
+}
+
+void SpectralFormantMorpherAudioProcessorEditor::showStatus(const juce::String &message, bool ok)
+{
+  statusLabel.setText(message, juce::dontSendNotification);
+  statusLabel.setColour(juce::Label::textColourId, ok ? juce::Colours::lightgreen : juce::Colours::orange);
 }
@@ -46,7 +46,17 @@ public:
 
   void timerCallback() override
   {
-    processor.getSpectralProcessor().getLatestVisualizationData(lastSpectrum, lastEnvelope, lastF1, lastF2);
+    processor.getSpectralContexts().getLatestVisualizationData(lastSpectrum, lastEnvelope, lastF1, lastF2);
+    repaint();
+  }
+
+  // Shows a given frame (f1/f2 in bins), e.g. to paint without a running processor
+  void setFrame(const std::vector<float> &spectrum, const std::vector<float> &envelope, float f1, float f2)
+  {
+    lastSpectrum = spectrum;
+    lastEnvelope = envelope;
+    lastF1 = f1;
+    lastF2 = f2;
     repaint();
   }
 
@@ -107,26 +117,40 @@ private:
   }
 };
 
-class XYFormantPad : public juce::Component
+// F1/F2 pad. A drag is one change gesture per parameter; positions are coalesced and written to
+// the host at most writeRateHz times a second (the DSP glides between them per hop).
+class XYFormantPad : public juce::Component, private juce::Timer
 {
 public:
-  explicit XYFormantPad(SpectralFormantMorpherAudioProcessor &p)
-      : processor(p)
-  {
-  }
+  explicit XYFormantPad(SpectralFormantMorpherAudioProcessor &p);
+  ~XYFormantPad() override;
 
   void paint(juce::Graphics &g) override;
   void mouseDown(const juce::MouseEvent &event) override;
   void mouseDrag(const juce::MouseEvent &event) override;
+  void mouseUp(const juce::MouseEvent &event) override;
+
+  static constexpr int writeRateHz = 60;
 
 private:
   SpectralFormantMorpherAudioProcessor &processor;
+  juce::RangedAudioParameter *f1Param = nullptr;
+  juce::RangedAudioParameter *f2Param = nullptr;
+
+  bool dragging = false;
+  bool hasPendingWrite = false;
+  float pendingF1 = 0.0f;
+  float pendingF2 = 0.0f;
 
   void updateFromPosition(juce::Point<float> pos);
+  void writePendingValues();
+  void endGesture();
+  void timerCallback() override;
 };
 
 class SpectralFormantMorpherAudioProcessorEditor : public juce::AudioProcessorEditor,
-                                                   private juce::Button::Listener
+                                                   private juce::Button::Listener,
+                                                   private juce::Timer
 {
 public:
   explicit SpectralFormantMorpherAudioProcessorEditor(SpectralFormantMorpherAudioProcessor &);
@@ -146,6 +170,10 @@ private:
   std::vector<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>> formantAttachments;
 
   juce::TextButton loadSourceButton{"ソース音源を読み込む"};
+  juce::TextButton alignTakeButton{"テイクに整列"};
+  juce::TextButton clearAlignButton{"整列解除"};
+  juce::TextButton recordTrackButton{"学習録音"};
+  juce::TextButton importTrackButton{"軌跡読込"};
   juce::Label statusLabel;
   std::unique_ptr<juce::FileChooser> sourceFileChooser;
 
@@ -158,7 +186,57 @@ private:
   juce::Label gainLabel;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
 
+  juce::Slider pitchSlider;
+  juce::Label pitchLabel;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> pitchAttachment;
+
+  // Mode options row
+  juce::ToggleButton keepFormantsToggle{"ピッチ時に元のフォルマントを保持"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> keepFormantsAttachment;
+
+  juce::ToggleButton scaleModeToggle{"全体スケール"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> scaleModeAttachment;
+  juce::Slider scaleSlider;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> scaleAttachment;
+  juce::Slider scaleBlendSlider;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> scaleBlendAttachment;
+  juce::ComboBox engineBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> engineAttachment;
+  juce::ComboBox fftSizeBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> fftSizeAttachment;
+  juce::ComboBox paddingBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> paddingAttachment;
+  juce::ToggleButton zeroLatencyToggle{"ゼロレイテンシー"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> zeroLatencyAttachment;
+  juce::ToggleButton bandModeToggle{"バンド包絡"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bandModeAttachment;
+  juce::ToggleButton cepstralWarpToggle{"ケプストラム変形"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> cepstralWarpAttachment;
+  juce::ToggleButton fullEnvelopeToggle{"ソース包絡全体"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> fullEnvelopeAttachment;
+
+  // Reference library browser
+  juce::TextButton buildLibraryButton{"ライブラリ作成"};
+  juce::TextButton loadLibraryButton{"ライブラリ読込"};
+  juce::ComboBox nearestProfileBox;
+  juce::TextButton applyProfileButton{"適用"};
+  std::vector<SpectralFormantMorpherAudioProcessor::LibraryMatch> nearestProfiles;
+  int chosenProfileIndex = -1; // Library index the user selected, kept across refreshes
+
+  // MIDI vowel slots
+  juce::ComboBox vowelSlotBox;
+  juce::TextButton storeSlotButton{"スロット保存"};
+
   void buttonClicked(juce::Button *button) override;
+  void timerCallback() override;
+  void chooseTakeAndAlign();
+  void updateSourceAnalysisButtons();
+  void toggleTrackRecording();
+  void chooseTrackAndImport();
+  void chooseLibraryFolderAndBuild();
+  void chooseLibraryIndexAndLoad();
+  void refreshNearestProfiles();
+  void showStatus(const juce::String &message, bool ok);
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectralFormantMorpherAudioProcessorEditor)
 };
@@ -14,6 +14,37 @@ namespace
   {
     return "FORMANT_" + juce::String((int)index + 1);
   }
+
+  // Default vowel slots: Japanese a, i, u, e, o (F1-F3); higher formants and the other slots use the defaults
+  constexpr std::array<std::array<float, 3>, 5> defaultVowelsHz{{{800.0f, 1200.0f, 2500.0f},
+                                                                 {300.0f, 2300.0f, 3000.0f},
+                                                                 {350.0f, 1400.0f, 2500.0f},
+                                                                 {500.0f, 1900.0f, 2500.0f},
+                                                                 {500.0f, 800.0f, 2500.0f}}};
+
+  const juce::Identifier vowelSlotsType("VOWEL_SLOTS");
+
+  juce::Identifier vowelSlotProperty(int slot)
+  {
+    return "SLOT_" + juce::String(slot + 1);
+  }
+
+  // Upper bound for whole-file analysis (guide / take trajectories)
+  constexpr double maxTrajectorySeconds = 600.0;
+
+  // ENGINE choice index -> engine (same order as the parameter's choices)
+  dsp::SpectralProcessor::Engine engineFromParameter(float choiceIndex)
+  {
+    switch ((int)std::lround(choiceIndex))
+    {
+    case 1:
+      return dsp::SpectralProcessor::Engine::sinusoidal;
+    case 2:
+      return dsp::SpectralProcessor::Engine::lpc;
+    default:
+      return dsp::SpectralProcessor::Engine::stft;
+    }
+  }
 }
 
 SpectralFormantMorpherAudioProcessor::SpectralFormantMorpherAudioProcessor()
@@ -25,21 +56,53 @@ SpectralFormantMorpherAudioProcessor::SpectralFormantMorpherAudioProcessor()
 #endif
 {
   formatManager.registerBasicFormats();
+  spectralContexts.setFormantRecorder(&formantRecorder);
+  loadVowelSlotsFromState();
 
   for (size_t i = 0; i < dsp::SpectralProcessor::numFormants; ++i)
     apvts.addParameterListener(formantParamId(i), this);
 
   apvts.addParameterListener("MIX", this);
   apvts.addParameterListener("OUTPUT_GAIN", this);
+  apvts.addParameterListener("PITCH_SHIFT", this);
+  apvts.addParameterListener("PITCH_KEEP_FORMANTS", this);
+  apvts.addParameterListener("SCALE_MODE", this);
+  apvts.addParameterListener("FORMANT_SCALE", this);
+  apvts.addParameterListener("SCALE_BLEND", this);
+  apvts.addParameterListener("ENGINE", this);
+  apvts.addParameterListener("FFT_SIZE", this);
+  apvts.addParameterListener("ANALYSIS_PADDING", this);
+  apvts.addParameterListener("ZERO_LATENCY", this);
+  apvts.addParameterListener("BAND_MODE", this);
+  apvts.addParameterListener("CEPSTRAL_WARP", this);
+  apvts.addParameterListener("FULL_ENVELOPE_TARGET", this);
 }
 
 SpectralFormantMorpherAudioProcessor::~SpectralFormantMorpherAudioProcessor()
 {
+  // Cancels a running library build and waits for it: it uses this processor.
+  libraryBuildThread.reset();
+  // A source analysis can't be cancelled mid-file; its result is dropped.
+  sourceAnalysisThread.reset();
+  cancelPendingUpdate();
+
   for (size_t i = 0; i < dsp::SpectralProcessor::numFormants; ++i)
     apvts.removeParameterListener(formantParamId(i), this);
 
   apvts.removeParameterListener("MIX", this);
   apvts.removeParameterListener("OUTPUT_GAIN", this);
+  apvts.removeParameterListener("PITCH_SHIFT", this);
+  apvts.removeParameterListener("PITCH_KEEP_FORMANTS", this);
+  apvts.removeParameterListener("SCALE_MODE", this);
+  apvts.removeParameterListener("FORMANT_SCALE", this);
+  apvts.removeParameterListener("SCALE_BLEND", this);
+  apvts.removeParameterListener("ENGINE", this);
+  apvts.removeParameterListener("FFT_SIZE", this);
+  apvts.removeParameterListener("ANALYSIS_PADDING", this);
+  apvts.removeParameterListener("ZERO_LATENCY", this);
+  apvts.removeParameterListener("BAND_MODE", this);
+  apvts.removeParameterListener("CEPSTRAL_WARP", this);
+  apvts.removeParameterListener("FULL_ENVELOPE_TARGET", this);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SpectralFormantMorpherAudioProcessor::createParameterLayout()
@@ -81,6 +144,63 @@ juce::AudioProcessorValueTreeState::ParameterLayout SpectralFormantMorpherAudioP
       juce::NormalisableRange<float>(-24.0f, 6.0f, 0.1f),
       0.0f));
 
+  // Pitch shift of the fine structure (semitones), computed in the same STFT pass
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "PITCH_SHIFT", "Pitch Shift",
+      juce::NormalisableRange<float>(-12.0f, 12.0f, 0.01f),
+      0.0f));
+
+  // Re-impose the input's own formants after pitch shifting instead of the warped ones
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "PITCH_KEEP_FORMANTS", "Pitch: Keep Original Formants", false));
+
+  // Global formant scaling: one ratio for all formants, no peak detection
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "SCALE_MODE", "Global Scale Mode", false));
+
+  juce::NormalisableRange<float> scaleRange(0.5f, 2.0f, 0.001f);
+  scaleRange.setSkewForCentre(1.0f);
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "FORMANT_SCALE", "Formant Scale", scaleRange, 1.0f));
+
+  // 0% = pure scaling, 100% = per-formant F1~F15 targets
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "SCALE_BLEND", "Scale/Formant Blend",
+      juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f),
+      0.0f));
+
+  // Resynthesis engine: STFT bin scaling, harmonic oscillators + noise, or time-domain LPC (low CPU, no latency)
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "ENGINE", "Engine", juce::StringArray{"STFT", "Sinusoidal", "LPC"}, 0));
+
+  // STFT frame size (LPC keeps its own); changes are crossfaded in during playback
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "FFT_SIZE", "FFT Size", juce::StringArray{"512", "1024", "2048", "4096"}, 1));
+
+  // Zero-padded envelope analysis: finer envelope / formant grid at the same window and latency
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "ANALYSIS_PADDING", "Analysis Padding", juce::StringArray{"Off", "2x", "4x"}, 0));
+
+  // Prefault / page-lock the working memory and run a few quiet hops at prepare, against a first-callback spike
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "PREPARE_WARMUP", "Warm Start", true));
+
+  // STFT engine only: minimum-phase filtering of the dry input, no latency (pitch shift is bypassed)
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "ZERO_LATENCY", "Zero Latency Monitoring", false));
+
+  // Envelope / detection / warping on 48 mel bands instead of every bin (lower CPU)
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "BAND_MODE", "Band Envelope (Fast)", false));
+
+  // Warp the cepstral envelope on its coefficients (smooth result, matrix cached per warp map)
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "CEPSTRAL_WARP", "Cepstral-Domain Warp", false));
+
+  // Use the imported source's whole averaged envelope as the target (aligned to the input's formants)
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "FULL_ENVELOPE_TARGET", "Full Envelope Target", false));
+
   return {params.begin(), params.end()};
 }
 
@@ -97,45 +217,439 @@ std::array<float, dsp::SpectralProcessor::numFormants> SpectralFormantMorpherAud
   return formants;
 }
 
-bool SpectralFormantMorpherAudioProcessor::analyzeSourceFileAndApplyFormants(const juce::File &sourceFile, juce::String &message)
+bool SpectralFormantMorpherAudioProcessor::startSourceImport(const juce::File &sourceFile, SourceAnalysisFinished finished)
 {
-  if (!sourceFile.existsAsFile())
+  return startSourceAnalysis([this, sourceFile]
+                             { return analyzeSourceFile(sourceFile); },
+                             std::move(finished));
+}
+
+bool SpectralFormantMorpherAudioProcessor::startTakeAlignment(const juce::File &takeFile, SourceAnalysisFinished finished)
+{
+  // The guide is copied here: an import or track load may replace it while the take is analyzed.
+  return startSourceAnalysis([this, takeFile, guide = sourceTrajectory]
+                             { return alignSourceToTake(takeFile, guide); },
+                             std::move(finished));
+}
+
+bool SpectralFormantMorpherAudioProcessor::startSourceAnalysis(std::function<SourceAnalysis()> analyze, SourceAnalysisFinished finished)
+{
+  if (isSourceAnalysisRunning())
+    return false;
+
+  sourceAnalysisThread = std::make_unique<SourceAnalysisThread>(*this, std::move(analyze), std::move(finished));
+  sourceAnalysisThread->startThread();
+  return true;
+}
+
+SpectralFormantMorpherAudioProcessor::SourceAnalysis SpectralFormantMorpherAudioProcessor::analyzeSourceFile(const juce::File &sourceFile)
+{
+  SourceAnalysis analysis;
+
+  // Decoded and analyzed in parallel chunks, off the audio thread's buffers
+  ParallelSourceAnalyzer::Result source;
+  ParallelSourceAnalyzer sourceAnalyzer(formatManager);
+  if (!sourceAnalyzer.analyzeFile(sourceFile, maxTrajectorySeconds, source, analysis.message))
+    return analysis;
+
+  dsp::SpectralProcessor analyzer;
+  analyzer.setPrepareWarmup(false); // Offline only
+  analyzer.prepare({source.sampleRate, 512, 1});
+
+  // Static estimate keeps using the first seconds of the file, as before.
+  const int estimateSamples = juce::jmin(source.samples.getNumSamples(), (int)(source.sampleRate * 6.0));
+  juce::AudioBuffer<float> estimateBuffer(source.samples.getArrayOfWritePointers(), 1, estimateSamples);
+  analysis.formantsHz = analyzer.estimateFormantsFromBuffer(estimateBuffer, source.sampleRate);
+
+  // Whole averaged envelope for the full-envelope target mode
+  analysis.envelope = analyzer.averageEnvelopeFromFrames(source.trajectory, source.frameCepstra);
+  analysis.trajectory = std::move(source.trajectory);
+
+  analysis.ok = true;
+  analysis.message = "ソース音源からF1〜F15を推定して適用しました。";
+  return analysis;
+}
+
+SpectralFormantMorpherAudioProcessor::SourceAnalysis SpectralFormantMorpherAudioProcessor::alignSourceToTake(const juce::File &takeFile, const dsp::SpectralProcessor::FormantTrajectory &guide)
+{
+  SourceAnalysis analysis;
+  analysis.isAlignment = true;
+
+  if (guide.isEmpty())
   {
-    message = "ソース音源ファイルが見つかりません。";
+    analysis.message = "先にソース音源を読み込んでください。";
+    return analysis;
+  }
+
+  ParallelSourceAnalyzer::Result take;
+  ParallelSourceAnalyzer takeAnalyzer(formatManager);
+  if (!takeAnalyzer.analyzeFile(takeFile, maxTrajectorySeconds, take, analysis.message))
+    return analysis;
+
+  analysis.trajectory = dsp::SpectralProcessor::alignTrajectory(guide, take.trajectory);
+  if (analysis.trajectory.isEmpty())
+  {
+    analysis.message = "テイクとの整列に失敗しました。";
+    return analysis;
+  }
+
+  analysis.ok = true;
+  analysis.message = "ソースのフォルマント軌跡をテイクに整列しました（再生位置に追従）。";
+  return analysis;
+}
+
+void SpectralFormantMorpherAudioProcessor::applySourceAnalysis(const SourceAnalysis &analysis)
+{
+  if (!analysis.ok)
+    return;
+
+  if (analysis.isAlignment)
+  {
+    spectralContexts.setTargetTrajectory(analysis.trajectory);
+    return;
+  }
+
+  sourceTrajectory = analysis.trajectory;
+  clearAlignedTrajectory();
+  spectralContexts.setTargetEnvelope(analysis.envelope);
+  applyTargetFormants(analysis.formantsHz);
+}
+
+void SpectralFormantMorpherAudioProcessor::handleAsyncUpdate()
+{
+  if (const auto latency = reportedLatencySamples.load(); latency != getLatencySamples())
+    setLatencySamples(latency);
+
+  // A latency change can trigger this while an import is still running
+  if (sourceAnalysisThread == nullptr || !sourceAnalysisThread->done.load())
+    return;
+
+  // run() triggers this as its last step, so the wait is only for the thread to return.
+  sourceAnalysisThread->waitForThreadToExit(-1);
+  const auto analysis = std::move(sourceAnalysisThread->result);
+  const auto finished = std::move(sourceAnalysisThread->finished);
+  sourceAnalysisThread.reset();
+
+  applySourceAnalysis(analysis);
+  if (finished)
+    finished(analysis.ok, analysis.message);
+}
+
+SpectralFormantMorpherAudioProcessor::SourceAnalysisThread::SourceAnalysisThread(SpectralFormantMorpherAudioProcessor &processor, std::function<SourceAnalysis()> analyzeCallback,
+                                                                                 SourceAnalysisFinished finishedCallback)
+    : juce::Thread("SourceAnalysis"),
+      finished(std::move(finishedCallback)),
+      owner(processor),
+      analyze(std::move(analyzeCallback))
+{
+}
+
+SpectralFormantMorpherAudioProcessor::SourceAnalysisThread::~SourceAnalysisThread()
+{
+  stopThread(-1);
+}
+
+void SpectralFormantMorpherAudioProcessor::SourceAnalysisThread::run()
+{
+  result = analyze();
+  done.store(true);
+  owner.triggerAsyncUpdate();
+}
+
+void SpectralFormantMorpherAudioProcessor::clearAlignedTrajectory()
+{
+  spectralContexts.setTargetTrajectory({});
+}
+
+bool SpectralFormantMorpherAudioProcessor::startFormantRecording(const juce::File &trackFile, juce::String &message)
+{
+  const double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+  if (!formantRecorder.start(trackFile, sampleRate, spectralContexts.getHopSamples()))
+  {
+    message = "軌跡ファイルを作成できませんでした。";
     return false;
   }
 
-  std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(sourceFile));
-  if (reader == nullptr)
+  message = "フォルマント軌跡を録音中...";
+  return true;
+}
+
+void SpectralFormantMorpherAudioProcessor::stopFormantRecording(juce::String &message)
+{
+  formantRecorder.stop();
+
+  message = "録音を停止しました（" + juce::String(formantRecorder.getNumWrittenHops()) + " ホップ";
+  if (formantRecorder.getNumDroppedHops() > 0)
+    message += "、欠落 " + juce::String(formantRecorder.getNumDroppedHops());
+  message += "）";
+}
+
+bool SpectralFormantMorpherAudioProcessor::importFormantTrack(const juce::File &trackFile, juce::String &message)
+{
+  auto trajectory = dsp::FormantRecorder::readTrackFile(trackFile);
+  if (trajectory.isEmpty())
   {
-    message = "音源の読み込みに失敗しました。対応フォーマットを確認してください。";
+    message = "軌跡ファイルの読み込みに失敗しました。";
     return false;
   }
 
-  const juce::int64 maxReadSamples = juce::jmin<juce::int64>((juce::int64)(reader->sampleRate * 6.0), reader->lengthInSamples);
-  if (maxReadSamples <= 0)
+  // Also the guide for take alignment, like an imported source.
+  sourceTrajectory = trajectory;
+  spectralContexts.setTargetTrajectory(trajectory);
+  message = "録音した軌跡を読み込みました（再生位置に追従）。";
+  return true;
+}
+
+juce::String SpectralFormantMorpherAudioProcessor::getVowelSlotName(int slot)
+{
+  static const juce::StringArray vowelNames{"あ", "い", "う", "え", "お"};
+  const juce::String number(slot + 1);
+  return slot < vowelNames.size() ? number + ": " + vowelNames[slot] : number;
+}
+
+void SpectralFormantMorpherAudioProcessor::storeVowelSlot(int slot)
+{
+  if (slot < 0 || slot >= numVowelSlots)
+    return;
+
+  const auto formantsHz = collectTargetFormantsFromParameters();
+  juce::StringArray values;
+  for (size_t i = 0; i < formantsHz.size(); ++i)
   {
-    message = "音源に有効なサンプルがありません。";
+    vowelSlotsHz[(size_t)slot][i] = formantsHz[i];
+    values.add(juce::String(formantsHz[i], 1));
+  }
+
+  apvts.state.getOrCreateChildWithName(vowelSlotsType, nullptr).setProperty(vowelSlotProperty(slot), values.joinIntoString(" "), nullptr);
+}
+
+void SpectralFormantMorpherAudioProcessor::loadVowelSlotsFromState()
+{
+  const auto slots = apvts.state.getChildWithName(vowelSlotsType);
+
+  for (int slot = 0; slot < numVowelSlots; ++slot)
+  {
+    auto formantsHz = defaultFormantsHz;
+    if (slot < (int)defaultVowelsHz.size())
+      std::copy(defaultVowelsHz[(size_t)slot].begin(), defaultVowelsHz[(size_t)slot].end(), formantsHz.begin());
+
+    const auto values = juce::StringArray::fromTokens(slots.getProperty(vowelSlotProperty(slot)).toString(), " ", "");
+    if (values.size() == (int)formantsHz.size())
+      for (size_t i = 0; i < formantsHz.size(); ++i)
+        formantsHz[i] = values[(int)i].getFloatValue();
+
+    for (size_t i = 0; i < formantsHz.size(); ++i)
+      vowelSlotsHz[(size_t)slot][i] = formantsHz[i];
+  }
+}
+
+std::array<float, dsp::SpectralProcessor::numFormants> SpectralFormantMorpherAudioProcessor::getVowelSlotHz(int slot) const
+{
+  std::array<float, dsp::SpectralProcessor::numFormants> formantsHz{};
+  for (size_t i = 0; i < formantsHz.size(); ++i)
+    formantsHz[i] = vowelSlotsHz[(size_t)slot][i].load();
+  return formantsHz;
+}
+
+int SpectralFormantMorpherAudioProcessor::selectedVowelSlot() const
+{
+  int latestNote = -1;
+  for (int note = 0; note < (int)heldNoteOrder.size(); ++note)
+    if (heldNoteOrder[(size_t)note] != 0 && (latestNote < 0 || heldNoteOrder[(size_t)note] > heldNoteOrder[(size_t)latestNote]))
+      latestNote = note;
+
+  return latestNote >= 0 ? latestNote % 12 : controllerVowelSlot;
+}
+
+void SpectralFormantMorpherAudioProcessor::handleVowelMidi(const juce::MidiBuffer &midiMessages)
+{
+  for (const auto metadata : midiMessages)
+  {
+    const auto message = metadata.getMessage();
+
+    if (message.isNoteOn() && message.getNoteNumber() % 12 < numVowelSlots)
+      heldNoteOrder[(size_t)message.getNoteNumber()] = ++noteOnCounter;
+    else if (message.isNoteOff())
+      heldNoteOrder[(size_t)message.getNoteNumber()] = 0;
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+      heldNoteOrder.fill(0);
+    else if (message.isControllerOfType(vowelSlotController))
+      controllerVowelSlot = message.getControllerValue() == 0 ? -1 : (message.getControllerValue() - 1) * numVowelSlots / 127;
+    else
+      continue;
+
+    const int slot = selectedVowelSlot();
+    if (slot == activeVowelSlot)
+      continue;
+
+    activeVowelSlot = slot;
+    const auto targetHz = slot >= 0 ? getVowelSlotHz(slot) : collectTargetFormantsFromParameters();
+    spectralContexts.forEachAudioContext([&](dsp::SpectralProcessor &context)
+                                         { context.queueTargetChange(metadata.samplePosition, targetHz); });
+  }
+}
+
+dsp::SpectralContextSwitcher::Config SpectralFormantMorpherAudioProcessor::contextConfigFromParameters() const
+{
+  dsp::SpectralContextSwitcher::Config config;
+  config.fftOrder = dsp::SpectralContextSwitcher::minFftOrder + (int)std::lround(apvts.getRawParameterValue("FFT_SIZE")->load());
+  config.engine = engineFromParameter(apvts.getRawParameterValue("ENGINE")->load());
+  config.analysisPadding = 1 << (int)std::lround(apvts.getRawParameterValue("ANALYSIS_PADDING")->load());
+  return config;
+}
+
+void SpectralFormantMorpherAudioProcessor::applyTargetFormants(const std::array<float, dsp::SpectralProcessor::numFormants> &formantsHz)
+{
+  for (size_t i = 0; i < formantsHz.size(); ++i)
+  {
+    if (auto *param = apvts.getParameter(formantParamId(i)))
+      param->setValueNotifyingHost(param->convertTo0to1(formantsHz[i]));
+  }
+
+  spectralContexts.setTargetFormantsHz(formantsHz);
+}
+
+bool SpectralFormantMorpherAudioProcessor::buildProfileLibrary(const juce::File &folder, juce::String &message, FormantLibraryBuilder::ProgressCallback progress)
+{
+  if (!folder.isDirectory())
+  {
+    message = "フォルダが見つかりません。";
     return false;
   }
 
-  juce::AudioBuffer<float> sourceBuffer(1, (int)maxReadSamples);
-  if (!reader->read(&sourceBuffer, 0, (int)maxReadSamples, 0, true, true))
+  FormantLibraryBuilder builder;
+  dsp::FormantProfileIndex index;
+  const int added = builder.buildFromFolder(folder, index, std::move(progress));
+
+  if (added < 0)
   {
-    message = "音源サンプルの読取に失敗しました。";
+    message = "ライブラリ作成を中止しました。";
     return false;
   }
 
-  auto estimated = spectralProcessor.estimateFormantsFromBuffer(sourceBuffer, reader->sampleRate);
+  if (added == 0)
+  {
+    message = "フォルダ内に解析できる音源がありません。";
+    return false;
+  }
 
-  for (size_t i = 0; i < estimated.size(); ++i)
+  const auto indexFile = folder.getChildFile(dsp::FormantProfileIndex::defaultFileName);
+  if (!index.writeToFile(indexFile))
   {
-    if (auto *param = apvts.getParameter(formantParamId(i)))
-      param->setValueNotifyingHost(param->convertTo0to1(estimated[i]));
+    message = "索引ファイルを書き込めませんでした: " + indexFile.getFullPathName();
+    return false;
+  }
+
+  {
+    const juce::ScopedLock lock(libraryLock);
+    std::swap(profileLibrary, index);
+  }
+
+  message = juce::String(added) + " 件のリファレンスを索引化しました。";
+  return true;
+}
+
+bool SpectralFormantMorpherAudioProcessor::startProfileLibraryBuild(const juce::File &folder, FormantLibraryBuilder::ProgressCallback progress, LibraryBuildFinished finished)
+{
+  if (isProfileLibraryBuildRunning())
+    return false;
+
+  libraryBuildThread = std::make_unique<LibraryBuildThread>(*this, folder, std::move(progress), std::move(finished));
+  libraryBuildThread->startThread();
+  return true;
+}
+
+bool SpectralFormantMorpherAudioProcessor::isProfileLibraryBuildRunning() const
+{
+  return libraryBuildThread != nullptr && libraryBuildThread->isThreadRunning();
+}
+
+SpectralFormantMorpherAudioProcessor::LibraryBuildThread::LibraryBuildThread(SpectralFormantMorpherAudioProcessor &processor, const juce::File &folderToBuild,
+                                                                             FormantLibraryBuilder::ProgressCallback progressCallback, LibraryBuildFinished finishedCallback)
+    : juce::Thread("FormantLibraryBuild"),
+      owner(processor),
+      folder(folderToBuild),
+      progress(std::move(progressCallback)),
+      finished(std::move(finishedCallback))
+{
+}
+
+SpectralFormantMorpherAudioProcessor::LibraryBuildThread::~LibraryBuildThread()
+{
+  // The builder checks for cancellation after every file; wait for that instead of killing it.
+  stopThread(-1);
+}
+
+void SpectralFormantMorpherAudioProcessor::LibraryBuildThread::run()
+{
+  juce::String message;
+  const bool ok = owner.buildProfileLibrary(folder, message, [this](int done, int total)
+                                            { return !threadShouldExit() && (!progress || progress(done, total)); });
+
+  if (finished)
+    finished(ok, message);
+}
+
+bool SpectralFormantMorpherAudioProcessor::loadProfileLibrary(const juce::File &indexFile, juce::String &message)
+{
+  dsp::FormantProfileIndex index;
+  if (!index.readFromFile(indexFile))
+  {
+    message = "索引ファイルの読み込みに失敗しました。";
+    return false;
   }
 
-  spectralProcessor.setTargetFormantsHz(estimated);
-  message = "ソース音源からF1〜F15を推定して適用しました。";
+  const int count = index.size();
+  {
+    const juce::ScopedLock lock(libraryLock);
+    std::swap(profileLibrary, index);
+  }
+
+  message = juce::String(count) + " 件のリファレンスを読み込みました。";
+  return true;
+}
+
+int SpectralFormantMorpherAudioProcessor::getProfileLibrarySize() const
+{
+  const juce::ScopedLock lock(libraryLock);
+  return profileLibrary.size();
+}
+
+std::vector<SpectralFormantMorpherAudioProcessor::LibraryMatch> SpectralFormantMorpherAudioProcessor::findClosestProfiles(int maxResults)
+{
+  std::vector<LibraryMatch> results;
+  const auto query = spectralContexts.getLatestDetectedFormantsHz();
+
+  // Nothing detected yet (no audio processed)
+  if (query[0] <= 0.0f)
+    return results;
+
+  const juce::ScopedLock lock(libraryLock);
+  for (const auto &match : profileLibrary.findNearest(query, maxResults))
+    results.push_back({match.index, profileLibrary.getProfile(match.index).name, match.distance});
+
+  return results;
+}
+
+bool SpectralFormantMorpherAudioProcessor::applyLibraryProfile(int index, juce::String &message)
+{
+  std::array<float, dsp::SpectralProcessor::numFormants> formants{};
+  juce::String name;
+  {
+    const juce::ScopedLock lock(libraryLock);
+    if (!juce::isPositiveAndBelow(index, profileLibrary.size()))
+    {
+      message = "リファレンスが選択されていません。";
+      return false;
+    }
+
+    formants = profileLibrary.getProfile(index).meanHz;
+    name = profileLibrary.getProfile(index).name;
+  }
+
+  dsp::SpectralProcessor::enforceFormantOrdering(formants);
+  applyTargetFormants(formants);
+  message = "リファレンス「" + name + "」のF1〜F15を適用しました。";
   return true;
 }
 
@@ -209,8 +723,15 @@ void SpectralFormantMorpherAudioProcessor::prepareToPlay(double sampleRate, int
   spec.maximumBlockSize = (juce::uint32)samplesPerBlock;
   spec.numChannels = (juce::uint32)getTotalNumOutputChannels();
 
-  spectralProcessor.prepare(spec);
-  spectralProcessor.setTargetFormantsHz(collectTargetFormantsFromParameters());
+  spectralContexts.setPrepareWarmup(apvts.getRawParameterValue("PREPARE_WARMUP")->load() > 0.5f);
+  spectralContexts.prepare(spec, contextConfigFromParameters());
+  heldNoteOrder.fill(0);
+  controllerVowelSlot = -1;
+  activeVowelSlot = -1;
+  spectralContexts.setTargetFormantsHz(collectTargetFormantsFromParameters());
+  spectralContexts.getAudioContext().setZeroLatency(apvts.getRawParameterValue("ZERO_LATENCY")->load() > 0.5f);
+  reportedLatencySamples.store(spectralContexts.getLatencySamples());
+  setLatencySamples(reportedLatencySamples.load());
 
   dryBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
 }
@@ -241,7 +762,6 @@ bool SpectralFormantMorpherAudioProcessor::isBusesLayoutSupported(const BusesLay
 
 void SpectralFormantMorpherAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
 {
-  juce::ignoreUnused(midiMessages);
   juce::ScopedNoDenormals noDenormals;
 
   auto totalNumInputChannels = getTotalNumInputChannels();
@@ -250,7 +770,51 @@ void SpectralFormantMorpherAudioProcessor::processBlock(juce::AudioBuffer<float>
   for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
     buffer.clear(i, 0, buffer.getNumSamples());
 
-  spectralProcessor.setTargetFormantsHz(collectTargetFormantsFromParameters());
+  // FFT size / engine / padding changes are built (and warmed up) in the background; a finished one is adopted
+  // here and crossfaded in, with both contexts getting this block's settings until the fade is done.
+  spectralContexts.setPrepareWarmup(apvts.getRawParameterValue("PREPARE_WARMUP")->load() > 0.5f);
+  spectralContexts.requestConfig(contextConfigFromParameters());
+  spectralContexts.beginBlock();
+
+  // MIDI vowel slots switch the targets per hop; the parameters apply again once they're released.
+  handleVowelMidi(midiMessages);
+  const bool useParameterTargets = activeVowelSlot < 0 && !spectralContexts.getAudioContext().hasPendingTargetChanges();
+  const auto parameterTargets = collectTargetFormantsFromParameters();
+
+  spectralContexts.forEachAudioContext([&](dsp::SpectralProcessor &context)
+                                       {
+    if (useParameterTargets)
+      context.setTargetFormantsHz(parameterTargets);
+
+    context.setPitchShift(apvts.getRawParameterValue("PITCH_SHIFT")->load(),
+                          apvts.getRawParameterValue("PITCH_KEEP_FORMANTS")->load() > 0.5f);
+    context.setGlobalScale(apvts.getRawParameterValue("SCALE_MODE")->load() > 0.5f,
+                           apvts.getRawParameterValue("FORMANT_SCALE")->load(),
+                           apvts.getRawParameterValue("SCALE_BLEND")->load() / 100.0f);
+    context.setZeroLatency(apvts.getRawParameterValue("ZERO_LATENCY")->load() > 0.5f);
+    context.setBandMode(apvts.getRawParameterValue("BAND_MODE")->load() > 0.5f);
+    context.setCepstralWarp(apvts.getRawParameterValue("CEPSTRAL_WARP")->load() > 0.5f);
+    context.setFullEnvelopeTarget(apvts.getRawParameterValue("FULL_ENVELOPE_TARGET")->load() > 0.5f); });
+
+  // Engines / modes / FFT sizes differ in latency (LPC and zero-latency monitoring have none).
+  // The host is told on the message thread; the switcher keeps the old value until its fade is done.
+  if (const auto latency = spectralContexts.getLatencySamples(); reportedLatencySamples.exchange(latency) != latency)
+    triggerAsyncUpdate();
+
+  // Host timeline drives the aligned trajectory (if any)
+  bool isPlaying = false;
+  juce::int64 timeInSamples = 0;
+  if (auto *playHead = getPlayHead())
+  {
+    if (const auto position = playHead->getPosition())
+    {
+      isPlaying = position->getIsPlaying();
+      if (const auto samples = position->getTimeInSamples())
+        timeInSamples = *samples;
+    }
+  }
+  spectralContexts.forEachAudioContext([&](dsp::SpectralProcessor &context)
+                                       { context.setPlaybackPosition(timeInSamples, isPlaying); });
 
   // Save dry signal for mix
   const float mix = apvts.getRawParameterValue("MIX")->load() / 100.0f;
@@ -262,7 +826,7 @@ void SpectralFormantMorpherAudioProcessor::processBlock(juce::AudioBuffer<float>
   // Process wet signal
   juce::dsp::AudioBlock<float> block(buffer);
   juce::dsp::ProcessContextReplacing<float> context(block);
-  spectralProcessor.process(context);
+  spectralContexts.process(context);
 
   // Apply dry/wet mix and output gain
   const int numSamples = buffer.getNumSamples();
@@ -309,7 +873,17 @@ void SpectralFormantMorpherAudioProcessor::setStateInformation(const void *data,
   std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
   if (xmlState.get() != nullptr)
     if (xmlState->hasTagName(apvts.state.getType()))
-      apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+    {
+      auto state = juce::ValueTree::fromXml(*xmlState);
+
+      // Sessions from before Multi-Res (ENGINE 3) was withdrawn fall back to STFT
+      auto engineParameter = state.getChildWithProperty("id", "ENGINE");
+      if (engineParameter.isValid() && (int)engineParameter.getProperty("value") > 2)
+        engineParameter.setProperty("value", 0.0f, nullptr);
+
+      apvts.replaceState(state);
+      loadVowelSlotsFromState();
+    }
 }
 
 void SpectralFormantMorpherAudioProcessor::parameterChanged(const juce::String &parameterID, float newValue)
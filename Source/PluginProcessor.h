@@ -4,8 +4,14 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <array>
 #include "DSP/SpectralProcessor.h"
-
-class SpectralFormantMorpherAudioProcessor : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener
+#include "DSP/SpectralContextSwitcher.h"
+#include "DSP/FormantProfileIndex.h"
+#include "DSP/FormantRecorder.h"
+#include "FormantLibraryBuilder.h"
+#include "ParallelSourceAnalyzer.h"
+
+class SpectralFormantMorpherAudioProcessor : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener,
+                                             private juce::AsyncUpdater
 {
 public:
     SpectralFormantMorpherAudioProcessor();
@@ -41,19 +47,161 @@ public:
 
     void parameterChanged(const juce::String &parameterID, float newValue) override;
 
-    bool analyzeSourceFileAndApplyFormants(const juce::File &sourceFile, juce::String &message);
+    using SourceAnalysisFinished = std::function<void(bool ok, const juce::String &message)>;
+
+    /**
+     * Message thread: analyzes a source file on a thread owned by the processor, then applies
+     * its F1-F15, envelope and formant trajectory and calls finished on the message thread.
+     * @return false if a source import or take alignment is already running.
+     */
+    bool startSourceImport(const juce::File &sourceFile, SourceAnalysisFinished finished);
+
+    /**
+     * Aligns the imported source's formant trajectory to a take (DTW) and uses the
+     * aligned per-hop targets while the host plays the take. Runs like startSourceImport().
+     */
+    bool startTakeAlignment(const juce::File &takeFile, SourceAnalysisFinished finished);
+    bool isSourceAnalysisRunning() const { return sourceAnalysisThread != nullptr; }
+    void clearAlignedTrajectory();
+
+    /** Learn mode: records the formants detected on the live input to a track file (.sfmt). */
+    bool startFormantRecording(const juce::File &trackFile, juce::String &message);
+    void stopFormantRecording(juce::String &message);
+    bool isFormantRecording() const { return formantRecorder.isRecording(); }
+
+    /** Loads a recorded track as the time-varying target (it can also be aligned to a take). */
+    bool importFormantTrack(const juce::File &trackFile, juce::String &message);
+
+    /**
+     * MIDI vowel slots: stored target sets selected by note (pitch class, C = slot 1) or by
+     * CC vowelSlotController (0 = parameters, 1-127 spread over the slots). The latest held
+     * note wins over the CC; with neither, the FORMANT_n parameters are the targets. Switches
+     * land on the hop containing the event and are crossfaded (SpectralProcessor::queueTargetChange).
+     */
+    static constexpr int numVowelSlots = 8;
+    static constexpr int vowelSlotController = 14;
+    static juce::String getVowelSlotName(int slot);
+
+    /** Stores the current FORMANT_n targets in a slot (message thread); saved with the plugin state. */
+    void storeVowelSlot(int slot);
+
+    // Reference voice library (formant profiles)
+    struct LibraryMatch
+    {
+        int index = -1;
+        juce::String name;
+        float distance = 0.0f;
+    };
+
+    /** Analyzes a folder into an index file inside it and loads it. Safe to call from a background thread. */
+    bool buildProfileLibrary(const juce::File &folder, juce::String &message, FormantLibraryBuilder::ProgressCallback progress = {});
+
+    using LibraryBuildFinished = std::function<void(bool ok, const juce::String &message)>;
+
+    /**
+     * Message thread: runs buildProfileLibrary() on a thread owned by the processor, which the
+     * destructor cancels and joins. progress and finished are called on that thread.
+     * @return false if a build is already running.
+     */
+    bool startProfileLibraryBuild(const juce::File &folder, FormantLibraryBuilder::ProgressCallback progress, LibraryBuildFinished finished);
+    bool isProfileLibraryBuildRunning() const;
+    bool loadProfileLibrary(const juce::File &indexFile, juce::String &message);
+    int getProfileLibrarySize() const;
+
+    /** Nearest references to the formants currently detected on the input. */
+    std::vector<LibraryMatch> findClosestProfiles(int maxResults);
+    bool applyLibraryProfile(int index, juce::String &message);
 
     juce::AudioProcessorValueTreeState &getAPVTS() { return apvts; }
-    dsp::SpectralProcessor &getSpectralProcessor() { return spectralProcessor; }
+    /** Processing contexts; FFT_SIZE / ENGINE changes are hot-swapped (SpectralContextSwitcher). */
+    dsp::SpectralContextSwitcher &getSpectralContexts() { return spectralContexts; }
 
 private:
     juce::AudioProcessorValueTreeState apvts;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     std::array<float, dsp::SpectralProcessor::numFormants> collectTargetFormantsFromParameters() const;
 
-    dsp::SpectralProcessor spectralProcessor;
+    dsp::SpectralContextSwitcher spectralContexts;
+    dsp::FormantRecorder formantRecorder;
     juce::AudioFormatManager formatManager;
 
+    // Formant track of the last imported source (guide for take alignment)
+    dsp::SpectralProcessor::FormantTrajectory sourceTrajectory;
+
+    juce::CriticalSection libraryLock;
+    dsp::FormantProfileIndex profileLibrary;
+
+    class LibraryBuildThread : public juce::Thread
+    {
+    public:
+        LibraryBuildThread(SpectralFormantMorpherAudioProcessor &owner, const juce::File &folder,
+                           FormantLibraryBuilder::ProgressCallback progress, LibraryBuildFinished finished);
+        ~LibraryBuildThread() override;
+        void run() override;
+
+    private:
+        SpectralFormantMorpherAudioProcessor &owner;
+        juce::File folder;
+        FormantLibraryBuilder::ProgressCallback progress;
+        LibraryBuildFinished finished;
+    };
+    std::unique_ptr<LibraryBuildThread> libraryBuildThread;
+
+    // Result of a source import or take alignment, applied on the message thread.
+    struct SourceAnalysis
+    {
+        bool ok = false;
+        juce::String message;
+        bool isAlignment = false;
+        std::array<float, dsp::SpectralProcessor::numFormants> formantsHz{};
+        dsp::SpectralProcessor::FormantTrajectory trajectory; // Source track, or the aligned one
+        dsp::SpectralProcessor::TargetEnvelope envelope;
+    };
+
+    // Background thread: these only read their arguments and formatManager.
+    SourceAnalysis analyzeSourceFile(const juce::File &sourceFile);
+    SourceAnalysis alignSourceToTake(const juce::File &takeFile, const dsp::SpectralProcessor::FormantTrajectory &guide);
+    void applySourceAnalysis(const SourceAnalysis &analysis);
+
+    class SourceAnalysisThread : public juce::Thread
+    {
+    public:
+        SourceAnalysisThread(SpectralFormantMorpherAudioProcessor &owner, std::function<SourceAnalysis()> analyze,
+                             SourceAnalysisFinished finished);
+        ~SourceAnalysisThread() override;
+        void run() override;
+
+        SourceAnalysis result;
+        SourceAnalysisFinished finished;
+        std::atomic<bool> done{false}; // result is complete, set just before the async update
+
+    private:
+        SpectralFormantMorpherAudioProcessor &owner;
+        std::function<SourceAnalysis()> analyze;
+    };
+    // Kept until its result is applied, so only one import or alignment is pending at a time.
+    std::unique_ptr<SourceAnalysisThread> sourceAnalysisThread;
+    bool startSourceAnalysis(std::function<SourceAnalysis()> analyze, SourceAnalysisFinished finished);
+    void handleAsyncUpdate() override;
+
+    // Written on the audio thread, handed to setLatencySamples() in handleAsyncUpdate()
+    std::atomic<int> reportedLatencySamples{0};
+
+    void applyTargetFormants(const std::array<float, dsp::SpectralProcessor::numFormants> &formantsHz);
+    dsp::SpectralContextSwitcher::Config contextConfigFromParameters() const;
+
+    // MIDI vowel slots (values written on the message thread, read per event on the audio thread)
+    std::array<std::array<std::atomic<float>, dsp::SpectralProcessor::numFormants>, numVowelSlots> vowelSlotsHz;
+    std::array<juce::uint32, 128> heldNoteOrder{}; // 0 = not held, otherwise note-on order
+    juce::uint32 noteOnCounter = 0;
+    int controllerVowelSlot = -1;
+    int activeVowelSlot = -1; // -1 = parameter targets
+
+    void loadVowelSlotsFromState();
+    std::array<float, dsp::SpectralProcessor::numFormants> getVowelSlotHz(int slot) const;
+    int selectedVowelSlot() const;
+    void handleVowelMidi(const juce::MidiBuffer &midiMessages);
+
     // Dry buffer for dry/wet mixing
     juce::AudioBuffer<float> dryBuffer;
 
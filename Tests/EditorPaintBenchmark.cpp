@@ -0,0 +1,158 @@
+#include "../Source/PluginProcessor.h"
+#include "../Source/PluginEditor.h"
+#include <iostream>
+
+// Headless paint benchmark for the editor's custom components.
+//
+//   EditorPaintBenchmark [--frames N] [--max-ms X]
+//
+// Builds the editor offscreen, feeds SpectrumVisualizer synthetic frames and times paint()
+// of SpectrumVisualizer and XYFormantPad into a juce::Image at several sizes and scale
+// factors. Prints JSON; with --max-ms it fails if any case is slower than X ms per frame.
+
+namespace
+{
+    template <typename ComponentType>
+    ComponentType *findChild(juce::Component &parent)
+    {
+        for (auto *child : parent.getChildren())
+            if (auto *match = dynamic_cast<ComponentType *>(child))
+                return match;
+
+        return nullptr;
+    }
+
+    /** Harmonic comb under two moving resonances, like a vowel frame from the analysis. */
+    void makeFrame(int frameIndex, std::vector<float> &spectrum, std::vector<float> &envelope, float &f1, float &f2)
+    {
+        constexpr int numBins = 513;
+        spectrum.resize(numBins);
+        envelope.resize(numBins);
+
+        const float phase = 0.05f * (float)frameIndex;
+        f1 = 16.0f + 4.0f * std::sin(phase);
+        f2 = 30.0f + 8.0f * std::cos(0.7f * phase);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            const float bin = (float)k;
+            const float shape = 0.02f / (1.0f + 0.02f * bin)
+                                + 0.05f / (1.0f + 0.1f * (bin - f1) * (bin - f1))
+                                + 0.03f / (1.0f + 0.05f * (bin - f2) * (bin - f2));
+            const float comb = 0.1f + 0.9f * std::pow(std::abs(std::cos(juce::MathConstants<float>::pi * bin / 3.2f)), 8.0f);
+
+            envelope[(size_t)k] = shape;
+            spectrum[(size_t)k] = shape * comb;
+        }
+    }
+
+    /** Average ms per paint of `component` at its current size, rendered at `scale`. */
+    template <typename BeforeFrame>
+    double timePaint(juce::Component &component, float scale, int numFrames, BeforeFrame &&beforeFrame)
+    {
+        juce::Image image(juce::Image::ARGB,
+                          juce::roundToInt((float)component.getWidth() * scale),
+                          juce::roundToInt((float)component.getHeight() * scale), true);
+
+        double totalSeconds = 0.0;
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            beforeFrame(frame);
+
+            juce::Graphics g(image);
+            g.addTransform(juce::AffineTransform::scale(scale));
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            component.paintEntireComponent(g, false);
+            totalSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        }
+
+        return totalSeconds * 1000.0 / (double)numFrames;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int numFrames = 200;
+    double maxMs = 0.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        if (arg == "--frames" && i + 1 < argc)
+            numFrames = std::max(1, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--max-ms" && i + 1 < argc)
+            maxMs = juce::String(argv[++i]).getDoubleValue();
+        else
+        {
+            std::cerr << "Usage: EditorPaintBenchmark [--frames N] [--max-ms X]\n";
+            return 1;
+        }
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    SpectralFormantMorpherAudioProcessor processor;
+    std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditorIfNeeded());
+
+    auto *visualizer = editor != nullptr ? findChild<SpectrumVisualizer>(*editor) : nullptr;
+    auto *pad = editor != nullptr ? findChild<XYFormantPad>(*editor) : nullptr;
+    if (visualizer == nullptr || pad == nullptr)
+    {
+        std::cerr << "Editor components not found\n";
+        return 1;
+    }
+
+    // The message loop never runs here, so the visualizer's timer cannot overwrite the frames.
+    std::vector<float> spectrum, envelope;
+    float f1 = 0.0f, f2 = 0.0f;
+    auto feedVisualizer = [&](int frame)
+    {
+        makeFrame(frame, spectrum, envelope, f1, f2);
+        visualizer->setFrame(spectrum, envelope, f1, f2);
+    };
+
+    const std::array<juce::Point<int>, 3> visualizerSizes{{{740, 320}, {1200, 480}, {1920, 800}}};
+    const std::array<juce::Point<int>, 2> padSizes{{{300, 200}, {600, 400}}};
+    const std::array<float, 3> scales{1.0f, 1.5f, 2.0f};
+
+    juce::Array<juce::var> results;
+    bool withinLimit = true;
+
+    auto addResult = [&](const char *name, juce::Point<int> size, float scale, double ms)
+    {
+        auto *entry = new juce::DynamicObject();
+        entry->setProperty("component", name);
+        entry->setProperty("width", size.x);
+        entry->setProperty("height", size.y);
+        entry->setProperty("scale", scale);
+        entry->setProperty("msPerFrame", ms);
+        results.add(juce::var(entry));
+
+        if (maxMs > 0.0 && ms > maxMs)
+            withinLimit = false;
+    };
+
+    for (const auto size : visualizerSizes)
+    {
+        visualizer->setSize(size.x, size.y);
+        for (const float scale : scales)
+            addResult("SpectrumVisualizer", size, scale, timePaint(*visualizer, scale, numFrames, feedVisualizer));
+    }
+
+    for (const auto size : padSizes)
+    {
+        pad->setSize(size.x, size.y);
+        for (const float scale : scales)
+            addResult("XYFormantPad", size, scale, timePaint(*pad, scale, numFrames, [](int) {}));
+    }
+
+    editor.reset();
+
+    auto *report = new juce::DynamicObject();
+    report->setProperty("frames", numFrames);
+    report->setProperty("results", results);
+    std::cout << juce::JSON::toString(juce::var(report)) << "\n";
+
+    return withinLimit ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+#include "../Source/DSP/SpectralProcessor.h"
+#include "SyntheticVoice.h"
+#include <iostream>
+
+// Formant detection accuracy on the synthetic vowel corpus.
+//
+// Every reference vowel is rendered with jitter, vibrato and breath noise and measured with
+// estimateFormantsFromBuffer(); a gliding vowel sequence is measured frame by frame with
+// analyzeFormantTrajectory(). Errors are reported in Hz (and relative to the true formant) for
+// F1-F3, the formants the targets are mostly set by. Fails when a held vowel or the glides
+// exceed the relative error limits (index-wise or nearest-peak), when the input-pruned
+// zero-padded spectrum differs from a plain FFT of the padded frame, when the trajectory
+// analyzed chunk by chunk differs from the serial pass, or when the full-envelope target output
+// is not finite or off in level at other frame sizes or on the multi-resolution engine. The
+// live detection in process() is measured on the glides too, against regression limits of its own.
+
+namespace
+{
+    constexpr int numChecked = 3;
+
+    // Limits on the mean error of F1-F3 relative to the true formant, for each held vowel and for
+    // the glide sequence, both index-wise and nearest-peak. Measured: under 11 % (held vowels,
+    // /u/ F1) and under 4 % (glides); the limits leave room for noise, not for a missed formant.
+    constexpr std::array<double, numChecked> maxRelativeError{0.15, 0.10, 0.10};
+
+    // Live detection still runs on the 30-coefficient cepstral envelope, which merges a low F1
+    // into F2 or the spectral tilt. Measured nearest-peak error on the glides: 350 / 60 / 17 %
+    // (index-wise 350 / 158 / 81 %). These limits only guard that path against getting worse;
+    // they say nothing about it being accurate.
+    constexpr std::array<double, numChecked> maxLiveNearestRelativeError{4.0, 0.75, 0.25};
+
+    // Output level of the full-envelope target relative to the unmodified path. The stored curve
+    // is brought to the input's mean log level, so the power moves with the shape only: measured
+    // -6 to +1 dB. A curve on the wrong bins (or the wrong range for a band) is off by 20 dB.
+    constexpr double maxEnvelopeTargetLevelDb = 10.0;
+
+    /**
+     * Index-wise error: |detected Fi - true Fi|, what the warp actually uses (a missed or merged
+     * formant shifts every later index). Nearest error: distance from true Fi to the closest
+     * detected formant, i.e. how well the peaks that are found sit on the resonances.
+     */
+    struct ErrorStats
+    {
+        std::array<double, numChecked> indexSum{};
+        std::array<double, numChecked> nearestSum{};
+        std::array<double, numChecked> indexRelativeSum{};
+        std::array<double, numChecked> nearestRelativeSum{};
+        int count = 0;
+
+        void add(const std::array<float, dsp::SpectralProcessor::numFormants> &detectedHz, const synthetic::Formants &trueHz)
+        {
+            for (size_t i = 0; i < (size_t)numChecked; ++i)
+            {
+                const double indexError = std::abs((double)detectedHz[i] - (double)trueHz[i]);
+
+                double nearest = std::numeric_limits<double>::max();
+                for (float hz : detectedHz)
+                    nearest = std::min(nearest, std::abs((double)hz - (double)trueHz[i]));
+
+                indexSum[i] += indexError;
+                nearestSum[i] += nearest;
+                indexRelativeSum[i] += indexError / (double)trueHz[i];
+                nearestRelativeSum[i] += nearest / (double)trueHz[i];
+            }
+            ++count;
+        }
+
+        double indexError(size_t i) const { return count > 0 ? indexSum[i] / (double)count : 0.0; }
+        double nearestError(size_t i) const { return count > 0 ? nearestSum[i] / (double)count : 0.0; }
+        double indexRelativeError(size_t i) const { return count > 0 ? indexRelativeSum[i] / (double)count : 0.0; }
+        double nearestRelativeError(size_t i) const { return count > 0 ? nearestRelativeSum[i] / (double)count : 0.0; }
+
+        void print(const juce::String &label) const
+        {
+            std::cout << label << "  index";
+            for (size_t i = 0; i < (size_t)numChecked; ++i)
+                std::cout << " F" << (i + 1) << " " << juce::roundToInt(indexError(i)) << " (" << juce::String(indexRelativeError(i) * 100.0, 1) << "%)";
+            std::cout << " Hz, nearest";
+            for (size_t i = 0; i < (size_t)numChecked; ++i)
+                std::cout << " F" << (i + 1) << " " << juce::roundToInt(nearestError(i)) << " (" << juce::String(nearestRelativeError(i) * 100.0, 1) << "%)";
+            std::cout << " Hz\n";
+        }
+
+        bool withinLimits() const
+        {
+            for (size_t i = 0; i < (size_t)numChecked; ++i)
+                if (indexRelativeError(i) > maxRelativeError[i] || nearestRelativeError(i) > maxRelativeError[i])
+                    return false;
+            return true;
+        }
+
+        bool withinLiveLimits() const
+        {
+            for (size_t i = 0; i < (size_t)numChecked; ++i)
+                if (nearestRelativeError(i) > maxLiveNearestRelativeError[i])
+                    return false;
+            return true;
+        }
+    };
+}
+
+int main()
+{
+    const synthetic::VoiceSettings settings;
+    const auto vowels = synthetic::referenceVowels();
+
+    dsp::SpectralProcessor analyzer;
+    analyzer.prepare({settings.sampleRate, 512, 1});
+
+    // Test 1: held vowels, single-frame estimate; every vowel has to be within the limits
+    ErrorStats heldStats;
+    bool heldPassed = true;
+    for (const auto &vowel : vowels)
+    {
+        const auto utterance = synthetic::renderVowel(vowel, 0.5f, settings);
+        const auto estimated = analyzer.estimateFormantsFromBuffer(utterance.toBuffer(), utterance.sampleRate);
+
+        ErrorStats vowelStats;
+        vowelStats.add(estimated, vowel.formantsHz);
+        heldStats.add(estimated, vowel.formantsHz);
+        vowelStats.print(juce::String("  /") + vowel.name + "/");
+        heldPassed = heldPassed && vowelStats.withinLimits();
+    }
+
+    heldStats.print("Test 1 (Held Vowels) mean error:");
+    if (!heldPassed)
+    {
+        std::cout << "Test 1 Fail\n";
+        return 1;
+    }
+    std::cout << "Test 1 (Held Vowels) Passed\n";
+
+    // Test 2: gliding vowel sequence, per-frame trajectory
+    std::vector<synthetic::Segment> segments;
+    for (const auto &vowel : vowels)
+        segments.push_back({vowel, 0.15f, 0.1f});
+
+    const auto utterance = synthetic::render(segments, settings);
+    const auto buffer = utterance.toBuffer();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto trajectory = analyzer.analyzeFormantTrajectory(buffer, utterance.sampleRate);
+    const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    ErrorStats trajectoryStats;
+    for (size_t f = 0; f < trajectory.framesHz.size(); ++f)
+    {
+        const int centre = (int)f * trajectory.hopSamples + analyzer.getFftSize() / 2;
+        trajectoryStats.add(trajectory.framesHz[f], utterance.formantsAt(centre));
+    }
+
+    trajectoryStats.print("Test 2 (Vowel Glides) mean error:");
+    std::cout << "  " << juce::roundToInt(seconds * 1.0e9 / (double)std::max<size_t>(1, trajectory.framesHz.size()))
+              << " ns/frame over " << (int)trajectory.framesHz.size() << " frames\n";
+
+    if (!trajectoryStats.withinLimits())
+    {
+        std::cout << "Test 2 Fail\n";
+        return 1;
+    }
+    std::cout << "Test 2 (Vowel Glides) Passed\n";
+
+    // Test 3: zero-padded spectrum (pruned) against a plain FFT of the padded frame
+    {
+        const int fftOrder = dsp::SpectralProcessor::defaultFftOrder;
+        const int fftSize = 1 << fftOrder;
+        juce::dsp::FFT fft(fftOrder);
+        juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann);
+
+        for (int padding : {2, 4})
+        {
+            dsp::ZeroPaddedSpectrum pruned;
+            pruned.prepare(fftOrder, padding);
+            juce::dsp::FFT paddedFft(fftOrder + (padding == 2 ? 1 : 2));
+
+            std::vector<float> frame((size_t)fftSize * 2), unpadded((size_t)fftSize / 2 + 1);
+            std::vector<float> padded((size_t)pruned.getNumBins()), plain((size_t)fftSize * padding * 2);
+            double maxRelativeError = 0.0;
+
+            for (int start = 0; start + fftSize <= buffer.getNumSamples(); start += fftSize)
+            {
+                std::fill(frame.begin(), frame.end(), 0.0f);
+                std::copy(buffer.getReadPointer(0) + start, buffer.getReadPointer(0) + start + fftSize, frame.begin());
+                window.multiplyWithWindowingTable(frame.data(), (size_t)fftSize);
+
+                std::fill(plain.begin(), plain.end(), 0.0f);
+                std::copy(frame.begin(), frame.begin() + fftSize, plain.begin());
+                paddedFft.performRealOnlyForwardTransform(plain.data());
+
+                const auto windowed = frame;
+                fft.performRealOnlyForwardTransform(frame.data());
+                for (size_t k = 0; k < unpadded.size(); ++k)
+                    unpadded[k] = std::hypot(frame[k * 2], frame[k * 2 + 1]);
+
+                pruned.process(windowed.data(), unpadded, padded);
+
+                float peak = 0.0f;
+                for (size_t k = 0; k < padded.size(); ++k)
+                    peak = std::max(peak, std::hypot(plain[k * 2], plain[k * 2 + 1]));
+                for (size_t k = 0; k < padded.size(); ++k)
+                    maxRelativeError = std::max(maxRelativeError, (double)std::abs(padded[k] - std::hypot(plain[k * 2], plain[k * 2 + 1])) / (double)std::max(peak, 1.0e-9f));
+            }
+
+            std::cout << "  " << padding << "x max error " << maxRelativeError << " of the peak\n";
+            if (maxRelativeError > 1.0e-4)
+            {
+                std::cout << "Test 3 Fail\n";
+                return 1;
+            }
+        }
+    }
+    std::cout << "Test 3 (Zero-Padded Spectrum) Passed\n";
+
+    // Test 4: the trajectory analyzed in chunks (as ParallelSourceAnalyzer does) against the serial pass
+    {
+        const int totalSamples = buffer.getNumSamples();
+        const int hopSize = analyzer.getTrajectoryHopSize();
+        const int numFrames = analyzer.getNumTrajectoryFrames(totalSamples);
+        const int framesPerChunk = 7;
+
+        dsp::SpectralProcessor::FormantTrajectory chunked;
+        chunked.framesHz.resize((size_t)numFrames);
+        chunked.energyDb.resize((size_t)numFrames);
+
+        for (int firstFrame = 0; firstFrame < numFrames; firstFrame += framesPerChunk)
+        {
+            // Each chunk only sees its own samples, copied out like a separately decoded range
+            const int chunkFrames = std::min(framesPerChunk, numFrames - firstFrame);
+            const int firstSample = firstFrame * hopSize;
+            const int endSample = std::min(totalSamples, (firstFrame + chunkFrames - 1) * hopSize + analyzer.getFftSize());
+            const std::vector<float> chunk(buffer.getReadPointer(0) + firstSample, buffer.getReadPointer(0) + endSample);
+
+            dsp::SpectralProcessor chunkAnalyzer;
+            chunkAnalyzer.prepare({settings.sampleRate, 512, 1});
+            chunkAnalyzer.analyzeTrajectoryFrames(chunk.data(), totalSamples, utterance.sampleRate, firstFrame, chunkFrames, chunked, nullptr);
+        }
+
+        int differing = 0;
+        for (size_t f = 0; f < (size_t)numFrames; ++f)
+            if (chunked.framesHz[f] != trajectory.framesHz[f] || chunked.energyDb[f] != trajectory.energyDb[f])
+                ++differing;
+
+        if (numFrames != (int)trajectory.framesHz.size() || differing > 0)
+        {
+            std::cout << "Test 4 Fail (" << differing << " differing frames)\n";
+            return 1;
+        }
+    }
+    std::cout << "Test 4 (Chunked Trajectory) Passed\n";
+
+    // Test 5: live detection (detectFormants() on the cepstral envelope in process()) on the glides
+    {
+        dsp::SpectralProcessor live;
+        live.prepare({settings.sampleRate, 512, 1});
+        const int hop = live.getHopSamples();
+
+        juce::AudioBuffer<float> block(1, hop);
+        ErrorStats liveStats;
+        for (int start = 0; start + hop <= buffer.getNumSamples(); start += hop)
+        {
+            block.copyFrom(0, 0, buffer, 0, start, hop);
+            juce::dsp::AudioBlock<float> audioBlock(block);
+            live.process(juce::dsp::ProcessContextReplacing<float>(audioBlock));
+
+            // Every hop analyzes the last fftSize input samples.
+            const int end = start + hop;
+            if (end >= live.getFftSize())
+                liveStats.add(live.getLatestDetectedFormantsHz(), utterance.formantsAt(end - live.getFftSize() / 2));
+        }
+
+        liveStats.print("Test 5 (Live Detection) mean error:");
+        if (!liveStats.withinLiveLimits())
+        {
+            std::cout << "Test 5 Fail\n";
+            return 1;
+        }
+        std::cout << "Test 5 (Live Detection) Passed\n";
+    }
+
+    // Test 6: full-envelope target (stored at the 1024-point analysis size) on other frame sizes
+    // and the multi-resolution engine: the output stays finite and near the level of the
+    // unmodified path (identity scale) of the same configuration
+    {
+        const auto source = synthetic::renderVowel(vowels.front(), 0.5f, settings);
+        const auto storedEnvelope = analyzer.analyzeAverageEnvelope(source.toBuffer(), source.sampleRate);
+
+        struct EnvelopeCase
+        {
+            int fftOrder;
+            dsp::SpectralProcessor::Engine engine;
+            const char *name;
+        };
+        const EnvelopeCase cases[] = {{9, dsp::SpectralProcessor::Engine::stft, "512"},
+                                      {11, dsp::SpectralProcessor::Engine::stft, "2048"},
+                                      {dsp::SpectralProcessor::defaultFftOrder, dsp::SpectralProcessor::Engine::multiResolution, "multi-res"}};
+
+        // Mean square of the output after the latency, or a negative value if it is not finite
+        auto processGlides = [&](const EnvelopeCase &envelopeCase, bool fullEnvelope)
+        {
+            dsp::SpectralProcessor processor(envelopeCase.fftOrder);
+            processor.setEngine(envelopeCase.engine);
+            processor.setPrepareWarmup(false);
+            processor.prepare({settings.sampleRate, 512, 1});
+            if (fullEnvelope)
+            {
+                processor.setTargetEnvelope(storedEnvelope);
+                processor.setFullEnvelopeTarget(true);
+            }
+            else
+            {
+                processor.setGlobalScale(true, 1.0f, 0.0f);
+            }
+
+            juce::AudioBuffer<float> output(buffer);
+            const int latency = processor.getLatencySamples();
+            double squares = 0.0;
+            for (int start = 0; start < output.getNumSamples(); start += 512)
+            {
+                const int blockSize = std::min(512, output.getNumSamples() - start);
+                float *channels[] = {output.getWritePointer(0) + start};
+                juce::dsp::AudioBlock<float> block(channels, 1, (size_t)blockSize);
+                processor.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+                for (int i = std::max(start, latency); i < start + blockSize; ++i)
+                    squares += (double)output.getSample(0, i) * output.getSample(0, i);
+            }
+
+            return std::isfinite(squares) ? squares : -1.0;
+        };
+
+        for (const auto &envelopeCase : cases)
+        {
+            const double targetSquares = processGlides(envelopeCase, true);
+            const double unmodifiedSquares = processGlides(envelopeCase, false);
+            const double levelDb = 10.0 * std::log10(std::max(targetSquares, 1.0e-20) / std::max(unmodifiedSquares, 1.0e-20));
+
+            std::cout << "  " << envelopeCase.name << ": " << juce::String(levelDb, 1) << " dB re unmodified\n";
+            if (targetSquares < 0.0 || std::abs(levelDb) > maxEnvelopeTargetLevelDb)
+            {
+                std::cout << "Test 6 Fail (" << envelopeCase.name << ")\n";
+                return 1;
+            }
+        }
+    }
+    std::cout << "Test 6 (Full-Envelope Target Sizes) Passed\n";
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "../Source/PluginProcessor.h"
+#include "SyntheticVoice.h"
+#include "ResidentMemory.h"
+#include <atomic>
+#include <barrier>
+#include <iostream>
+#include <thread>
+
+// Many-instance stress test: N plugin instances in one process, run like a DAW graph.
+//
+//   InstanceStressTest [--instances N] [--seconds S] [--threads T] [--block N] [--min-rtf X]
+//
+// Creates N (default 128, up to 512) processors one after the other and measures the time to
+// construct + prepareToPlay each and the resident memory they add. Then S seconds (default 10)
+// of audio at 44.1 kHz are processed block by block: for every host callback the instances are
+// claimed from a shared counter by T threads (default: all cores, the calling thread included),
+// like the parallel tracks of a DAW graph, and the callback ends when all of them are done.
+// Reports the aggregate realtime factor (audio time / wall time for all instances), the
+// callbacks that missed their deadline and the per-instance memory as JSON. With --min-rtf it
+// fails when the realtime factor is below X.
+
+namespace
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr int maxInstances = 512;
+
+    void setParameter(juce::AudioProcessorValueTreeState &apvts, const juce::String &id, float value)
+    {
+        if (auto *parameter = apvts.getParameter(id))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    struct Instance
+    {
+        std::unique_ptr<SpectralFormantMorpherAudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        int programOffset = 0;
+    };
+
+    double percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty())
+            return 0.0;
+
+        const auto nth = values.begin() + (std::ptrdiff_t)((double)(values.size() - 1) * fraction);
+        std::nth_element(values.begin(), nth, values.end());
+        return *nth;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int numInstances = 128;
+    double seconds = 10.0;
+    int numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    int blockSize = 512;
+    double minRealtimeFactor = 0.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        if (arg == "--instances" && i + 1 < argc)
+            numInstances = juce::jlimit(1, maxInstances, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--seconds" && i + 1 < argc)
+            seconds = std::max(0.1, juce::String(argv[++i]).getDoubleValue());
+        else if (arg == "--threads" && i + 1 < argc)
+            numThreads = std::max(1, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--block" && i + 1 < argc)
+            blockSize = std::max(16, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--min-rtf" && i + 1 < argc)
+            minRealtimeFactor = juce::String(argv[++i]).getDoubleValue();
+        else
+        {
+            std::cerr << "Usage: InstanceStressTest [--instances N] [--seconds S] [--threads T] [--block N] [--min-rtf X]\n";
+            return 1;
+        }
+    }
+
+    // 2.5 s of vowel glides, looped; every instance reads it from its own offset.
+    std::vector<synthetic::Segment> segments;
+    for (const auto &vowel : synthetic::referenceVowels())
+        segments.push_back({vowel, 0.15f, 0.1f});
+    const auto program = synthetic::render(segments);
+    const int programLength = (int)program.samples.size();
+
+    // Instantiation: construct + prepareToPlay, one after the other like a session load
+    std::vector<Instance> instances((size_t)numInstances);
+    std::vector<double> instantiationMs;
+    instantiationMs.reserve((size_t)numInstances);
+
+    const double residentBefore = resident::residentBytes();
+    for (int n = 0; n < numInstances; ++n)
+    {
+        auto &instance = instances[(size_t)n];
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        instance.processor = std::make_unique<SpectralFormantMorpherAudioProcessor>();
+        instance.processor->prepareToPlay(sampleRate, blockSize);
+        instantiationMs.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0);
+
+        // Different targets per instance, as on different tracks
+        auto &apvts = instance.processor->getAPVTS();
+        setParameter(apvts, "FORMANT_1", 400.0f + 400.0f * (float)(n % 7) / 6.0f);
+        setParameter(apvts, "FORMANT_2", 1200.0f + 1400.0f * (float)(n % 11) / 10.0f);
+
+        const int numChannels = std::max(instance.processor->getTotalNumInputChannels(), instance.processor->getTotalNumOutputChannels());
+        instance.buffer.setSize(numChannels, blockSize);
+        instance.programOffset = (int)(((juce::int64)n * 997) % programLength);
+    }
+    const double residentAfterLoad = resident::residentBytes();
+
+    // Host callbacks: the calling thread and numThreads - 1 workers process the instances
+    std::atomic<int> nextInstance{0};
+    std::atomic<bool> quit{false};
+    juce::int64 position = 0;
+
+    auto processClaimed = [&]
+    {
+        for (int n = nextInstance.fetch_add(1); n < numInstances; n = nextInstance.fetch_add(1))
+        {
+            auto &instance = instances[(size_t)n];
+            for (int ch = 0; ch < instance.buffer.getNumChannels(); ++ch)
+            {
+                auto *samples = instance.buffer.getWritePointer(ch);
+                for (int s = 0; s < blockSize; ++s)
+                    samples[s] = program.samples[(size_t)((position + instance.programOffset + s) % programLength)];
+            }
+            instance.processor->processBlock(instance.buffer, instance.midi);
+        }
+    };
+
+    std::barrier callbackStart(numThreads);
+    std::barrier callbackDone(numThreads);
+    std::vector<std::thread> workers;
+    for (int t = 1; t < numThreads; ++t)
+        workers.emplace_back([&]
+                             {
+            for (;;)
+            {
+                callbackStart.arrive_and_wait();
+                if (quit.load())
+                    return;
+                processClaimed();
+                callbackDone.arrive_and_wait();
+            } });
+
+    const int numCallbacks = std::max(1, (int)(seconds * sampleRate) / blockSize);
+    const double deadlineMs = 1000.0 * (double)blockSize / sampleRate;
+    std::vector<double> callbackMs((size_t)numCallbacks);
+    int missedDeadlines = 0;
+    double totalSeconds = 0.0;
+
+    for (int c = 0; c < numCallbacks; ++c)
+    {
+        nextInstance.store(0);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        callbackStart.arrive_and_wait();
+        processClaimed();
+        callbackDone.arrive_and_wait();
+        const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        callbackMs[(size_t)c] = elapsed * 1000.0;
+        totalSeconds += elapsed;
+        if (elapsed * 1000.0 > deadlineMs)
+            ++missedDeadlines;
+
+        position += blockSize;
+    }
+
+    quit.store(true);
+    callbackStart.arrive_and_wait();
+    for (auto &worker : workers)
+        worker.join();
+
+    // After processing every instance has touched its working set.
+    const double residentAfterRun = resident::residentBytes();
+
+    const double audioSeconds = (double)numCallbacks * (double)blockSize / sampleRate;
+    const double realtimeFactor = totalSeconds > 0.0 ? audioSeconds / totalSeconds : 0.0;
+
+    double meanInstantiationMs = 0.0;
+    for (auto ms : instantiationMs)
+        meanInstantiationMs += ms / (double)numInstances;
+
+    for (auto &instance : instances)
+        instance.processor->releaseResources();
+
+    const bool passed = realtimeFactor >= minRealtimeFactor;
+
+    auto *instantiation = new juce::DynamicObject();
+    instantiation->setProperty("meanMs", meanInstantiationMs);
+    instantiation->setProperty("maxMs", *std::max_element(instantiationMs.begin(), instantiationMs.end()));
+    instantiation->setProperty("totalMs", meanInstantiationMs * (double)numInstances);
+
+    auto *memory = new juce::DynamicObject();
+    memory->setProperty("perInstanceLoadedMB", (residentAfterLoad - residentBefore) / (double)numInstances / (1024.0 * 1024.0));
+    memory->setProperty("perInstanceRunningMB", (residentAfterRun - residentBefore) / (double)numInstances / (1024.0 * 1024.0));
+    memory->setProperty("residentMB", residentAfterRun / (1024.0 * 1024.0));
+
+    auto *processing = new juce::DynamicObject();
+    processing->setProperty("realtimeFactor", realtimeFactor);
+    processing->setProperty("instancesAtRealtime", realtimeFactor * (double)numInstances);
+    processing->setProperty("deadlineMs", deadlineMs);
+    processing->setProperty("meanCallbackMs", 1000.0 * totalSeconds / (double)numCallbacks);
+    processing->setProperty("p99CallbackMs", percentile(callbackMs, 0.99));
+    processing->setProperty("maxCallbackMs", *std::max_element(callbackMs.begin(), callbackMs.end()));
+    processing->setProperty("missedDeadlines", missedDeadlines);
+    processing->setProperty("callbacks", numCallbacks);
+
+    auto *report = new juce::DynamicObject();
+    report->setProperty("instances", numInstances);
+    report->setProperty("threads", numThreads);
+    report->setProperty("sampleRate", sampleRate);
+    report->setProperty("blockSize", blockSize);
+    report->setProperty("instantiation", juce::var(instantiation));
+    report->setProperty("memory", juce::var(memory));
+    report->setProperty("processing", juce::var(processing));
+    report->setProperty("passed", passed);
+    std::cout << juce::JSON::toString(juce::var(report)) << "\n";
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <fstream>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+// Resident memory of the test process, shared by the soak and instance stress tests.
+
+namespace resident
+{
+    /** Resident set size in bytes, or 0 where it is not available. */
+    inline double residentBytes()
+    {
+#if defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        long pages = 0, residentPages = 0;
+        if (statm >> pages >> residentPages)
+            return (double)residentPages * (double)sysconf(_SC_PAGESIZE);
+#elif defined(__APPLE__)
+        mach_task_basic_info info{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+            return (double)info.resident_size;
+#endif
+        return 0.0;
+    }
+}
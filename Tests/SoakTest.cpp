@@ -0,0 +1,241 @@
+#include "../Source/PluginProcessor.h"
+#include "SyntheticVoice.h"
+#include "ResidentMemory.h"
+#include <iostream>
+
+// Long-duration soak of processBlock().
+//
+//   SoakTest [--minutes N] [--block N] [--smoke]
+//
+// Simulates N minutes (default 120) of a session at 44.1 kHz: synthetic vowel program material,
+// exponential fade-outs into digital silence, parameter automation sweeps, and engine / mode
+// changes. For every simulated minute it records the mean, 99.9th percentile and maximum
+// callback time, the denormals left in the SpectralProcessor state, and resident memory.
+// Prints JSON. Fails on any denormal, or when the last quarter of the run is slower than the
+// first (mean or 99.9th percentile), or when memory keeps growing after the first minute.
+// --smoke drops the timing trend, which needs hours to mean anything and a quiet machine: the short
+// ctest run only checks denormals and memory.
+
+namespace
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr double sceneSeconds = 20.0;
+    constexpr int numSceneModes = 6;
+
+    // Allowed drift of the last quarter over the first: ratio plus an absolute slack for timer noise.
+    constexpr double maxTimeRatio = 1.5;
+    constexpr double timeSlackMs = 0.1;
+    constexpr double maxMemoryGrowthBytes = 4.0 * 1024.0 * 1024.0;
+
+    void setParameter(juce::AudioProcessorValueTreeState &apvts, const juce::String &id, float value)
+    {
+        if (auto *parameter = apvts.getParameter(id))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    /**
+     * Modes cycled scene by scene so that every engine and analysis path is soaked:
+     * STFT, global scale + band envelope, sinusoidal, LPC, cepstral warp + pitch shift, zero latency.
+     */
+    void applySceneMode(juce::AudioProcessorValueTreeState &apvts, int scene)
+    {
+        const int mode = scene % numSceneModes;
+        setParameter(apvts, "ENGINE", mode == 2 ? 1.0f : mode == 3 ? 2.0f : 0.0f);
+        setParameter(apvts, "SCALE_MODE", mode == 1 ? 1.0f : 0.0f);
+        setParameter(apvts, "BAND_MODE", mode == 1 ? 1.0f : 0.0f);
+        setParameter(apvts, "CEPSTRAL_WARP", mode == 4 ? 1.0f : 0.0f);
+        setParameter(apvts, "ZERO_LATENCY", mode == 5 ? 1.0f : 0.0f);
+        if (mode != 4)
+            setParameter(apvts, "PITCH_SHIFT", 0.0f);
+    }
+
+    /** Input gain over a scene: program, 1 s exponential fade to -180 dB, 3 s of silence, program. */
+    float sceneGain(double position)
+    {
+        if (position < 8.0)
+            return 1.0f;
+        if (position < 9.0)
+            return (float)std::pow(10.0, -9.0 * (position - 8.0));
+        if (position < 12.0)
+            return 0.0f;
+        return 1.0f;
+    }
+
+    struct Window
+    {
+        double meanMs = 0.0;
+        double p999Ms = 0.0;
+        double maxMs = 0.0;
+        int denormals = 0;
+        double residentBytes = 0.0;
+    };
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0.0 : values[values.size() / 2];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int numMinutes = 120;
+    int blockSize = 512;
+    bool smoke = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        if (arg == "--minutes" && i + 1 < argc)
+            numMinutes = std::max(1, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--block" && i + 1 < argc)
+            blockSize = std::max(16, juce::String(argv[++i]).getIntValue());
+        else if (arg == "--smoke")
+            smoke = true;
+        else
+        {
+            std::cerr << "Usage: SoakTest [--minutes N] [--block N] [--smoke]\n";
+            return 1;
+        }
+    }
+
+    // 2.5 s of vowel glides, looped as the program material.
+    std::vector<synthetic::Segment> segments;
+    for (const auto &vowel : synthetic::referenceVowels())
+        segments.push_back({vowel, 0.15f, 0.1f});
+    const auto program = synthetic::render(segments);
+    const int programLength = (int)program.samples.size();
+
+    SpectralFormantMorpherAudioProcessor processor;
+    auto &apvts = processor.getAPVTS();
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    const int numChannels = std::max(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    const int blocksPerMinute = (int)(60.0 * sampleRate) / blockSize;
+    std::vector<double> callbackMs((size_t)blocksPerMinute);
+    std::vector<Window> windows;
+    windows.reserve((size_t)numMinutes);
+
+    juce::int64 position = 0;
+    int currentScene = -1;
+
+    for (int minute = 0; minute < numMinutes; ++minute)
+    {
+        Window window;
+
+        for (int block = 0; block < blocksPerMinute; ++block)
+        {
+            const double seconds = (double)position / sampleRate;
+            const int scene = (int)(seconds / sceneSeconds);
+            const double scenePosition = seconds - (double)scene * sceneSeconds;
+
+            if (scene != currentScene)
+            {
+                applySceneMode(apvts, scene);
+                currentScene = scene;
+            }
+
+            // Automation sweeps once the program material is back after the silence
+            if (scenePosition >= 12.0)
+            {
+                const double phase = juce::MathConstants<double>::twoPi * 0.1 * seconds;
+                setParameter(apvts, "FORMANT_1", (float)(600.0 + 250.0 * std::sin(phase)));
+                setParameter(apvts, "FORMANT_2", (float)(1600.0 + 700.0 * std::cos(0.7 * phase)));
+                if (currentScene % numSceneModes == 4)
+                    setParameter(apvts, "PITCH_SHIFT", (float)(5.0 * std::sin(0.5 * phase)));
+            }
+
+            const float gain = sceneGain(scenePosition);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto *samples = buffer.getWritePointer(ch);
+                for (int s = 0; s < blockSize; ++s)
+                    samples[s] = gain * program.samples[(size_t)((position + s) % programLength)];
+            }
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            const double ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+            callbackMs[(size_t)block] = ms;
+            window.meanMs += ms / (double)blocksPerMinute;
+            window.maxMs = std::max(window.maxMs, ms);
+            window.denormals += processor.getSpectralContexts().countDenormals();
+
+            position += blockSize;
+        }
+
+        const auto p999 = callbackMs.begin() + (std::ptrdiff_t)((double)(blocksPerMinute - 1) * 0.999);
+        std::nth_element(callbackMs.begin(), p999, callbackMs.end());
+        window.p999Ms = *p999;
+        window.residentBytes = resident::residentBytes();
+        windows.push_back(window);
+    }
+
+    processor.releaseResources();
+
+    // Trends: the first minute is warm-up; compare the medians of the first and last quarters.
+    juce::StringArray failures;
+
+    int totalDenormals = 0;
+    for (const auto &window : windows)
+        totalDenormals += window.denormals;
+    if (totalDenormals > 0)
+        failures.add("denormals in processor state");
+
+    const int numMeasured = (int)windows.size() - 1;
+    if (numMeasured >= 2 && !smoke)
+    {
+        const int quarter = std::max(1, numMeasured / 4);
+        std::vector<double> firstMean, lastMean, firstWorst, lastWorst;
+        for (int i = 0; i < quarter; ++i)
+        {
+            const auto &first = windows[(size_t)(1 + i)];
+            const auto &last = windows[windows.size() - 1 - (size_t)i];
+            firstMean.push_back(first.meanMs);
+            lastMean.push_back(last.meanMs);
+            firstWorst.push_back(first.p999Ms);
+            lastWorst.push_back(last.p999Ms);
+        }
+
+        if (median(lastMean) > median(firstMean) * maxTimeRatio + timeSlackMs)
+            failures.add("mean callback time drifts upward");
+        if (median(lastWorst) > median(firstWorst) * maxTimeRatio + timeSlackMs)
+            failures.add("worst-case callback time drifts upward");
+    }
+
+    if (numMeasured >= 2)
+    {
+        const double baseline = windows[1].residentBytes;
+        if (baseline > 0.0 && windows.back().residentBytes - baseline > maxMemoryGrowthBytes)
+            failures.add("resident memory grows");
+    }
+
+    const bool passed = failures.isEmpty();
+
+    juce::Array<juce::var> minutes;
+    for (const auto &window : windows)
+    {
+        auto *entry = new juce::DynamicObject();
+        entry->setProperty("meanMs", window.meanMs);
+        entry->setProperty("p999Ms", window.p999Ms);
+        entry->setProperty("maxMs", window.maxMs);
+        entry->setProperty("denormals", window.denormals);
+        entry->setProperty("residentMB", window.residentBytes / (1024.0 * 1024.0));
+        minutes.add(juce::var(entry));
+    }
+
+    auto *report = new juce::DynamicObject();
+    report->setProperty("sampleRate", sampleRate);
+    report->setProperty("blockSize", blockSize);
+    report->setProperty("timingChecked", !smoke);
+    report->setProperty("minutes", minutes);
+    report->setProperty("passed", passed);
+    report->setProperty("failures", failures.joinIntoString(", "));
+    std::cout << juce::JSON::toString(juce::var(report)) << "\n";
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cmath>
+#include <vector>
+
+/**
+ * Reproducible voice-like test signals with known formants.
+ *
+ * A Rosenberg glottal pulse train (differentiated for lip radiation) with period jitter,
+ * vibrato and flow-modulated breath noise goes through a cascade of second-order formant
+ * resonators. The resonators follow a piecewise-linear formant track, and the track is kept
+ * as ground truth for the accuracy tests and the benchmark.
+ */
+namespace synthetic
+{
+    static constexpr int numFormants = 15;
+    using Formants = std::array<float, numFormants>;
+
+    struct Vowel
+    {
+        const char *name = "";
+        Formants formantsHz{};
+        Formants bandwidthsHz{};
+    };
+
+    /**
+     * F1-F3 as given; F4 and up follow the neutral 17.5 cm tube ((2n - 1) * 500 Hz),
+     * kept above F3. Bandwidths grow with frequency as in natural speech.
+     */
+    inline Vowel makeVowel(const char *name, float f1, float f2, float f3)
+    {
+        Vowel vowel;
+        vowel.name = name;
+        vowel.formantsHz[0] = f1;
+        vowel.formantsHz[1] = f2;
+        vowel.formantsHz[2] = f3;
+
+        for (int i = 3; i < numFormants; ++i)
+            vowel.formantsHz[(size_t)i] = std::max((float)(2 * i + 1) * 500.0f, vowel.formantsHz[(size_t)i - 1] + 600.0f);
+
+        for (int i = 0; i < numFormants; ++i)
+            vowel.bandwidthsHz[(size_t)i] = 50.0f + 0.04f * vowel.formantsHz[(size_t)i];
+
+        return vowel;
+    }
+
+    /** Average adult male vowels (Peterson & Barney, 1952). */
+    inline std::vector<Vowel> referenceVowels()
+    {
+        return {
+            makeVowel("i", 270.0f, 2290.0f, 3010.0f),
+            makeVowel("I", 390.0f, 1990.0f, 2550.0f),
+            makeVowel("E", 530.0f, 1840.0f, 2480.0f),
+            makeVowel("ae", 660.0f, 1720.0f, 2410.0f),
+            makeVowel("A", 730.0f, 1090.0f, 2440.0f),
+            makeVowel("O", 570.0f, 840.0f, 2410.0f),
+            makeVowel("U", 440.0f, 1020.0f, 2240.0f),
+            makeVowel("u", 300.0f, 870.0f, 2240.0f),
+            makeVowel("V", 640.0f, 1190.0f, 2390.0f),
+            makeVowel("3", 490.0f, 1350.0f, 1690.0f),
+        };
+    }
+
+    struct VoiceSettings
+    {
+        double sampleRate = 44100.0;
+        float f0Hz = 120.0f;
+        float jitter = 0.01f;            // Relative period deviation (uniform, +-)
+        float vibratoCents = 20.0f;      // Vibrato depth
+        float vibratoRateHz = 5.5f;
+        float breathiness = 0.05f;       // Breath noise level relative to the pulse
+        float level = 0.5f;              // Output peak
+        juce::int64 seed = 1;
+    };
+
+    /** One vowel held for `holdSeconds`, reached by a linear glide over `glideSeconds`. */
+    struct Segment
+    {
+        Vowel vowel;
+        float holdSeconds = 0.3f;
+        float glideSeconds = 0.0f;
+    };
+
+    struct Utterance
+    {
+        double sampleRate = 44100.0;
+        std::vector<float> samples;
+
+        /** Ground truth: formants at every trackHop samples (use formantsAt() for any sample). */
+        static constexpr int trackHop = 32;
+        std::vector<Formants> trackHz;
+
+        Formants formantsAt(int sample) const
+        {
+            if (trackHz.empty())
+                return {};
+
+            const float position = juce::jlimit(0.0f, (float)(trackHz.size() - 1), (float)sample / (float)trackHop);
+            const auto index = (size_t)position;
+            const auto next = std::min(index + 1, trackHz.size() - 1);
+            const float frac = position - (float)index;
+
+            Formants result{};
+            for (size_t i = 0; i < (size_t)numFormants; ++i)
+                result[i] = trackHz[index][i] + frac * (trackHz[next][i] - trackHz[index][i]);
+            return result;
+        }
+
+        juce::AudioBuffer<float> toBuffer() const
+        {
+            juce::AudioBuffer<float> buffer(1, (int)samples.size());
+            std::copy(samples.begin(), samples.end(), buffer.getWritePointer(0));
+            return buffer;
+        }
+    };
+
+    inline Utterance render(const std::vector<Segment> &segments, const VoiceSettings &settings = {})
+    {
+        Utterance utterance;
+        utterance.sampleRate = settings.sampleRate;
+
+        const double sr = settings.sampleRate;
+        if (segments.empty())
+            return utterance;
+
+        // Piecewise-linear formant/bandwidth targets over time.
+        std::vector<double> times;
+        std::vector<const Vowel *> points;
+        double t = 0.0;
+        for (const auto &segment : segments)
+        {
+            t += segment.glideSeconds;
+            times.push_back(t);
+            points.push_back(&segment.vowel);
+            t += segment.holdSeconds;
+            times.push_back(t);
+            points.push_back(&segment.vowel);
+        }
+
+        const int numSamples = (int)(t * sr);
+        const int numTrack = numSamples / Utterance::trackHop + 1;
+        utterance.samples.assign((size_t)numSamples, 0.0f);
+        utterance.trackHz.resize((size_t)numTrack);
+
+        std::vector<Formants> bandwidths((size_t)numTrack);
+        size_t point = 0;
+        for (int n = 0; n < numTrack; ++n)
+        {
+            const double time = (double)(n * Utterance::trackHop) / sr;
+            while (point + 1 < times.size() && times[point + 1] <= time)
+                ++point;
+
+            const Vowel &a = *points[point];
+            const Vowel &b = *points[std::min(point + 1, points.size() - 1)];
+            const double span = point + 1 < times.size() ? times[point + 1] - times[point] : 0.0;
+            const float frac = span > 0.0 ? (float)juce::jlimit(0.0, 1.0, (time - times[point]) / span) : 0.0f;
+
+            for (size_t i = 0; i < (size_t)numFormants; ++i)
+            {
+                utterance.trackHz[(size_t)n][i] = a.formantsHz[i] + frac * (b.formantsHz[i] - a.formantsHz[i]);
+                bandwidths[(size_t)n][i] = a.bandwidthsHz[i] + frac * (b.bandwidthsHz[i] - a.bandwidthsHz[i]);
+            }
+        }
+
+        juce::Random random(settings.seed);
+
+        // Glottal source: Rosenberg flow pulse per period, differentiated.
+        constexpr double openQuotient = 0.4, closingQuotient = 0.16;
+        const double pulsePeak = juce::MathConstants<double>::halfPi / closingQuotient;
+        double phase = 0.0;
+        double periodScale = 1.0;
+        double lastFlow = 0.0;
+
+        // Resonator cascade (unity gain at DC), coefficients refreshed every trackHop samples.
+        struct Resonator
+        {
+            double a = 0.0, b = 0.0, c = 0.0, y1 = 0.0, y2 = 0.0;
+        };
+        std::array<Resonator, numFormants> resonators{};
+        const double nyquistLimit = 0.45 * sr;
+
+        double peak = 0.0;
+        std::vector<double> output((size_t)numSamples);
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            if (s % Utterance::trackHop == 0)
+            {
+                const auto n = (size_t)(s / Utterance::trackHop);
+                for (size_t i = 0; i < (size_t)numFormants; ++i)
+                {
+                    auto &r = resonators[i];
+                    const double hz = utterance.trackHz[n][i];
+                    if (hz >= nyquistLimit)
+                    {
+                        r.a = 1.0;
+                        r.b = r.c = 0.0;
+                        continue;
+                    }
+
+                    const double radius = std::exp(-juce::MathConstants<double>::pi * bandwidths[n][i] / sr);
+                    r.c = -radius * radius;
+                    r.b = 2.0 * radius * std::cos(juce::MathConstants<double>::twoPi * hz / sr);
+                    r.a = 1.0 - r.b - r.c;
+                }
+            }
+
+            const double time = (double)s / sr;
+            const double vibrato = std::pow(2.0, settings.vibratoCents / 1200.0 * std::sin(juce::MathConstants<double>::twoPi * settings.vibratoRateHz * time));
+            phase += (double)settings.f0Hz * vibrato / (sr * periodScale);
+            if (phase >= 1.0)
+            {
+                phase -= 1.0;
+                periodScale = 1.0 + settings.jitter * (2.0 * random.nextDouble() - 1.0);
+            }
+
+            double flow = 0.0;
+            if (phase < openQuotient)
+                flow = 0.5 * (1.0 - std::cos(juce::MathConstants<double>::pi * phase / openQuotient));
+            else if (phase < openQuotient + closingQuotient)
+                flow = std::cos(juce::MathConstants<double>::halfPi * (phase - openQuotient) / closingQuotient);
+
+            // Flow derivative per period (peak pulsePeak at closure) plus noise that is
+            // stronger while the glottis is open.
+            const double noise = settings.breathiness * pulsePeak * (0.5 + flow) * (2.0 * random.nextDouble() - 1.0);
+            double x = (flow - lastFlow) * sr / (double)settings.f0Hz + noise;
+            lastFlow = flow;
+
+            for (auto &r : resonators)
+            {
+                const double y = r.a * x + r.b * r.y1 + r.c * r.y2;
+                r.y2 = r.y1;
+                r.y1 = y;
+                x = y;
+            }
+
+            output[(size_t)s] = x;
+            peak = std::max(peak, std::abs(x));
+        }
+
+        const double gain = peak > 0.0 ? settings.level / peak : 0.0;
+        for (int s = 0; s < numSamples; ++s)
+            utterance.samples[(size_t)s] = (float)(gain * output[(size_t)s]);
+
+        return utterance;
+    }
+
+    /** A single held vowel. */
+    inline Utterance renderVowel(const Vowel &vowel, float seconds, const VoiceSettings &settings = {})
+    {
+        return render({{vowel, seconds, 0.0f}}, settings);
+    }
+
+} // namespace synthetic
@@ -65,5 +65,31 @@ int main()
     if (pass) std::cout << "Test 2 (Piecewise) Passed\n";
     else return 1;
 
+    // Test Case 3: Closed-form global scaling
+    // ratio 1.25 -> map[dst] = dst / 1.25, clamped to the last bin.
+    warper.calculateScaleWarpMap(numBins, 1.25f);
+    map = warper.getWarpMap();
+
+    pass = true;
+
+    if (std::abs(map[50] - 40.0f) > 0.001f)
+    {
+        pass = false;
+        std::cout << "Test 3 Fail: map[50] expected 40.0, got " << map[50] << "\n";
+    }
+
+    // Scaling down reads beyond Nyquist for high output bins: must clamp.
+    warper.calculateScaleWarpMap(numBins, 0.5f);
+    map = warper.getWarpMap();
+
+    if (std::abs(map[99] - 99.0f) > 0.001f || std::abs(map[20] - 40.0f) > 0.001f)
+    {
+        pass = false;
+        std::cout << "Test 3 Fail: ratio 0.5 expected map[20]=40, map[99]=99, got " << map[20] << ", " << map[99] << "\n";
+    }
+
+    if (pass) std::cout << "Test 3 (Global Scale) Passed\n";
+    else return 1;
+
     return 0;
 }
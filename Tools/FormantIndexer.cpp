@@ -0,0 +1,63 @@
+#include "../Source/FormantLibraryBuilder.h"
+#include <iostream>
+
+// Command line front end for the formant profile library.
+//
+//   FormantIndexer <folder> [indexFile]          analyze folder -> index
+//   FormantIndexer --query <indexFile> F1 F2 ... print nearest references
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && juce::String(argv[1]) == "--query")
+    {
+        dsp::FormantProfileIndex index;
+        if (!index.readFromFile(juce::File::getCurrentWorkingDirectory().getChildFile(argv[2])))
+        {
+            std::cerr << "Cannot read index " << argv[2] << "\n";
+            return 1;
+        }
+
+        std::array<float, dsp::SpectralProcessor::numFormants> query{};
+        for (size_t i = 0; i < query.size(); ++i)
+            query[i] = (int)i + 3 < argc ? juce::String(argv[i + 3]).getFloatValue() : 500.0f + 1000.0f * (float)i;
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        const auto matches = index.findNearest(query, 5);
+        const auto elapsedMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+        for (const auto &m : matches)
+            std::cout << index.getProfile(m.index).name << "\t" << m.distance << "\n";
+
+        std::cout << "(" << index.size() << " profiles, " << elapsedMs << " ms)\n";
+        return 0;
+    }
+
+    if (argc < 2)
+    {
+        std::cerr << "Usage: FormantIndexer <folder> [indexFile]\n"
+                  << "       FormantIndexer --query <indexFile> F1 F2 ...\n";
+        return 1;
+    }
+
+    const auto folder = juce::File::getCurrentWorkingDirectory().getChildFile(argv[1]);
+    const auto indexFile = argc >= 3 ? juce::File::getCurrentWorkingDirectory().getChildFile(argv[2])
+                                     : folder.getChildFile(dsp::FormantProfileIndex::defaultFileName);
+
+    FormantLibraryBuilder builder;
+    dsp::FormantProfileIndex index;
+
+    const int added = builder.buildFromFolder(folder, index, [](int done, int total)
+                                              {
+        std::cout << "\r" << done << " / " << total << std::flush;
+        return true; });
+
+    std::cout << "\n";
+
+    if (added <= 0 || !index.writeToFile(indexFile))
+    {
+        std::cerr << "No profiles written.\n";
+        return 1;
+    }
+
+    std::cout << added << " profiles -> " << indexFile.getFullPathName() << "\n";
+    return 0;
+}
@@ -0,0 +1,485 @@
+#include "../Source/DSP/SpectralProcessor.h"
+#include "../Tests/SyntheticVoice.h"
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Per-stage DSP benchmark on the synthetic vowel corpus. Prints one JSON object to stdout.
+//
+//   SpectralBenchmark [--hops N] [--counters]
+//
+// --counters reads Linux hardware counters (perf_event_open) around every stage. When they
+// are not available (other OS, perf_event_paranoid, containers, VMs) the timings are still
+// reported and "counters" says why the counter fields are missing.
+//
+// "firstCallback" times prepare() and the first process() callbacks of a freshly built
+// processor per engine, with the warm start (SpectralProcessor::setPrepareWarmup()) off and on,
+// starting from evicted caches: the spike a host sees when playback starts.
+
+namespace
+{
+    /** One set of hardware counters, enabled around a measured region. */
+    class PerfCounters
+    {
+    public:
+        enum Counter
+        {
+            cycles,
+            instructions,
+            l1dMisses,
+            llcMisses,
+            branchMisses,
+            numCounters
+        };
+
+        static const char *getName(int counter)
+        {
+            static const char *names[numCounters] = {"cycles", "instructions", "l1dMisses", "llcMisses", "branchMisses"};
+            return names[counter];
+        }
+
+        bool open()
+        {
+#if defined(__linux__)
+            const auto cache = [](unsigned long long id, unsigned long long op, unsigned long long result)
+            { return id | (op << 8) | (result << 16); };
+
+            const std::pair<unsigned int, unsigned long long> configs[numCounters] = {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+                {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+            for (int i = 0; i < numCounters; ++i)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = configs[i].first;
+                attr.config = configs[i].second;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+
+                fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+                if (fds[i] < 0)
+                {
+                    error = juce::String("perf_event_open (") + getName(i) + "): " + std::strerror(errno);
+                    close();
+                    return false;
+                }
+            }
+
+            return true;
+#else
+            error = "hardware counters need Linux perf_event_open";
+            return false;
+#endif
+        }
+
+        void close()
+        {
+#if defined(__linux__)
+            for (auto &fd : fds)
+            {
+                if (fd >= 0)
+                    ::close(fd);
+                fd = -1;
+            }
+#endif
+        }
+
+        ~PerfCounters() { close(); }
+
+        bool isOpen() const { return fds[0] >= 0; }
+        const juce::String &getError() const { return error; }
+
+        void start()
+        {
+#if defined(__linux__)
+            for (auto fd : fds)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        void stop(std::array<double, numCounters> &values)
+        {
+#if defined(__linux__)
+            for (int i = 0; i < numCounters; ++i)
+            {
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+                unsigned long long count = 0;
+                values[(size_t)i] = read(fds[i], &count, sizeof(count)) == (ssize_t)sizeof(count) ? (double)count : 0.0;
+            }
+#else
+            values.fill(0.0);
+#endif
+        }
+
+    private:
+        int fds[numCounters] = {-1, -1, -1, -1, -1};
+        juce::String error;
+    };
+
+    /** The synthetic vowel corpus, gliding from vowel to vowel, at least numSamples long. */
+    synthetic::Utterance makeTestSignal(double sampleRate, int numSamples)
+    {
+        synthetic::VoiceSettings settings;
+        settings.sampleRate = sampleRate;
+
+        const auto vowels = synthetic::referenceVowels();
+        std::vector<synthetic::Segment> segments;
+        double seconds = 0.0;
+        for (size_t i = 0; seconds * sampleRate < (double)numSamples + 1.0; ++i)
+        {
+            segments.push_back({vowels[i % vowels.size()], 0.15f, 0.1f});
+            seconds += 0.25;
+        }
+
+        return synthetic::render(segments, settings);
+    }
+}
+
+/** Reaches into SpectralProcessor for the per-stage measurements (declared a friend there). */
+class SpectralProcessorBenchmark
+{
+public:
+    SpectralProcessorBenchmark(int numHopsToRun, bool useCounters)
+        : numHops(std::max(1, numHopsToRun))
+    {
+        if (useCounters && !counters.open())
+            std::cerr << counters.getError() << "\n";
+    }
+
+    juce::var run()
+    {
+        constexpr double sampleRate = 44100.0;
+        constexpr int fftOrder = dsp::SpectralProcessor::defaultFftOrder;
+        constexpr int fftSize = 1 << fftOrder;
+        constexpr int hopSize = fftSize / 4;
+        constexpr int numBins = fftSize / 2 + 1;
+        constexpr int numFrames = 256; // Distinct frames (about 1.5 s of vowels), cycled through by every stage
+
+        const auto utterance = makeTestSignal(sampleRate, fftSize + hopSize * (numFrames + numHops));
+        const auto signal = utterance.toBuffer();
+
+        dsp::SpectralProcessor processor;
+        processor.prepare({sampleRate, (juce::uint32)hopSize, 1});
+
+        // Inputs of every stage, prepared outside the measured regions.
+        std::vector<std::vector<float>> frames, magnitudes, envelopes, cepstra;
+        std::vector<std::vector<dsp::WarpingPoint>> points;
+        std::array<double, 3> indexErrorHz{}, nearestErrorHz{};
+        {
+            juce::dsp::FFT fft(fftOrder);
+            juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+            dsp::EnvelopeExtractor extractor;
+            extractor.prepare(fftSize);
+
+            for (int f = 0; f < numFrames; ++f)
+            {
+                std::vector<float> frame((size_t)fftSize * 2, 0.0f);
+                std::copy(signal.getReadPointer(0) + f * hopSize, signal.getReadPointer(0) + f * hopSize + fftSize, frame.begin());
+                window.multiplyWithWindowingTable(frame.data(), (size_t)fftSize);
+                frames.push_back(frame);
+
+                fft.performRealOnlyForwardTransform(frame.data());
+                std::vector<float> magnitude((size_t)numBins);
+                for (int k = 0; k < numBins; ++k)
+                    magnitude[(size_t)k] = std::hypot(frame[(size_t)k * 2], frame[(size_t)k * 2 + 1]);
+                magnitudes.push_back(magnitude);
+
+                std::vector<float> envelope((size_t)numBins);
+                extractor.process(magnitude, envelope);
+                envelopes.push_back(envelope);
+                cepstra.push_back(extractor.getEnvelopeCepstrum());
+
+                std::array<float, dsp::SpectralProcessor::numFormants> bins{};
+                processor.detectFormants(envelope, extractor.getEnvelopeCepstrum(), sampleRate, bins);
+
+                // Against the ground truth at the frame centre (see Tests/FormantAccuracyTest.cpp)
+                const auto trueHz = utterance.formantsAt(f * hopSize + fftSize / 2);
+                const float hzPerBin = (float)sampleRate / (float)fftSize;
+                for (size_t i = 0; i < indexErrorHz.size(); ++i)
+                {
+                    indexErrorHz[i] += std::abs(bins[i] * hzPerBin - trueHz[i]) / numFrames;
+
+                    float nearest = std::numeric_limits<float>::max();
+                    for (float bin : bins)
+                        nearest = std::min(nearest, std::abs(bin * hzPerBin - trueHz[i]));
+                    nearestErrorHz[i] += nearest / numFrames;
+                }
+
+                std::vector<dsp::WarpingPoint> framePoints{{0.0f, 0.0f}};
+                for (float bin : bins)
+                    framePoints.push_back({bin, bin * 1.1f});
+                framePoints.push_back({(float)(numBins - 1), (float)(numBins - 1)});
+                points.push_back(framePoints);
+            }
+        }
+
+        juce::Array<juce::var> stages;
+
+        {
+            juce::dsp::FFT fft(fftOrder);
+            std::vector<float> buffer((size_t)fftSize * 2);
+            stages.add(measure("fft", [&](int hop)
+                               {
+                const auto &frame = frames[(size_t)(hop % numFrames)];
+                std::copy(frame.begin(), frame.end(), buffer.begin());
+                fft.performRealOnlyForwardTransform(buffer.data()); }));
+        }
+
+        {
+            // Zero-padded analysis spectrum: the input-pruned transform (given the unpadded
+            // magnitudes the hop already has) against a plain FFT of the padded frame.
+            struct PaddedStage
+            {
+                int padding;
+                const char *pruned;
+                const char *plain;
+            };
+            for (const auto &stage : {PaddedStage{2, "paddedSpectrum2x", "paddedSpectrumPlainFft2x"},
+                                      PaddedStage{4, "paddedSpectrum4x", "paddedSpectrumPlainFft4x"}})
+            {
+                const int paddedBins = fftSize * stage.padding / 2 + 1;
+                std::vector<float> padded((size_t)paddedBins);
+
+                dsp::ZeroPaddedSpectrum prunedSpectrum;
+                prunedSpectrum.prepare(fftOrder, stage.padding);
+                stages.add(measure(stage.pruned, [&](int hop)
+                                   {
+                    const auto f = (size_t)(hop % numFrames);
+                    prunedSpectrum.process(frames[f].data(), magnitudes[f], padded); }));
+
+                juce::dsp::FFT paddedFft(fftOrder + (stage.padding == 2 ? 1 : 2));
+                std::vector<float> buffer((size_t)(fftSize * stage.padding * 2));
+                stages.add(measure(stage.plain, [&](int hop)
+                                   {
+                    const auto &frame = frames[(size_t)(hop % numFrames)];
+                    std::fill(buffer.begin(), buffer.end(), 0.0f);
+                    std::copy(frame.begin(), frame.begin() + fftSize, buffer.begin());
+                    paddedFft.performRealOnlyForwardTransform(buffer.data());
+                    for (int k = 0; k < paddedBins; ++k)
+                        padded[(size_t)k] = std::hypot(buffer[(size_t)k * 2], buffer[(size_t)k * 2 + 1]); }));
+            }
+        }
+
+        {
+            dsp::EnvelopeExtractor extractor;
+            extractor.prepare(fftSize);
+            std::vector<float> envelope((size_t)numBins);
+            stages.add(measure("envelopeExtractor", [&](int hop)
+                               { extractor.process(magnitudes[(size_t)(hop % numFrames)], envelope); }));
+        }
+
+        {
+            std::array<float, dsp::SpectralProcessor::numFormants> bins{};
+            stages.add(measure("detectFormants", [&](int hop)
+                               {
+                const auto f = (size_t)(hop % numFrames);
+                processor.detectFormants(envelopes[f], cepstra[f], sampleRate, bins); }));
+
+        }
+
+        {
+            dsp::FormantWarper warper;
+            std::vector<float> warped((size_t)numBins);
+            stages.add(measure("formantWarper", [&](int hop)
+                               {
+                const auto f = (size_t)(hop % numFrames);
+                warper.calculateWarpMap(numBins, points[f]);
+                warper.process(envelopes[f], warped); }));
+        }
+
+        {
+            // One process() call of hopSize samples runs exactly one analysis/resynthesis hop.
+            juce::AudioBuffer<float> block(1, hopSize);
+            stages.add(measure("hop", [&](int hop)
+                               {
+                block.copyFrom(0, 0, signal, 0, fftSize + hop * hopSize, hopSize);
+                juce::dsp::AudioBlock<float> audioBlock(block);
+                processor.process(juce::dsp::ProcessContextReplacing<float>(audioBlock)); }));
+        }
+
+        auto *result = new juce::DynamicObject();
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("fftSize", fftSize);
+        result->setProperty("hopSize", hopSize);
+        result->setProperty("hops", numHops);
+        // true, false (not requested) or the reason they could not be opened
+        result->setProperty("counters", counters.isOpen() ? juce::var(true)
+                                        : counters.getError().isEmpty() ? juce::var(false)
+                                                                        : juce::var(counters.getError()));
+        result->setProperty("stages", stages);
+        result->setProperty("firstCallback", measureFirstCallbacks(signal, sampleRate));
+
+        // Mean F1-F3 error of detectFormants() over the frames: index-wise and nearest peak
+        auto *accuracy = new juce::DynamicObject();
+        for (size_t i = 0; i < indexErrorHz.size(); ++i)
+        {
+            accuracy->setProperty("F" + juce::String((int)i + 1) + "IndexErrorHz", indexErrorHz[i]);
+            accuracy->setProperty("F" + juce::String((int)i + 1) + "NearestErrorHz", nearestErrorHz[i]);
+        }
+        result->setProperty("accuracy", juce::var(accuracy));
+        return juce::var(result);
+    }
+
+private:
+    juce::var measureFirstCallbacks(const juce::AudioBuffer<float> &signal, double sampleRate)
+    {
+        constexpr int blockSize = 512;
+        constexpr int numTrials = 7;     // Median of these, the modes alternating
+        constexpr int numCallbacks = 64; // Steady state: the median of the callbacks after the first
+
+        struct EngineCase
+        {
+            dsp::SpectralProcessor::Engine engine;
+            const char *name;
+        };
+        const EngineCase engines[] = {{dsp::SpectralProcessor::Engine::stft, "stft"},
+                                      {dsp::SpectralProcessor::Engine::sinusoidal, "sinusoidal"},
+                                      {dsp::SpectralProcessor::Engine::lpc, "lpc"},
+                                      {dsp::SpectralProcessor::Engine::multiResolution, "multiResolution"}};
+
+        // Larger than the last level cache, written between trials to start them cold.
+        std::vector<char> evictionBuffer((size_t)64 * 1024 * 1024);
+        const auto evictCaches = [&evictionBuffer]
+        {
+            for (size_t i = 0; i < evictionBuffer.size(); i += 64)
+                evictionBuffer[i] = (char)(evictionBuffer[i] + 1);
+        };
+
+        const auto median = [](std::vector<double> values)
+        {
+            std::nth_element(values.begin(), values.begin() + (std::ptrdiff_t)(values.size() / 2), values.end());
+            return values[values.size() / 2];
+        };
+
+        juce::Array<juce::var> results;
+        juce::AudioBuffer<float> block(1, blockSize);
+        for (const auto &engineCase : engines)
+        {
+            std::vector<double> prepareMs[2], firstUs[2], steadyUs[2];
+            size_t lockedBytes[2] = {0, 0};
+
+            for (int trial = 0; trial < numTrials; ++trial)
+                for (int warm = 0; warm < 2; ++warm)
+                {
+                    evictCaches();
+
+                    auto startTicks = juce::Time::getHighResolutionTicks();
+                    auto processor = std::make_unique<dsp::SpectralProcessor>();
+                    processor->setEngine(engineCase.engine);
+                    processor->setPrepareWarmup(warm == 1);
+                    processor->prepare({sampleRate, (juce::uint32)blockSize, 1});
+                    prepareMs[warm].push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e3);
+                    lockedBytes[warm] = processor->getLockedBytes();
+
+                    std::vector<double> callbackUs;
+                    for (int c = 0; c < numCallbacks; ++c)
+                    {
+                        block.copyFrom(0, 0, signal, 0, c * blockSize, blockSize);
+                        juce::dsp::AudioBlock<float> audioBlock(block);
+
+                        startTicks = juce::Time::getHighResolutionTicks();
+                        processor->process(juce::dsp::ProcessContextReplacing<float>(audioBlock));
+                        callbackUs.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+                    }
+
+                    firstUs[warm].push_back(callbackUs.front());
+                    steadyUs[warm].push_back(median({callbackUs.begin() + 1, callbackUs.end()}));
+                }
+
+            auto *entry = new juce::DynamicObject();
+            entry->setProperty("engine", engineCase.name);
+            entry->setProperty("blockSize", blockSize);
+            for (int warm = 0; warm < 2; ++warm)
+            {
+                auto *mode = new juce::DynamicObject();
+                mode->setProperty("prepareMs", median(prepareMs[warm]));
+                mode->setProperty("firstCallbackUs", median(firstUs[warm]));
+                mode->setProperty("steadyCallbackUs", median(steadyUs[warm]));
+                mode->setProperty("lockedKB", (double)lockedBytes[warm] / 1024.0);
+                entry->setProperty(warm == 1 ? "warmStart" : "coldStart", juce::var(mode));
+            }
+            results.add(juce::var(entry));
+        }
+
+        return results;
+    }
+
+    template <typename Stage>
+    juce::var measure(const char *name, Stage &&stage)
+    {
+        // Warm caches and branch predictors once before measuring.
+        for (int hop = 0; hop < std::min(numHops, 64); ++hop)
+            stage(hop);
+
+        std::array<double, PerfCounters::numCounters> values{};
+        if (counters.isOpen())
+            counters.start();
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        for (int hop = 0; hop < numHops; ++hop)
+            stage(hop);
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        if (counters.isOpen())
+            counters.stop(values);
+
+        auto *entry = new juce::DynamicObject();
+        entry->setProperty("name", name);
+        entry->setProperty("nsPerHop", elapsed * 1.0e9 / (double)numHops);
+
+        if (counters.isOpen())
+        {
+            for (int i = 0; i < PerfCounters::numCounters; ++i)
+                entry->setProperty(juce::String(PerfCounters::getName(i)) + "PerHop", values[(size_t)i] / (double)numHops);
+
+            const double cyclesCount = values[PerfCounters::cycles];
+            entry->setProperty("ipc", cyclesCount > 0.0 ? values[PerfCounters::instructions] / cyclesCount : 0.0);
+        }
+
+        return juce::var(entry);
+    }
+
+    int numHops;
+    PerfCounters counters;
+};
+
+int main(int argc, char *argv[])
+{
+    int numHops = 2000;
+    bool useCounters = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        if (arg == "--counters")
+            useCounters = true;
+        else if (arg == "--hops" && i + 1 < argc)
+            numHops = juce::String(argv[++i]).getIntValue();
+        else
+        {
+            std::cerr << "Usage: SpectralBenchmark [--hops N] [--counters]\n";
+            return 1;
+        }
+    }
+
+    SpectralProcessorBenchmark benchmark(numHops, useCounters);
+    std::cout << juce::JSON::toString(benchmark.run()) << "\n";
+    return 0;
+}